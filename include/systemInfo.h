@@ -44,7 +44,23 @@
 #define RIGHT_MOTOR_ENCODER_B_PIN A7
 #define RIGHT_MOTOR_ROTATION_INVERTED true
 
-#define DEFAULT_DRIVE_SPEED 35
+// IMU
+// Whether the board is mounted upside down, flipping the direction of yaw.
+#define IMU_YAW_INVERTED false
+
+// The default speeds of the robot, in millimeters per second when driving and
+// degrees per second when turning on the spot.
+#define DEFAULT_DRIVE_SPEED 250
+#define DEFAULT_TURN_SPEED 120
+
+// The distance in millimeters to hold between the centre of the robot and the
+// wall on its left while wall following.
+#define WALL_FOLLOW_DISTANCE 130
+
+// The distance in millimeters from the centre of the robot to the wall in
+// front of it to stop at while wall following, the braking governor slows the
+// robot down so that it can always stop here.
+#define WALL_STOP_DISTANCE 185
 #define INITIAL_ANGLE -90
 
 // Shift registers
@@ -81,6 +97,10 @@
 #define FRONT_RIGHT_INFRARED_INDEX 2
 #define FRONT_RIGHT_INFRARED_FORWARD_DISTANCE 64
 
+// The distance in millimeters between the front left and front right infrared
+// sensors.
+#define FRONT_INFRARED_SEPARATION 50
+
 #define RIGHT_INFRARED_INDEX 3
 #define RIGHT_INFRARED_FORWARD_DISTANCE 85
 
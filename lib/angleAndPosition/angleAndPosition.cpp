@@ -9,43 +9,127 @@
 
 #include "angleAndPosition.h"
 
-// The lower bound of the angle wrap.
-#define ANGLE_LOWER_BOUND -179
+// The number of binary angle units in a quarter of a rotation.
+#define BINARY_ANGLE_PER_QUARTER 0x4000
+
+// The number of segments that the quarter wave sine table is split into.
+#define SINE_TABLE_SEGMENTS 64
+
+// The number of binary angle units covered by each segment of the table.
+#define BINARY_ANGLE_PER_SEGMENT (BINARY_ANGLE_PER_QUARTER / SINE_TABLE_SEGMENTS)
+
+// The sine of each segment boundary from 0° to 90°, the rest of the wave is
+// found by symmetry, and values between boundaries by interpolation. This
+// avoids the double precision sin() and cos(), which are emulated in software.
+static const float SINE_TABLE[SINE_TABLE_SEGMENTS + 1] = {
+    0.0000000f, 0.0245412f, 0.0490677f, 0.0735646f, 0.0980171f,
+    0.1224107f, 0.1467305f, 0.1709619f, 0.1950903f, 0.2191012f,
+    0.2429802f, 0.2667128f, 0.2902847f, 0.3136817f, 0.3368899f,
+    0.3598950f, 0.3826834f, 0.4052413f, 0.4275551f, 0.4496113f,
+    0.4713967f, 0.4928982f, 0.5141027f, 0.5349976f, 0.5555702f,
+    0.5758082f, 0.5956993f, 0.6152316f, 0.6343933f, 0.6531728f,
+    0.6715590f, 0.6895405f, 0.7071068f, 0.7242471f, 0.7409511f,
+    0.7572088f, 0.7730105f, 0.7883464f, 0.8032075f, 0.8175848f,
+    0.8314696f, 0.8448536f, 0.8577286f, 0.8700870f, 0.8819213f,
+    0.8932243f, 0.9039893f, 0.9142098f, 0.9238795f, 0.9329928f,
+    0.9415441f, 0.9495282f, 0.9569403f, 0.9637761f, 0.9700313f,
+    0.9757021f, 0.9807853f, 0.9852776f, 0.9891765f, 0.9924795f,
+    0.9951847f, 0.9972905f, 0.9987955f, 0.9996988f, 1.0000000f};
 
 /**
  * @brief Angle Constructor.
  *
- * @param value the provided int16_t to set the value to, this value gets
- * wrapped between -179 and 180.
+ * @param degrees The angle in whole degrees, this value gets wrapped between
+ * -179 and 180.
  */
-Angle::Angle(int16_t value) : _value(_normalize(value)) {}
+Angle::Angle(int16_t degrees) : _value(_degreesToBinary(degrees)) {}
+
+/**
+ * @brief Creates an Angle from a value in degrees, keeping the fractional
+ * part.
+ *
+ * @param degrees The angle in degrees.
+ * @return (Angle) The created angle.
+ */
+Angle Angle::fromDegrees(float degrees) {
+    // Wrap the angle first, so that the conversion can't overflow.
+    float wrappedDegrees = fmodf(degrees, DEGREES_PER_ROTATION);
+
+    int32_t binaryAngle = lroundf(wrappedDegrees * BINARY_ANGLE_PER_ROTATION /
+                                  DEGREES_PER_ROTATION);
+
+    return fromBinary((int16_t)(uint16_t)binaryAngle);
+}
+
+/**
+ * @brief Creates an Angle directly from a binary angle, where 65536
+ * represents a full rotation.
+ *
+ * @param binaryAngle The binary angle.
+ * @return (Angle) The created angle.
+ */
+Angle Angle::fromBinary(int16_t binaryAngle) {
+    Angle angleToReturn(0);
+    angleToReturn._value = binaryAngle;
+    return angleToReturn;
+}
 
 /**
  * @brief Implicitly converts the angle into a int16_t
  *
- * @return The value of the angle in the form of a int16_t.
+ * @return The value of the angle in whole degrees, rounded to the nearest
+ * degree and wrapped between -179 and 180.
  */
-Angle::operator int16_t() const { return this->_value; }
+Angle::operator int16_t() const {
+    // degrees = value * 360 / 65536 = value * 45 / 8192, rounded to nearest.
+    int16_t degrees = (((int32_t)this->_value * 45) + 4096) >> 13;
+
+    // Angles that round to -180 are reported as 180.
+    return (degrees == -180) ? 180 : degrees;
+}
 
 /**
  * @brief Overloaded addition operator, used to add two angles together.
  *
- * @param otherAngle The angle (or uint16_t via implicit conversion) to sum
- * with the current angle.
+ * @param otherAngle The angle to sum with the current angle.
  * @return The sum of the provided angles.
  */
-Angle Angle::operator+(Angle& otherAngle) const {
-    return Angle(this->_value + otherAngle._value);
+Angle Angle::operator+(const Angle& otherAngle) const {
+    return fromBinary(this->_value + otherAngle._value);
 }
+
+/**
+ * @brief Overloaded addition operator, used to add a number of degrees to the
+ * angle.
+ *
+ * @param degreesToAdd The number of degrees to add to the angle.
+ * @return The sum of the angle and the degrees.
+ */
+Angle Angle::operator+(int degreesToAdd) const {
+    return fromBinary(this->_value + _degreesToBinary(degreesToAdd));
+}
+
 /**
  * @brief Overloaded compound addition operator, used to add an angle to the
  * current angle.
  *
- * @param valueToAdd The angle (or uint16_t) to add to the current angle.
+ * @param otherAngle The angle to add to the current angle.
+ * @return reference to the modified angle.
+ */
+Angle Angle::operator+=(const Angle& otherAngle) {
+    this->_value += otherAngle._value;
+    return *this;
+}
+
+/**
+ * @brief Overloaded compound addition operator, used to add a number of
+ * degrees to the current angle.
+ *
+ * @param degreesToAdd The number of degrees to add to the current angle.
  * @return reference to the modified angle.
  */
-Angle Angle ::operator+=(int16_t valueToAdd) {
-    this->_value = _normalize(this->_value + valueToAdd);
+Angle Angle::operator+=(int degreesToAdd) {
+    this->_value += _degreesToBinary(degreesToAdd);
     return *this;
 }
 
@@ -53,33 +137,90 @@ Angle Angle ::operator+=(int16_t valueToAdd) {
  * @brief Overloaded subtraction operator, used to subtract one angle from
  * another.
  *
- * @param otherAngle The angle (or uint16_t) to subtract from the current
- * angle.
+ * @param otherAngle The angle to subtract from the current angle.
  * @return The difference between the provided angles.
  */
-Angle Angle::operator-(Angle& otherAngle) const {
-    return Angle(this->_value - otherAngle._value);
+Angle Angle::operator-(const Angle& otherAngle) const {
+    return fromBinary(this->_value - otherAngle._value);
 }
 
 /**
- * @brief Overloaded compound subtraction operator, used to subtract an
- * angle from the current angle.
+ * @brief Overloaded subtraction operator, used to subtract a number of
+ * degrees from the angle.
  *
- * @param valueToSub The angle (or uint16_t) to add to subtract from the
- * current angle.
+ * @param degreesToSub The number of degrees to subtract from the angle.
+ * @return The difference between the angle and the degrees.
+ */
+Angle Angle::operator-(int degreesToSub) const {
+    return fromBinary(this->_value - _degreesToBinary(degreesToSub));
+}
+
+/**
+ * @brief Overloaded compound subtraction operator, used to subtract an angle
+ * from the current angle.
+ *
+ * @param otherAngle The angle to subtract from the current angle.
+ * @return reference to the modified angle.
+ */
+Angle Angle::operator-=(const Angle& otherAngle) {
+    this->_value -= otherAngle._value;
+    return *this;
+}
+
+/**
+ * @brief Overloaded compound subtraction operator, used to subtract a number
+ * of degrees from the current angle.
+ *
+ * @param degreesToSub The number of degrees to subtract from the current
+ * angle.
  * @return reference to the modified angle.
  */
-Angle Angle::operator-=(int16_t valueToSub) {
-    this->_value = _normalize(this->_value - valueToSub);
+Angle Angle::operator-=(int degreesToSub) {
+    this->_value -= _degreesToBinary(degreesToSub);
     return *this;
 }
 
+/**
+ * @brief Returns the angle in degrees, including the fractional part, for
+ * logging and calculations that need more than whole degrees.
+ *
+ * @return (float) The value of the angle in degrees, between -180 and 180.
+ */
+float Angle::getDegrees() const {
+    return this->_value *
+           ((float)DEGREES_PER_ROTATION / BINARY_ANGLE_PER_ROTATION);
+}
+
+/**
+ * @brief Returns the raw binary angle, where 65536 represents a full rotation.
+ *
+ * @return (int16_t) The binary angle.
+ */
+int16_t Angle::getBinary() const { return this->_value; }
+
 /**
  * @brief Retuns the angle's equivelent value in radians.
  *
- * @return (double) The value of the angle in radians.
+ * @return (float) The value of the angle in radians.
+ */
+float Angle::getRadians() { return this->getDegrees() * RADIANS_PER_DEGREE; }
+
+/**
+ * @brief Returns the sine of the angle, from a lookup table.
+ *
+ * @return (float) The sine of the angle.
  */
-double Angle::getRadians() { return radians(this->_value); }
+float Angle::getSine() { return _lookupSine(this->_value); }
+
+/**
+ * @brief Returns the cosine of the angle, from a lookup table.
+ *
+ * @return (float) The cosine of the angle.
+ */
+float Angle::getCosine() {
+    // cos(x) = sin(x + 90)
+    return _lookupSine(this->_value + BINARY_ANGLE_PER_QUARTER);
+}
 
 /**
  * @brief returns the closest multiple of 90 of this angle.
@@ -87,17 +228,14 @@ double Angle::getRadians() { return radians(this->_value); }
  * @return (Angle) The closest right angle
  */
 Angle Angle::closestRightAngle() {
-    int tempValue = this->_get360();
-
-    tempValue += 45;
-
-    int index = (tempValue / 90);
+    // Adding half of a quarter and then clearing the bits below a quarter
+    // rounds to the nearest quarter.
+    uint16_t roundedValue =
+        (uint16_t)this->_value + (BINARY_ANGLE_PER_QUARTER / 2);
 
-    int closest90 = index * 90;
+    roundedValue &= ~(BINARY_ANGLE_PER_QUARTER - 1);
 
-    Angle angleToReturn = (Angle)closest90;
-
-    return angleToReturn;
+    return fromBinary((int16_t)roundedValue);
 }
 
 /**
@@ -176,44 +314,69 @@ bool Angle::isPointingRight() { return (this->closestRightAngle() == 0); }
  * @return (uint16_t) The index of the hypothetical segment.
  */
 uint16_t Angle::segmentIndex(uint16_t segmentCount) {
-    uint16_t unwrappedAngle = this->_get360();
+    // Treating the binary angle as unsigned gives the angle between 0° and
+    // 360°.
+    uint32_t unwrappedAngle = (uint16_t)this->_value;
 
     uint16_t segmentIndex =
-        unwrappedAngle * segmentCount / DEGREES_PER_ROTATION;
+        unwrappedAngle * segmentCount / BINARY_ANGLE_PER_ROTATION;
 
     return segmentIndex;
 }
 
 /**
- * @brief wraps a provided int16_t between -179 and 180.
+ * @brief Converts a whole number of degrees into a binary angle.
  *
- * @param valueToNormalize the value to wrap between -179 and 180.
- * @return int16_t the value after being wrapped between -179 and 180.
+ * @param degrees The angle in degrees.
+ * @return (int16_t) The equivalent binary angle.
  */
-int16_t Angle::_normalize(int16_t valueToNormalize) {
-    valueToNormalize -= ANGLE_LOWER_BOUND;
-
-    valueToNormalize %= DEGREES_PER_ROTATION;
-
-    if (valueToNormalize < 0) {
-        valueToNormalize += DEGREES_PER_ROTATION;
-    }
-    valueToNormalize += ANGLE_LOWER_BOUND;
-
-    return valueToNormalize;
-};
+int16_t Angle::_degreesToBinary(int32_t degrees) {
+    // Wrap the angle first, so that the conversion can't overflow.
+    degrees %= DEGREES_PER_ROTATION;
+
+    // Round to the nearest binary angle, away from zero on a tie.
+    int32_t scaled = degrees * BINARY_ANGLE_PER_ROTATION;
+    int32_t halfDivisor = (scaled < 0) ? -(DEGREES_PER_ROTATION / 2)
+                                       : (DEGREES_PER_ROTATION / 2);
+    int32_t binaryAngle = (scaled + halfDivisor) / DEGREES_PER_ROTATION;
+
+    // Casting through an unsigned integer wraps the angle to a full rotation.
+    return (int16_t)(uint16_t)binaryAngle;
+}
 
 /**
- * @brief returns the angle but within the range 0-359
+ * @brief Looks up the sine of a binary angle, interpolating between the
+ * entries of a quarter wave table, and using the symmetry of the sine wave to
+ * find the rest.
  *
- * @return uint8_t angle wrapped to 0-359.
+ * @param binaryAngle The binary angle.
+ * @return (float) The sine of the angle.
  */
-uint16_t Angle::_get360() {
-    if (_value < 0) {
-        return _value + DEGREES_PER_ROTATION;
-    } else {
-        return _value;
+float Angle::_lookupSine(uint16_t binaryAngle) {
+    // The top two bits give the quarter of the rotation, the rest give the
+    // position within that quarter.
+    uint8_t quarter = binaryAngle >> 14;
+    uint16_t positionInQuarter = binaryAngle & (BINARY_ANGLE_PER_QUARTER - 1);
+
+    // The second and fourth quarters are mirror images of the first and third.
+    if (quarter & 1) {
+        positionInQuarter = BINARY_ANGLE_PER_QUARTER - positionInQuarter;
     }
+
+    uint8_t index = positionInQuarter / BINARY_ANGLE_PER_SEGMENT;
+    uint16_t remainder = positionInQuarter % BINARY_ANGLE_PER_SEGMENT;
+
+    float sine = SINE_TABLE[index];
+
+    // Interpolate towards the next entry, the end of the table is only ever
+    // reached exactly.
+    if (remainder != 0) {
+        float fraction = (float)remainder / BINARY_ANGLE_PER_SEGMENT;
+        sine += (SINE_TABLE[index + 1] - sine) * fraction;
+    }
+
+    // The second half of the wave is the negative of the first half.
+    return (quarter & 2) ? -sine : sine;
 }
 
 /**
@@ -231,8 +394,8 @@ Position::Position(float x, float y) : x(x), y(y) {}
  * @return Position& returns a reference to the modified object;
  */
 Position& Position::rotate(Angle rotationAngle) {
-    float sinAngle = sin(rotationAngle.getRadians());
-    float cosAngle = cos(rotationAngle.getRadians());
+    float sinAngle = rotationAngle.getSine();
+    float cosAngle = rotationAngle.getCosine();
 
     float tempX = this->x * cosAngle - this->y * sinAngle;
     float tempY = this->y * cosAngle + this->x * sinAngle;
@@ -291,8 +454,12 @@ float Position::squaredDistanceTo(Position target, int* dx_P, int* dy_P) {
     float dx = abs(target.x - this->x);
     float dy = abs(target.y - this->y);
 
-    *dx_P = dx;
-    *dy_P = dy;
+    if (dx_P != nullptr) {
+        *dx_P = dx;
+    }
+    if (dy_P != nullptr) {
+        *dy_P = dy;
+    }
 
     float squaredDistance = dx * dx + dy * dy;
 
@@ -333,7 +500,7 @@ float Position::distanceTo(Position target) {
     }
     // If a and b are both not zero, calculate c
     else {
-        c = sqrt(cSquared);
+        c = sqrtf(cSquared);
     }
 
     return c;
@@ -350,7 +517,8 @@ Angle Position::calculateAngleTo(Position target) {
     int dx = target.x - this->x;
     int dy = target.y - this->y;
 
-    Angle angleToOtherPosition = degrees(atan2(dy, dx));
+    Angle angleToOtherPosition =
+        Angle::fromDegrees(atan2f(dy, dx) * DEGREES_PER_RADIAN);
 
     return angleToOtherPosition;
 }
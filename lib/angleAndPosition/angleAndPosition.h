@@ -14,11 +14,23 @@
 // The number of degrees in a full rotation.
 #define DEGREES_PER_ROTATION 360
 
+// The number of binary angle units in a full rotation, the full range of a
+// 16 bit integer.
+#define BINARY_ANGLE_PER_ROTATION 65536L
+
+// Single precision conversions between degrees and radians, as the Arduino
+// radians() and degrees() macros promote to double.
+#define RADIANS_PER_DEGREE 0.017453292f
+#define DEGREES_PER_RADIAN 57.29577951f
+
 /**
- * @brief Angle class, a wrapper for the int16_t that automatically wraps the
- * value to between -179 and 180.
+ * @brief Angle class, a binary angle stored in an int16_t, where the full
+ * range of the integer represents one rotation. This gives a resolution of
+ * about 0.0055°, and the angle wraps between -180 and 180 for free when the
+ * integer overflows.
  *
- * Instances of this class can be implicitly converted to int16_t.
+ * Instances of this class can be implicitly converted to int16_t, which
+ * gives the angle in whole degrees between -179 and 180.
  *
  */
 class Angle {
@@ -26,62 +38,145 @@ class Angle {
     /**
      * @brief Angle Constructor.
      *
-     * @param value the provided int16_t to set the value to, this value gets
-     * wrapped between -179 and 180.
+     * @param degrees The angle in whole degrees, this value gets wrapped
+     * between -179 and 180.
+     */
+    Angle(int16_t degrees);
+
+    /**
+     * @brief Creates an Angle from a value in degrees, keeping the fractional
+     * part.
+     *
+     * @param degrees The angle in degrees.
+     * @return (Angle) The created angle.
      */
-    Angle(int16_t value);
+    static Angle fromDegrees(float degrees);
+
+    /**
+     * @brief Creates an Angle directly from a binary angle, where 65536
+     * represents a full rotation.
+     *
+     * @param binaryAngle The binary angle.
+     * @return (Angle) The created angle.
+     */
+    static Angle fromBinary(int16_t binaryAngle);
 
     /**
      * @brief Implicitly converts the angle into a int16_t
      *
-     * @return The value of the angle in the form of a int16_t.
+     * @return The value of the angle in whole degrees, rounded to the
+     * nearest degree and wrapped between -179 and 180.
      */
     operator int16_t() const;
 
     /**
      * @brief Overloaded addition operator, used to add two angles together.
      *
-     * @param otherAngle The angle (or uint16_t via implicit conversion) to sum
-     * with the current angle.
+     * @param otherAngle The angle to sum with the current angle.
      * @return The sum of the provided angles.
      */
-    Angle operator+(Angle& otherAngle) const;
+    Angle operator+(const Angle& otherAngle) const;
+
+    /**
+     * @brief Overloaded addition operator, used to add a number of degrees to
+     * the angle.
+     *
+     * @param degreesToAdd The number of degrees to add to the angle.
+     * @return The sum of the angle and the degrees.
+     */
+    Angle operator+(int degreesToAdd) const;
 
     /**
      * @brief Overloaded compound addition operator, used to add an angle to the
      * current angle.
      *
-     * @param valueToAdd The angle (or uint16_t) to add to the current angle.
+     * @param otherAngle The angle to add to the current angle.
+     * @return reference to the modified angle.
+     */
+    Angle operator+=(const Angle& otherAngle);
+
+    /**
+     * @brief Overloaded compound addition operator, used to add a number of
+     * degrees to the current angle.
+     *
+     * @param degreesToAdd The number of degrees to add to the current angle.
      * @return reference to the modified angle.
      */
-    Angle operator+=(int16_t valueToAdd);
+    Angle operator+=(int degreesToAdd);
 
     /**
      * @brief Overloaded subtraction operator, used to subtract one angle from
      * another.
      *
-     * @param otherAngle The angle (or uint16_t) to subtract from the current
-     * angle.
+     * @param otherAngle The angle to subtract from the current angle.
      * @return The difference between the provided angles.
      */
-    Angle operator-(Angle& otherAngle) const;
+    Angle operator-(const Angle& otherAngle) const;
+
+    /**
+     * @brief Overloaded subtraction operator, used to subtract a number of
+     * degrees from the angle.
+     *
+     * @param degreesToSub The number of degrees to subtract from the angle.
+     * @return The difference between the angle and the degrees.
+     */
+    Angle operator-(int degreesToSub) const;
 
     /**
      * @brief Overloaded compound subtraction operator, used to subtract an
      * angle from the current angle.
      *
-     * @param valueToSub The angle (or uint16_t) to add to subtract from the
-     * current angle.
+     * @param otherAngle The angle to subtract from the current angle.
+     * @return reference to the modified angle.
+     */
+    Angle operator-=(const Angle& otherAngle);
+
+    /**
+     * @brief Overloaded compound subtraction operator, used to subtract a
+     * number of degrees from the current angle.
+     *
+     * @param degreesToSub The number of degrees to subtract from the current
+     * angle.
      * @return reference to the modified angle.
      */
-    Angle operator-=(int16_t valueToSub);
+    Angle operator-=(int degreesToSub);
+
+    /**
+     * @brief Returns the angle in degrees, including the fractional part, for
+     * logging and calculations that need more than whole degrees.
+     *
+     * @return (float) The value of the angle in degrees, between -180 and 180.
+     */
+    float getDegrees() const;
+
+    /**
+     * @brief Returns the raw binary angle, where 65536 represents a full
+     * rotation.
+     *
+     * @return (int16_t) The binary angle.
+     */
+    int16_t getBinary() const;
 
     /**
      * @brief Retuns the angles equivelent value in radians.
      *
-     * @return (double) The value of the angle in radians.
+     * @return (float) The value of the angle in radians.
+     */
+    float getRadians();
+
+    /**
+     * @brief Returns the sine of the angle, from a lookup table.
+     *
+     * @return (float) The sine of the angle.
+     */
+    float getSine();
+
+    /**
+     * @brief Returns the cosine of the angle, from a lookup table.
+     *
+     * @return (float) The cosine of the angle.
      */
-    double getRadians();
+    float getCosine();
 
     /**
      * @brief returns the closest multiple of 90 of this angle.
@@ -162,24 +257,28 @@ class Angle {
 
    private:
     /**
-     * @brief the value of the angle, a int16_t wrapped between -179 and 180.
+     * @brief the value of the angle as a binary angle, where 65536 represents
+     * a full rotation.
      */
     int16_t _value;
 
     /**
-     * @brief wraps a provided int16_t between -179 and 180.
+     * @brief Converts a whole number of degrees into a binary angle.
      *
-     * @param valueToNormalize the value to wrap between -179 and 180.
-     * @return int16_t the value after being wrapped between -179 and 180.
+     * @param degrees The angle in degrees.
+     * @return (int16_t) The equivalent binary angle.
      */
-    int16_t _normalize(int16_t valueToNormalize);
+    static int16_t _degreesToBinary(int32_t degrees);
 
     /**
-     * @brief returns the angle but within the range 0-359
+     * @brief Looks up the sine of a binary angle, interpolating between the
+     * entries of a quarter wave table, and using the symmetry of the sine wave
+     * to find the rest.
      *
-     * @return uint8_t angle wrapped to 0-359.
+     * @param binaryAngle The binary angle.
+     * @return (float) The sine of the angle.
      */
-    uint16_t _get360();
+    static float _lookupSine(uint16_t binaryAngle);
 };
 
 // Forward declaration of the Pose and Position structs, so that they can be
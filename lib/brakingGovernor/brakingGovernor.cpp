@@ -0,0 +1,148 @@
+/**
+ * @file brakingGovernor.cpp
+ * @brief Definition of the BrakingGovernor class, responsible for limiting
+ * the speed of the robot so that it can always stop before the wall in front
+ * of it.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-16
+ * @copyright Copyright (c) 2024
+ */
+#include "brakingGovernor.h"
+
+#include "drive.h"
+#include "frontRange.h"
+#include "motor.h"
+
+// The period in milliseconds between updates of the speed limit.
+#define BRAKING_GOVERNOR_POLL_RATE 20
+
+// The deceleration in millimeters per second squared that the robot is
+// assumed to be able to brake at, a bit below the acceleration limit of the
+// speed controllers so that there is some margin.
+#define BRAKING_DECELERATION 800
+
+// The time in seconds between the front distance being measured and the
+// robot starting to brake, covering the poll period and the motors reacting.
+#define BRAKING_LATENCY 0.05f
+
+// The speed limit in millimeters per second is never set below this while
+// there is still a gap to the stopping distance, so that the robot can creep
+// up to it.
+#define BRAKING_MIN_SPEED 60
+
+// How much of each new measurement of the rate that the front distance is
+// dropping to mix into the smoothed rate, as a single reading is noisy.
+#define RANGE_RATE_SMOOTHING 0.3f
+
+/**
+ * @brief Construct a new BrakingGovernor object.
+ *
+ * @param frontRange_P Pointer to the front range, used to read the distance to
+ * the object in front of the robot.
+ * @param drive_P Pointer to the drive, to limit the speed of.
+ * @param leftMotor_P Pointer to the left motor, used to get its speed.
+ * @param rightMotor_P Pointer to the right motor, used to get its speed.
+ * @param stoppingDistance The distance in millimeters from the centre of the
+ * robot to the wall that the robot must be able to stop at.
+ */
+BrakingGovernor::BrakingGovernor(FrontRange* frontRange_P, Drive* drive_P,
+                                 Motor* leftMotor_P, Motor* rightMotor_P,
+                                 int stoppingDistance)
+    : _frontRange_P(frontRange_P),
+      _drive_P(drive_P),
+      _leftMotor_P(leftMotor_P),
+      _rightMotor_P(rightMotor_P),
+      _stoppingDistance(stoppingDistance),
+      _pollSchedule(BRAKING_GOVERNOR_POLL_RATE) {}
+
+/**
+ * @brief Updates the closing speed and the speed limit of the Drive, at a
+ * fixed rate.
+ */
+void BrakingGovernor::poll() {
+    if (!this->_pollSchedule.isReadyToRun()) {
+        return;
+    }
+
+    uint32_t currentTime = millis();
+    float timeStep = (currentTime - this->_lastTime) / 1000.0f;
+    this->_lastTime = currentTime;
+
+    int distance = this->_frontRange_P->read();
+
+    float wheelSpeed = (this->_leftMotor_P->getVelocity() +
+                        this->_rightMotor_P->getVelocity()) /
+                       2;
+
+    // With nothing in front of the robot, there is nothing to brake for.
+    if (distance == -1) {
+        this->_lastDistance = -1;
+        this->_rangeRate = 0;
+        this->_closingSpeed = max(wheelSpeed, 0.0f);
+        this->_timeToCollision = -1;
+        this->_speedLimit = -1;
+        this->_drive_P->setSpeedLimit(-1);
+        return;
+    }
+
+    if ((this->_lastDistance != -1) && (timeStep > 0)) {
+        float rangeRate = (this->_lastDistance - distance) / timeStep;
+        this->_rangeRate +=
+            RANGE_RATE_SMOOTHING * (rangeRate - this->_rangeRate);
+    }
+    this->_lastDistance = distance;
+
+    this->_closingSpeed = max(max(wheelSpeed, this->_rangeRate), 0.0f);
+
+    float gap = max(distance - this->_stoppingDistance, 0);
+
+    if (this->_closingSpeed > 0) {
+        this->_timeToCollision = gap / this->_closingSpeed;
+    } else {
+        this->_timeToCollision = -1;
+    }
+
+    // The robot keeps closing for the latency before it starts braking, and
+    // then needs v^2 / 2a to stop, so the fastest it can go is the speed it
+    // can stop from in the gap that is left.
+    float brakingGap = max(gap - this->_closingSpeed * BRAKING_LATENCY, 0.0f);
+    float speedLimit = sqrt(2 * BRAKING_DECELERATION * brakingGap);
+
+    // Once at the stopping distance, the limit drops to 0, so that the robot
+    // stops there rather than creeping on into the wall.
+    if (gap > 0) {
+        speedLimit = max(speedLimit, (float)BRAKING_MIN_SPEED);
+    } else {
+        speedLimit = 0;
+    }
+
+    this->_speedLimit = speedLimit;
+    this->_drive_P->setSpeedLimit(this->_speedLimit);
+}
+
+/**
+ * @brief Gets the speed that the robot is closing on the object in front of
+ * it.
+ *
+ * @return (float) The closing speed in millimeters per second, 0 if the robot
+ * isn't getting closer.
+ */
+float BrakingGovernor::getClosingSpeed() { return this->_closingSpeed; }
+
+/**
+ * @brief Gets the time until the robot reaches the stopping distance, if it
+ * keeps closing at the current speed.
+ *
+ * @return (float) The time to collision in seconds, or -1 if the robot isn't
+ * closing on anything.
+ */
+float BrakingGovernor::getTimeToCollision() { return this->_timeToCollision; }
+
+/**
+ * @brief Gets the speed limit last given to the Drive.
+ *
+ * @return (float) The speed limit in millimeters per second, or -1 if there is
+ * nothing in front of the robot to limit the speed.
+ */
+float BrakingGovernor::getSpeedLimit() { return this->_speedLimit; }
@@ -0,0 +1,116 @@
+/**
+ * @file brakingGovernor.h
+ * @brief Declaration of the BrakingGovernor class, responsible for limiting
+ * the speed of the robot so that it can always stop before the wall in front
+ * of it.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-16
+ * @copyright Copyright (c) 2024
+ */
+#ifndef BRAKING_GOVERNOR_H
+#define BRAKING_GOVERNOR_H
+
+#include <Arduino.h>
+
+#include "schedule.h"
+
+// Forward declaration of the FrontRange, Drive and Motor classes.
+class FrontRange;
+class Drive;
+class Motor;
+
+/**
+ * @brief BrakingGovernor class, works out how fast the robot is closing on
+ * whatever is in front of it, and limits the forward speed of the Drive so
+ * that the robot can always slow down in time to stop at a set distance.
+ *
+ * The closing speed is the faster of the speed measured by the wheels and the
+ * rate that the front distance is dropping, so that the robot still slows
+ * down if the wheels slip.
+ */
+class BrakingGovernor {
+   public:
+    /**
+     * @brief Construct a new BrakingGovernor object.
+     *
+     * @param frontRange_P Pointer to the front range, used to read the
+     * distance to the object in front of the robot.
+     * @param drive_P Pointer to the drive, to limit the speed of.
+     * @param leftMotor_P Pointer to the left motor, used to get its speed.
+     * @param rightMotor_P Pointer to the right motor, used to get its speed.
+     * @param stoppingDistance The distance in millimeters from the centre of
+     * the robot to the wall that the robot must be able to stop at.
+     */
+    BrakingGovernor(FrontRange* frontRange_P, Drive* drive_P,
+                    Motor* leftMotor_P, Motor* rightMotor_P,
+                    int stoppingDistance);
+
+    /**
+     * @brief Updates the closing speed and the speed limit of the Drive, at a
+     * fixed rate.
+     */
+    void poll();
+
+    /**
+     * @brief Gets the speed that the robot is closing on the object in front
+     * of it.
+     *
+     * @return (float) The closing speed in millimeters per second, 0 if the
+     * robot isn't getting closer.
+     */
+    float getClosingSpeed();
+
+    /**
+     * @brief Gets the time until the robot reaches the stopping distance, if
+     * it keeps closing at the current speed.
+     *
+     * @return (float) The time to collision in seconds, or -1 if the robot
+     * isn't closing on anything.
+     */
+    float getTimeToCollision();
+
+    /**
+     * @brief Gets the speed limit last given to the Drive.
+     *
+     * @return (float) The speed limit in millimeters per second, or -1 if
+     * there is nothing in front of the robot to limit the speed.
+     */
+    float getSpeedLimit();
+
+   private:
+    FrontRange* _frontRange_P;
+    Drive* _drive_P;
+    Motor* _leftMotor_P;
+    Motor* _rightMotor_P;
+
+    /**
+     * @brief The distance in millimeters from the centre of the robot to the
+     * wall that the robot must be able to stop at.
+     */
+    int _stoppingDistance;
+
+    /**
+     * @brief The front distance and time of the last poll, used to find the
+     * rate that the front distance is changing.
+     */
+    int _lastDistance = -1;
+    uint32_t _lastTime = 0;
+
+    /**
+     * @brief The smoothed rate that the front distance is dropping, in
+     * millimeters per second.
+     */
+    float _rangeRate = 0;
+
+    float _closingSpeed = 0;
+    float _timeToCollision = -1;
+    float _speedLimit = -1;
+
+    /**
+     * @brief The schedule that limits how often the speed limit is updated.
+     */
+    PassiveSchedule _pollSchedule;
+};
+
+#endif  // BRAKING_GOVERNOR_H
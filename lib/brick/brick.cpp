@@ -17,6 +17,10 @@
 // TODO read this value in.
 #define ROBOT_RADIUS 120
 
+// How far in millimeters a Brick can be seen from where it is in the list, for
+// it to be treated as the same Brick seen again.
+#define LOOP_CLOSURE_TOLERANCE 100
+
 /**
  * @brief Construct a new Brick object
  *
@@ -123,7 +127,9 @@ float Brick::squaredDistanceTo(Position target, int* zone_IP, int* dx_P,
                                int* dy_P) {
     Zone targetPositionZone = this->calculateZone(target);
 
-    *zone_IP = (int)targetPositionZone;
+    if (zone_IP != nullptr) {
+        *zone_IP = (int)targetPositionZone;
+    }
 
     if (targetPositionZone == CentreZone) {
         return 0;
@@ -209,7 +215,7 @@ float Brick::distanceTo(Position target) {
     }
     // If a and b are both not zero, calculate c
     else {
-        c = sqrt(cSquared);
+        c = sqrtf(cSquared);
     }
 
     return c;
@@ -239,7 +245,12 @@ String Brick::toString() {
 /**
  * @brief Construct a new BrickList object, and appends the 4 starting walls.
  */
-BrickList::BrickList() { this->_addWalls(); };
+BrickList::BrickList() {
+    this->_addWalls();
+
+    // The walls are fixed, so are never moved by a loop closure.
+    this->_brickCountAtLastClosure = this->_brickCount;
+};
 
 /**
  * @brief Get the number of Brick structs in the list.
@@ -331,8 +342,13 @@ bool BrickList::handleBrickFromWallPosition(Position brickOuterCorner) {
         brickToAdd.position.y = brickOuterCorner.y - (BRICK_LENGTH / 2);
     }
 
+    // The Brick is pushed up against the wall, so only its position along the
+    // wall was measured.
+    bool xObserved = onBottomWall || onTopWall;
+    bool yObserved = onLeftWall || onRightWall;
+
     // Return true if a brick gets added to the list, and false if not.
-    return this->_attemptAppendBrick(brickToAdd);
+    return this->_attemptAppendBrick(brickToAdd, xObserved, yObserved);
 }
 
 /**
@@ -564,8 +580,11 @@ int BrickList::handleBrickFromSensorAndMap(Position robotPosition,
         Brick brickToAdd =
             this->_getBrickFromEdge(brickEdgePosition, angleOfSensor);
 
+        // Only the distance along the sensor was measured.
+        bool xObserved = pointingLeft || pointingRight;
+
         // return 1 if a new brick is placed, 0 if it is not.
-        return this->_attemptAppendBrick(brickToAdd);
+        return this->_attemptAppendBrick(brickToAdd, xObserved, !xObserved);
     }
 
     // return 0 to indicate that no changes have been made to the list.
@@ -620,18 +639,19 @@ int BrickList::lowestDistance(Position testPosition, int* indexOfClosestBrick_P,
     }
 
     // if indexOfClosestBrick_L was set, return it via reference.
-    if (indexOfClosestBrick_L != -1) {
+    if ((indexOfClosestBrick_L != -1) && (indexOfClosestBrick_P != nullptr)) {
         *indexOfClosestBrick_P = indexOfClosestBrick_L;
     }
 
     // if zoneFromClosestBrick_L was set, return it via reference.
-    if (zoneFromClosestBrick_L != -1) {
+    if ((zoneFromClosestBrick_L != -1) &&
+        (zoneFromClosestBrick_P != nullptr)) {
         *zoneFromClosestBrick_P = zoneFromClosestBrick_L;
     }
 
     // TODO could make this run better using a similar method to the one used in
     // Position::distanceTo()
-    return sqrt(lowestSquaredDistance);
+    return sqrtf(lowestSquaredDistance);
 }
 
 #if DEBUG_ALLOW_PREFILLED_MAZE
@@ -686,7 +706,7 @@ int BrickList::_compare(Position robotPosition, Angle angleOfSensor,
     }
 
     int expectedDistance =
-        this->_getOrthogonalBrickDistance(robotPosition, angleOfSensor);
+        this->getOrthogonalBrickDistance(robotPosition, angleOfSensor);
 
     if (expectedDistance < 1) {
         return -2;
@@ -749,8 +769,8 @@ Brick BrickList::_getBrickFromEdge(Position brickEdgePosition,
  * @return (int) The distance to the Brick in the chosen direction.
  * Returns -1 if no Brick was seen.
  */
-int BrickList::_getOrthogonalBrickDistance(Position robotPosition,
-                                           Angle directionOfBrick) {
+int BrickList::getOrthogonalBrickDistance(Position robotPosition,
+                                          Angle directionOfBrick) {
     // In its current state this function can only get the distance to
     // orthogonal bricks, the input angle is rounded to the closest right
     // angle.
@@ -808,6 +828,123 @@ int BrickList::_getOrthogonalBrickDistance(Position robotPosition,
     return shortestDistance;
 }
 
+/**
+ * @brief Get the distance along a ray to the first Brick that it hits, this
+ * works in any direction, unlike getOrthogonalBrickDistance().
+ *
+ * Bricks that contain the origin of the ray are ignored.
+ *
+ * @param origin The position that the ray starts from.
+ * @param direction The direction of the ray.
+ * @param hitVerticalFace_P The pointer used to return whether the face that
+ * was hit runs vertically, along the y axis, rather than horizontally.
+ * @return (float) The distance along the ray to the first Brick hit.
+ * Returns -1 if no Brick was hit.
+ */
+float BrickList::rayCast(Position origin, Angle direction,
+                         bool* hitVerticalFace_P) {
+    float directionX = direction.getCosine();
+    float directionY = direction.getSine();
+
+    const float noHit = -1;
+    float closestHit = noHit;
+    bool closestHitIsVertical = false;
+
+    for (int i = 0; i < this->getBrickCount(); i++) {
+        Brick brick = this->getBrick(i);
+
+        Position bottomLeft = brick.getBottomLeft();
+        Position topRight = brick.getTopRight();
+
+        // Every Brick is lined up with the axes, so the ray is inside the
+        // Brick between where it crosses both pairs of faces. The distances
+        // along the ray to each pair of faces are found separately, and the
+        // ray hits the Brick if the two ranges overlap.
+        float enterX = -INFINITY;
+        float exitX = INFINITY;
+
+        if (directionX != 0) {
+            float toLeft = (bottomLeft.x - origin.x) / directionX;
+            float toRight = (topRight.x - origin.x) / directionX;
+            enterX = min(toLeft, toRight);
+            exitX = max(toLeft, toRight);
+        } else if ((origin.x < bottomLeft.x) || (origin.x > topRight.x)) {
+            // Running parallel to the vertical faces without crossing them.
+            continue;
+        }
+
+        float enterY = -INFINITY;
+        float exitY = INFINITY;
+
+        if (directionY != 0) {
+            float toBottom = (bottomLeft.y - origin.y) / directionY;
+            float toTop = (topRight.y - origin.y) / directionY;
+            enterY = min(toBottom, toTop);
+            exitY = max(toBottom, toTop);
+        } else if ((origin.y < bottomLeft.y) || (origin.y > topRight.y)) {
+            continue;
+        }
+
+        float enter = max(enterX, enterY);
+        float exit = min(exitX, exitY);
+
+        // Skip Bricks that the ray misses, that are behind the origin, or that
+        // the origin is inside of.
+        if ((enter > exit) || (enter <= 0)) {
+            continue;
+        }
+
+        if ((closestHit == noHit) || (enter < closestHit)) {
+            closestHit = enter;
+            // The last pair of faces to be crossed is the one that was hit.
+            closestHitIsVertical = (enterX >= enterY);
+        }
+    }
+
+    if (hitVerticalFace_P != nullptr) {
+        *hitVerticalFace_P = closestHitIsVertical;
+    }
+
+    return closestHit;
+}
+
+/**
+ * @brief Gets the correction to the robot's position from the last loop
+ * closure, where a Brick already in the list was seen again, and clears it so
+ * that it is only applied once.
+ *
+ * @param offset_P The pointer used to return the offset to add to the robot's
+ * position.
+ * @param xObserved_P The pointer used to return whether the x position was
+ * measured by the loop closure.
+ * @param yObserved_P The pointer used to return whether the y position was
+ * measured by the loop closure.
+ * @return (true) If there has been a loop closure since the last call.
+ * @return (false) If there has been no loop closure.
+ */
+bool BrickList::getLoopClosure(Position* offset_P, bool* xObserved_P,
+                               bool* yObserved_P) {
+    if (!this->_loopClosurePending) {
+        return false;
+    }
+
+    *offset_P = this->_loopClosureOffset;
+
+    if (xObserved_P != nullptr) {
+        *xObserved_P = this->_loopClosureXObserved;
+    }
+    if (yObserved_P != nullptr) {
+        *yObserved_P = this->_loopClosureYObserved;
+    }
+
+    this->_loopClosureOffset = Position(0, 0);
+    this->_loopClosureXObserved = false;
+    this->_loopClosureYObserved = false;
+    this->_loopClosurePending = false;
+
+    return true;
+}
+
 /**
  * @brief Add a Brick to the end of the BrickList, if there is space
  * remaining.
@@ -835,11 +972,61 @@ bool BrickList::_appendBrick(Brick brickToAdd) {
  * @brief Adds a Brick the the end of the BrickList, if it does not collide
  * with an existing Brick in the list.
  *
+ * If the Brick is a fresh sighting of a Brick already in the list, it is used
+ * as a loop closure instead.
+ *
  * @param brickToAdd  The Brick to add.
+ * @param xObserved Whether the x position of the Brick was measured, rather
+ * than assumed from a wall.
+ * @param yObserved Whether the y position of the Brick was measured, rather
+ * than assumed from a wall.
  * @return (true) If the Brick was added to the list.
  * @return (false) If the Brick could not be added.
  */
-bool BrickList::_attemptAppendBrick(Brick brickToAdd) {
+bool BrickList::_attemptAppendBrick(Brick brickToAdd, bool xObserved,
+                                    bool yObserved) {
+    // Look for a Brick of the same size and orientation close enough to be
+    // the same Brick seen again. Checking the size stops the walls from being
+    // matched.
+    int matchedIndex = -1;
+    float closestMatchDistance = LOOP_CLOSURE_TOLERANCE;
+
+    for (int i = 0; i < this->getBrickCount(); i++) {
+        Brick existingBrick = this->getBrick(i);
+
+        bool sameShape = (existingBrick.isVertical == brickToAdd.isVertical) &&
+                         (existingBrick.length == brickToAdd.length);
+
+        if (!sameShape) {
+            continue;
+        }
+
+        float matchDistance =
+            existingBrick.position.distanceTo(brickToAdd.position);
+
+        if (matchDistance < closestMatchDistance) {
+            closestMatchDistance = matchDistance;
+            matchedIndex = i;
+        }
+    }
+
+    if (matchedIndex != -1) {
+        Position offset;
+        Position matchedPosition = this->getBrick(matchedIndex).position;
+
+        // Only the axes that were measured say anything about the drift.
+        if (xObserved) {
+            offset.x = matchedPosition.x - brickToAdd.position.x;
+        }
+        if (yObserved) {
+            offset.y = matchedPosition.y - brickToAdd.position.y;
+        }
+
+        this->_closeLoop(matchedIndex, offset, xObserved, yObserved);
+
+        return false;
+    }
+
     int shortestDistance = this->lowestDistance(brickToAdd.position);
 
     // TODO improve brick self coition detection.
@@ -855,6 +1042,61 @@ bool BrickList::_attemptAppendBrick(Brick brickToAdd) {
     return false;
 }
 
+/**
+ * @brief Uses a fresh sighting of a Brick already in the list to work out how
+ * far the robot's position has drifted, and spreads the drift back over the
+ * Bricks placed since the last loop closure.
+ *
+ * @param matchedIndex The index of the Brick that was seen again.
+ * @param offset The position of the Brick in the list minus the position it
+ * was seen at.
+ * @param xObserved Whether the x position of the Brick was measured.
+ * @param yObserved Whether the y position of the Brick was measured.
+ */
+void BrickList::_closeLoop(int matchedIndex, Position offset, bool xObserved,
+                           bool yObserved) {
+    // The robot has drifted by the offset since the matched Brick was placed,
+    // so it is corrected by the full offset.
+    this->_loopClosureOffset += offset;
+    this->_loopClosureXObserved |= xObserved;
+    this->_loopClosureYObserved |= yObserved;
+    this->_loopClosurePending = true;
+
+    // The Bricks placed since then drifted along with the robot, from almost
+    // nothing just after the matched Brick or last closure, up to the full
+    // offset now. As a simple relaxation of the chain of sightings, each is
+    // moved by its share of the offset, in the order they were placed.
+    int firstDriftedIndex =
+        max(this->_brickCountAtLastClosure, matchedIndex + 1);
+    int driftedCount = this->_brickCount - firstDriftedIndex;
+
+    // Bricks pushed up against a wall are placed from the wall, not the
+    // robot's position, so are never moved away from it.
+    const int wallTolerance = 10;
+
+    for (int i = firstDriftedIndex; i < this->_brickCount; i++) {
+        Brick& brick = this->_brickArray[i];
+
+        float share = (float)(i - firstDriftedIndex + 1) / driftedCount;
+
+        bool againstSideWall =
+            (brick.getBottomLeft().x < wallTolerance) ||
+            (brick.getTopRight().x > (MAZE_WIDTH - wallTolerance));
+        bool againstEndWall =
+            (brick.getBottomLeft().y < wallTolerance) ||
+            (brick.getTopRight().y > (MAZE_LENGTH - wallTolerance));
+
+        if (!againstSideWall) {
+            brick.position.x += offset.x * share;
+        }
+        if (!againstEndWall) {
+            brick.position.y += offset.y * share;
+        }
+    }
+
+    this->_brickCountAtLastClosure = this->_brickCount;
+}
+
 /**
  * @brief Appends 4 Brick structs to the list, representing the 4 boundary
  * walls.
@@ -230,6 +230,53 @@ class BrickList {
     int lowestDistance(Position target, int* indexOfClosestBrick_P = nullptr,
                        int* zoneFromClosestBrick_P = nullptr);
 
+    /**
+     * @brief Get the distance to the closest Brick in a chosen direction,
+     * Only works with orthogonal directions.
+     *
+     * @param robotPosition The position of the robot.
+     * @param directionOfBrick The direction to look in, will be rounded to the
+     * nearest right angle.
+     * @return (int) The distance to the Brick in the chosen direction.
+     * Returns -1 if no Brick was seen.
+     */
+    int getOrthogonalBrickDistance(Position robotPosition,
+                                   Angle directionOfBrick);
+
+    /**
+     * @brief Get the distance along a ray to the first Brick that it hits,
+     * this works in any direction, unlike getOrthogonalBrickDistance().
+     *
+     * Bricks that contain the origin of the ray are ignored.
+     *
+     * @param origin The position that the ray starts from.
+     * @param direction The direction of the ray.
+     * @param hitVerticalFace_P The pointer used to return whether the face
+     * that was hit runs vertically, along the y axis, rather than
+     * horizontally.
+     * @return (float) The distance along the ray to the first Brick hit.
+     * Returns -1 if no Brick was hit.
+     */
+    float rayCast(Position origin, Angle direction,
+                  bool* hitVerticalFace_P = nullptr);
+
+    /**
+     * @brief Gets the correction to the robot's position from the last loop
+     * closure, where a Brick already in the list was seen again, and clears
+     * it so that it is only applied once.
+     *
+     * @param offset_P The pointer used to return the offset to add to the
+     * robot's position.
+     * @param xObserved_P The pointer used to return whether the x position
+     * was measured by the loop closure.
+     * @param yObserved_P The pointer used to return whether the y position
+     * was measured by the loop closure.
+     * @return (true) If there has been a loop closure since the last call.
+     * @return (false) If there has been no loop closure.
+     */
+    bool getLoopClosure(Position* offset_P, bool* xObserved_P = nullptr,
+                        bool* yObserved_P = nullptr);
+
 #if DEBUG_ALLOW_PREFILLED_MAZE
     /**
      * @brief populates the Brick list with a set of hard coded Brick structs
@@ -261,6 +308,31 @@ class BrickList {
      */
     int _brickCount = 0;
 
+    /**
+     * @brief The number of Brick structs in the list at the last loop
+     * closure, the Bricks after this were placed while the robot's position
+     * was drifting.
+     */
+    int _brickCountAtLastClosure = 0;
+
+    /**
+     * @brief The correction to the robot's position from the last loop
+     * closure.
+     */
+    Position _loopClosureOffset;
+
+    /**
+     * @brief Whether the x and y positions were measured by the loop closures
+     * since the last was read.
+     */
+    bool _loopClosureXObserved = false;
+    bool _loopClosureYObserved = false;
+
+    /**
+     * @brief Whether there is a loop closure that hasn't been read yet.
+     */
+    bool _loopClosurePending = false;
+
     /**
      * @brief Compares a sensors reading the expected reading, obtained from the
      * existing items in the BrickList.
@@ -290,19 +362,6 @@ class BrickList {
      */
     Brick _getBrickFromEdge(Position brickEdgePosition, Angle angleOfSensor);
 
-    /**
-     * @brief Get the distance to the closest Brick in a chosen direction,
-     * Only works with orthogonal directions.
-     *
-     * @param robotPosition The position of the robot.
-     * @param directionOfBrick The direction to look in, will be rounded to the
-     * nearest right angle.
-     * @return (int) The distance to the Brick in the chosen direction.
-     * Returns -1 if no Brick was seen.
-     */
-    int _getOrthogonalBrickDistance(Position robotPosition,
-                                    Angle directionOfBrick);
-
     /**
      * @brief Add a Brick to the end of the BrickList, if there is space
      * remaining.
@@ -317,11 +376,33 @@ class BrickList {
      * @brief Adds a Brick the the end of the BrickList, if it does not collide
      * with an existing Brick in the list.
      *
+     * If the Brick is a fresh sighting of a Brick already in the list, it is
+     * used as a loop closure instead.
+     *
      * @param brickToAdd  The Brick to add.
+     * @param xObserved Whether the x position of the Brick was measured,
+     * rather than assumed from a wall.
+     * @param yObserved Whether the y position of the Brick was measured,
+     * rather than assumed from a wall.
      * @return (true) If the Brick was added to the list.
      * @return (false) If the Brick could not be added.
      */
-    bool _attemptAppendBrick(Brick brickToAdd);
+    bool _attemptAppendBrick(Brick brickToAdd, bool xObserved = true,
+                             bool yObserved = true);
+
+    /**
+     * @brief Uses a fresh sighting of a Brick already in the list to work out
+     * how far the robot's position has drifted, and spreads the drift back
+     * over the Bricks placed since the last loop closure.
+     *
+     * @param matchedIndex The index of the Brick that was seen again.
+     * @param offset The position of the Brick in the list minus the position
+     * it was seen at.
+     * @param xObserved Whether the x position of the Brick was measured.
+     * @param yObserved Whether the y position of the Brick was measured.
+     */
+    void _closeLoop(int matchedIndex, Position offset, bool xObserved,
+                    bool yObserved);
 
     /**
      * @brief Appends 4 Brick structs to the list, representing the 4 boundary
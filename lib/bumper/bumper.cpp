@@ -14,40 +14,29 @@
 #include <Arduino.h>
 
 #include "binary.h"
-
-// The number of buttons that make up the bumper.
-#define BUMPER_BUTTON_COUNT 8
+#include "shiftRegisterBus.h"
 
 /**
- * @brief Construct a new Bumper object, then sets the data pin to input,
- * and the load and clock pin to output.
+ * @brief Construct a new Bumper object.
  *
- * @param dataPin The pin connected to the data pin on the shift register.
- * @param loadPin The pin connected to the load pin on the shift register.
- * @param clockPin The pin connected to the clock pin on the shift register.
+ * @param shiftRegisterBus_P Pointer to the bus that reads the bumper's shift
+ * register.
  * @param bitOffset The number of bits that the data should be rotated by.
  */
-Bumper::Bumper(unsigned char dataPin, unsigned char loadPin,
-               unsigned char clockPin, unsigned char bitOffset)
-    : _dataPin(dataPin),
-      _loadPin(loadPin),
-      _clockPin(clockPin),
-      _bitOffset(bitOffset) {
-    pinMode(this->_dataPin, INPUT);
-    pinMode(this->_loadPin, OUTPUT);
-    pinMode(this->_clockPin, OUTPUT);
-}
+Bumper::Bumper(ShiftRegisterBus* shiftRegisterBus_P, unsigned char bitOffset)
+    : _shiftRegisterBus_P(shiftRegisterBus_P), _bitOffset(bitOffset) {}
 
 /**
- * @brief Reads the current state of the 8 buttons, as a single byte.
+ * @brief Reads the state of the 8 buttons as a single byte, from the most
+ * recent snapshot of the shift register bus.
  *
  * @return (unsigned char). The state of each button in the bumper, where the
  * lsb is the value of the front button, then the ascending bits represent the
  * subsequent buttons rotating clockwise
  */
 unsigned char Bumper::read() {
-    // Gets the raw data from the shift register
-    unsigned char rawData = this->_readRaw();
+    // Gets the raw data from the shift register bus.
+    unsigned char rawData = this->_shiftRegisterBus_P->getBumperData();
 
     // Rotates the data so that the value of the front button is the lsb of the
     // byte.
@@ -55,38 +44,3 @@ unsigned char Bumper::read() {
 
     return rotatedData;
 }
-
-/**
- * @brief Reads the raw data from the shift register.
- *
- * @return (unsigned char) The raw data read from the shift register.
- */
-unsigned char Bumper::_readRaw() {
-    // Create a byte for storing the received data from the shift register.
-    unsigned char shiftRegisterContents = 0;
-
-    // Pulse the load pin to load the button states into the shift
-    // register.
-    digitalWrite(this->_loadPin, LOW);
-    delayMicroseconds(1);
-    digitalWrite(this->_loadPin, HIGH);
-    delayMicroseconds(1);
-    digitalWrite(this->_loadPin, LOW);
-
-    // For each button,
-    for (int i = 0; i < BUMPER_BUTTON_COUNT; i++) {
-        // Shift the received data up by one.
-        shiftRegisterContents <<= 1;
-
-        // Load the available bit from the shift register into the lsb of the
-        // received byte.
-        shiftRegisterContents |= digitalRead(this->_dataPin);
-
-        // Pulse the clock pin to shift the data inside the shift register.
-        digitalWrite(this->_clockPin, LOW);
-        delayMicroseconds(1);
-        digitalWrite(this->_clockPin, HIGH);
-        delayMicroseconds(1);
-    }
-    return shiftRegisterContents;
-}
\ No newline at end of file
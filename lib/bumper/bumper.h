@@ -11,6 +11,9 @@
 #ifndef BUMPER_H
 #define BUMPER_H
 
+// Forward declaration of the ShiftRegisterBus class.
+class ShiftRegisterBus;
+
 /**
  * @brief The Bumper class, responsible for reading the state of the 8 buttons
  * that make up the bumper around the circumference of the robot.
@@ -19,19 +22,17 @@
 class Bumper {
    public:
     /**
-     * @brief Construct a new Bumper object, then sets the data pin to input,
-     * and the load and clock pin to output.
+     * @brief Construct a new Bumper object.
      *
-     * @param dataPin The pin connected to the data pin on the shift register.
-     * @param loadPin The pin connected to the load pin on the shift register.
-     * @param clockPin The pin connected to the clock pin on the shift register.
+     * @param shiftRegisterBus_P Pointer to the bus that reads the bumper's
+     * shift register.
      * @param bitOffset The number of bits that the data should be rotated by.
      */
-    Bumper(unsigned char dataPin, unsigned char loadPin, unsigned char clockPin,
-           unsigned char bitOffset);
-           
+    Bumper(ShiftRegisterBus* shiftRegisterBus_P, unsigned char bitOffset);
+
     /**
-     * @brief Reads the current state of the 8 buttons, as a single byte.
+     * @brief Reads the state of the 8 buttons as a single byte, from the most
+     * recent snapshot of the shift register bus.
      *
      * @return (unsigned char). The state of each button in the bumper, where
      * the lsb is the value of the front button, then the ascending bits
@@ -41,29 +42,14 @@ class Bumper {
 
    private:
     /**
-     * @brief The pin connected to the data pin on the shift register.
-     */
-    unsigned char _dataPin;
-    /**
-     * @brief The pin connected to the load pin on the shift register.
-     */
-    unsigned char _loadPin;
-    /**
-     * @brief The pin connected to the clock pin on the shift register.
+     * @brief Pointer to the bus that reads the bumper's shift register.
      */
-    unsigned char _clockPin;
+    ShiftRegisterBus* _shiftRegisterBus_P;
 
     /**
      * @brief The number of bits that the data should be rotated by.
      */
     unsigned char _bitOffset;
-
-    /**
-     * @brief Reads the raw data from the shift register.
-     *
-     * @return (unsigned char) The raw data read from the shift register.
-     */
-    unsigned char _readRaw();
 };
 
 #endif  // BUMPER_H
@@ -0,0 +1,140 @@
+/**
+ * @file driftObserver.cpp
+ * @brief Definition of the DriftObserver class, responsible for correcting
+ * the heading of the robot from the front infrared sensors while it drives
+ * towards a known wall or Brick.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-10
+ * @copyright Copyright (c) 2024
+ */
+#include "driftObserver.h"
+
+#include "brick.h"
+#include "frontRange.h"
+#include "motionTracker.h"
+
+// The period in milliseconds between checks of the wall.
+#define DRIFT_OBSERVER_POLL_RATE 50
+
+// The furthest a wall can be in millimeters for its angle to be trusted, the
+// infrared sensors get noisier the further away the wall is.
+#define DRIFT_MAX_WALL_DISTANCE 300
+
+// How far in millimeters the distance to the wall can be from the distance
+// to the closest known face before the wall is treated as unknown.
+#define DRIFT_DISTANCE_TOLERANCE 30
+
+// The largest offset from a right angle in degrees that the robot can be at
+// for the wall in front of it to be treated as square on.
+#define DRIFT_MAX_EXPECTED_ANGLE 15
+
+// The largest difference in degrees between the measured and expected angles
+// that is treated as drift, anything bigger is treated as a bad reading.
+#define DRIFT_MAX_INNOVATION 8.0f
+
+// The fraction of the difference between the measured and expected angles to
+// correct on each check, kept small so that the noise averages out.
+#define DRIFT_CORRECTION_GAIN 0.1f
+
+// The largest correction in degrees to apply on a single check.
+#define DRIFT_MAX_CORRECTION 0.5f
+
+// The most the heading can change between checks, in degrees, for the robot
+// to count as driving straight rather than turning.
+#define DRIFT_MAX_TURN_PER_POLL 1.0f
+
+/**
+ * @brief Construct a new DriftObserver object.
+ *
+ * @param motionTracker_P Pointer to the motion tracker to correct.
+ * @param frontRange_P Pointer to the front range, used to read the distance
+ * and angle of the wall in front of the robot.
+ * @param brickList_P Pointer to the BrickList, used to check that the wall in
+ * front of the robot is a known face.
+ */
+DriftObserver::DriftObserver(MotionTracker* motionTracker_P,
+                             FrontRange* frontRange_P, BrickList* brickList_P)
+    : _motionTracker_P(motionTracker_P),
+      _frontRange_P(frontRange_P),
+      _brickList_P(brickList_P),
+      _pollSchedule(DRIFT_OBSERVER_POLL_RATE) {}
+
+/**
+ * @brief Checks the wall in front of the robot, and if it is a known face,
+ * applies a correction to the heading of the robot.
+ *
+ * @return (true) If a correction was applied.
+ * @return (false) If no correction was applied.
+ */
+bool DriftObserver::poll() {
+    if (!this->_pollSchedule.isReadyToRun()) {
+        return false;
+    }
+
+    Pose robotPose = this->_motionTracker_P->getPose();
+
+    // The infrared readings are compensated for distance traveled but not for
+    // rotation, so the wall angle can't be trusted while the robot turns.
+    float turnSinceLastPoll = (robotPose.angle - this->_lastAngle).getDegrees();
+    this->_lastAngle = robotPose.angle;
+
+    if (abs(turnSinceLastPoll) > DRIFT_MAX_TURN_PER_POLL) {
+        return false;
+    }
+
+    // As every face is orthogonal, the wall should appear at the offset of
+    // the heading from the closest right angle.
+    float expectedAngle = robotPose.angle.OrthogonalOffset().getDegrees();
+
+    if (abs(expectedAngle) > DRIFT_MAX_EXPECTED_ANGLE) {
+        return false;
+    }
+
+    float measuredAngle;
+    if (!this->_frontRange_P->readWallAngle(&measuredAngle)) {
+        return false;
+    }
+
+    int frontDistance = this->_frontRange_P->read();
+    if ((frontDistance == -1) || (frontDistance > DRIFT_MAX_WALL_DISTANCE)) {
+        return false;
+    }
+
+    // Only use the wall if it is where a known face should be.
+    int expectedDistance = this->_brickList_P->getOrthogonalBrickDistance(
+        robotPose.position, robotPose.angle);
+
+    if ((expectedDistance == -1) ||
+        (abs(frontDistance - expectedDistance) > DRIFT_DISTANCE_TOLERANCE)) {
+        return false;
+    }
+
+    // The measured angle is how far the robot really is from square, so the
+    // difference from the expected angle is how far the heading has drifted.
+    float innovation = expectedAngle - measuredAngle;
+
+    if (abs(innovation) > DRIFT_MAX_INNOVATION) {
+        return false;
+    }
+
+    float correction =
+        constrain(innovation * DRIFT_CORRECTION_GAIN, -DRIFT_MAX_CORRECTION,
+                  DRIFT_MAX_CORRECTION);
+
+    this->_motionTracker_P->applyAngleCorrection(
+        Angle::fromDegrees(correction));
+
+    this->_lastAngle = this->_motionTracker_P->getAngle();
+    this->_totalCorrection += correction;
+
+    return true;
+}
+
+/**
+ * @brief Gets the total correction applied to the heading since the robot
+ * started, useful for checking how much the heading drifts.
+ *
+ * @return (float) The total correction in degrees.
+ */
+float DriftObserver::getTotalCorrection() { return this->_totalCorrection; }
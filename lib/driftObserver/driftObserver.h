@@ -0,0 +1,99 @@
+/**
+ * @file driftObserver.h
+ * @brief Declaration of the DriftObserver class, responsible for correcting
+ * the heading of the robot from the front infrared sensors while it drives
+ * towards a known wall or Brick.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-10
+ * @copyright Copyright (c) 2024
+ */
+#ifndef DRIFT_OBSERVER_H
+#define DRIFT_OBSERVER_H
+
+#include <Arduino.h>
+
+#include "angleAndPosition.h"
+#include "schedule.h"
+
+// Forward declaration of the MotionTracker, FrontRange and BrickList classes.
+class MotionTracker;
+class FrontRange;
+class BrickList;
+
+/**
+ * @brief DriftObserver class, compares the angle of the wall measured by the
+ * front infrared sensors with the angle expected from the heading of the
+ * robot, and feeds a small part of the difference back into the motion
+ * tracker.
+ *
+ * Every Brick and wall in the maze is orthogonal, so the expected angle of any
+ * known face is just the offset of the robot's heading from the closest right
+ * angle. Only faces already in the BrickList are used, so that the corner of
+ * an unknown Brick can't be mistaken for a skewed wall.
+ */
+class DriftObserver {
+   public:
+    /**
+     * @brief Construct a new DriftObserver object.
+     *
+     * @param motionTracker_P Pointer to the motion tracker to correct.
+     * @param frontRange_P Pointer to the front range, used to read the
+     * distance and angle of the wall in front of the robot.
+     * @param brickList_P Pointer to the BrickList, used to check that the
+     * wall in front of the robot is a known face.
+     */
+    DriftObserver(MotionTracker* motionTracker_P, FrontRange* frontRange_P,
+                  BrickList* brickList_P);
+
+    /**
+     * @brief Checks the wall in front of the robot, and if it is a known face,
+     * applies a correction to the heading of the robot.
+     *
+     * @return (true) If a correction was applied.
+     * @return (false) If no correction was applied.
+     */
+    bool poll();
+
+    /**
+     * @brief Gets the total correction applied to the heading since the robot
+     * started, useful for checking how much the heading drifts.
+     *
+     * @return (float) The total correction in degrees.
+     */
+    float getTotalCorrection();
+
+   private:
+    /**
+     * @brief Pointer to the motion tracker.
+     */
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief Pointer to the front range.
+     */
+    FrontRange* _frontRange_P;
+
+    /**
+     * @brief Pointer to the BrickList.
+     */
+    BrickList* _brickList_P;
+
+    /**
+     * @brief The heading of the robot on the last poll, used to skip polls
+     * where the robot is turning.
+     */
+    Angle _lastAngle = 0;
+
+    /**
+     * @brief The total correction applied in degrees.
+     */
+    float _totalCorrection = 0;
+
+    /**
+     * @brief The schedule that limits how often the wall is checked.
+     */
+    PassiveSchedule _pollSchedule;
+};
+
+#endif  // DRIFT_OBSERVER_H
@@ -9,6 +9,7 @@
  */
 #include "drive.h"
 
+#include "angleAndPosition.h"
 #include "motor.h"
 
 /**
@@ -16,18 +17,27 @@
  *
  * @param leftMotor_P Pointer to the left motor object.
  * @param rightMotor_P Pointer to the right motor object.
- * @param defaultSpeed (int) The percentage of the motor's max seed to use
- * as default.
+ * @param defaultSpeed (int) The speed in millimeters per second to use as
+ * default.
+ * @param defaultTurnSpeed (int) The rotational speed in degrees per
+ * second to use as default.
  */
-Drive::Drive(Motor* leftMotor_P, Motor* rightMotor_P, int defaultSpeed)
+Drive::Drive(Motor* leftMotor_P, Motor* rightMotor_P, int defaultSpeed,
+             int defaultTurnSpeed)
     : _leftMotor_P(leftMotor_P),
       _rightMotor_P(rightMotor_P),
-      _defaultSpeed(defaultSpeed) {}
+      _leftController(leftMotor_P),
+      _rightController(rightMotor_P),
+      _defaultSpeed(defaultSpeed),
+      _defaultTurnSpeed(defaultTurnSpeed),
+      _wheelDifferencePerRotation(WHEEL_DIFFERENCE_PER_ROTATION) {}
 
 /**
  * @brief Sets the speed of both motors based on a bipolar percentage of
  * their maximum speeds, allowing for both linear and rotational velocities.
  *
+ * This bypasses the speed controllers, until the next call to setSpeed().
+ *
  * The speeds are calculated as
  * - Left motor velocity = linearVelocity - rotationalVelocity
  * - right motor velocity = linearVelocity + rotationalVelocity
@@ -48,6 +58,8 @@ Drive::Drive(Motor* leftMotor_P, Motor* rightMotor_P, int defaultSpeed)
  * direction as a bipolar percentage [-100,100].
  */
 void Drive::setVelocity(int linearVelocity, int rotationalVelocity) {
+    this->_closedLoop = false;
+
     int leftVelocity = linearVelocity - rotationalVelocity;
     leftVelocity = constrain(leftVelocity, -100, 100);
 
@@ -58,16 +70,160 @@ void Drive::setVelocity(int linearVelocity, int rotationalVelocity) {
     this->_rightMotor_P->setVelocity(rightVelocity);
 }
 
+/**
+ * @brief Sets the speed of the robot, which the speed controllers then
+ * hold each wheel at.
+ *
+ * A positive linearSpeed moves the robot forwards.
+ * A positive rotationalSpeed rotates the robot counter-clockwise.
+ *
+ * @param linearSpeed The speed of the centre of the robot in millimeters
+ * per second.
+ * @param rotationalSpeed The rotational speed of the robot in degrees per
+ * second, set to 0 by default.
+ */
+void Drive::setSpeed(float linearSpeed, float rotationalSpeed) {
+    this->_requestedLinearSpeed = linearSpeed;
+    this->_requestedRotationalSpeed = rotationalSpeed;
+
+    linearSpeed *= this->_speedScale;
+    rotationalSpeed *= this->_speedScale;
+
+    // Slow the rotation by as much as the limit slows the linear speed, so
+    // that the robot still follows the same arc, just more slowly.
+    if ((this->_speedLimit != -1) && (linearSpeed > this->_speedLimit)) {
+        rotationalSpeed *= this->_speedLimit / linearSpeed;
+        linearSpeed = this->_speedLimit;
+    }
+
+    // If the motors were being driven directly, start the controllers from a
+    // standstill.
+    if (!this->_closedLoop) {
+        this->_leftController.reset();
+        this->_rightController.reset();
+        this->_closedLoop = true;
+    }
+
+    // To turn a full rotation, the right wheel has to travel
+    // _wheelDifferencePerRotation further than the left wheel, with each
+    // wheel doing half of the difference.
+    float wheelSpeedDifference = rotationalSpeed *
+                                 this->_wheelDifferencePerRotation /
+                                 (2 * DEGREES_PER_ROTATION);
+
+    this->_leftController.setTargetSpeed(linearSpeed - wheelSpeedDifference);
+    this->_rightController.setTargetSpeed(linearSpeed + wheelSpeedDifference);
+}
+
+/**
+ * @brief Updates the speed controllers, this should be called every loop.
+ */
+void Drive::poll() {
+    if (!this->_closedLoop) {
+        return;
+    }
+
+    this->_leftController.poll();
+    this->_rightController.poll();
+}
+
+/**
+ * @brief Gets the speed that the left wheel is currently being driven at by
+ * its speed controller.
+ *
+ * @return (float) The commanded speed in millimeters per second, or 0 if the
+ * motors are not being driven by the speed controllers.
+ */
+float Drive::getLeftCommandedSpeed() {
+    if (!this->_closedLoop) {
+        return 0;
+    }
+    return this->_leftController.getRampedSpeed();
+}
+
+/**
+ * @brief Gets the speed that the right wheel is currently being driven at by
+ * its speed controller.
+ *
+ * @return (float) The commanded speed in millimeters per second, or 0 if the
+ * motors are not being driven by the speed controllers.
+ */
+float Drive::getRightCommandedSpeed() {
+    if (!this->_closedLoop) {
+        return 0;
+    }
+    return this->_rightController.getRampedSpeed();
+}
+
+/**
+ * @brief Sets the speed used by forwards() and backwards().
+ *
+ * @param defaultSpeed The speed in millimeters per second to use as default.
+ */
+void Drive::setDefaultSpeed(int defaultSpeed) {
+    this->_defaultSpeed = defaultSpeed;
+}
+
+/**
+ * @brief Sets the difference in millimeters traveled by the two wheels for the
+ * robot to turn a full rotation, used to convert rotational speeds into wheel
+ * speeds.
+ *
+ * @param wheelDifferencePerRotation The difference in millimeters.
+ */
+void Drive::setWheelDifferencePerRotation(float wheelDifferencePerRotation) {
+    this->_wheelDifferencePerRotation = wheelDifferencePerRotation;
+}
+
+/**
+ * @brief Limits how fast the robot can drive forwards, whatever speed is asked
+ * for by setSpeed(). The limit applies to the current speed straight away,
+ * and the rotation is slowed by the same proportion so that the robot keeps to
+ * the same arc.
+ *
+ * @param speedLimit The fastest the centre of the robot can move forwards in
+ * millimeters per second, or -1 for no limit.
+ */
+void Drive::setSpeedLimit(float speedLimit) {
+    this->_speedLimit = speedLimit;
+
+    // Only the speed controllers can be limited, the motors being driven
+    // directly are left alone.
+    if (this->_closedLoop) {
+        this->setSpeed(this->_requestedLinearSpeed,
+                       this->_requestedRotationalSpeed);
+    }
+}
+
+/**
+ * @brief Scales every speed asked for by setSpeed(), both linear and
+ * rotational, so that the robot can be slowed down whichever part of the code
+ * is driving it. The scale applies to the current speed straight away, and is
+ * applied before the speed limit.
+ *
+ * @param speedScale The fraction of the asked for speed to drive at, 1 for
+ * full speed.
+ */
+void Drive::setSpeedScale(float speedScale) {
+    this->_speedScale = speedScale;
+
+    if (this->_closedLoop) {
+        this->setSpeed(this->_requestedLinearSpeed,
+                       this->_requestedRotationalSpeed);
+    }
+}
+
 /**
  * @brief Drives the robot forwards at the default speed, allowing for an
  * optional slight offset in rotational velocity.
  *
  * A positive offsetRotationalVelocity with turn the robot counter-clockwise
  *
- * @param offsetRotationalVelocity
+ * @param offsetRotationalVelocity The rotational speed in degrees per
+ * second.
  */
 void Drive::forwards(int offsetRotationalVelocity) {
-    this->setVelocity(this->_defaultSpeed, offsetRotationalVelocity);
+    this->setSpeed(this->_defaultSpeed, offsetRotationalVelocity);
 }
 
 /**
@@ -76,43 +232,46 @@ void Drive::forwards(int offsetRotationalVelocity) {
  *
  * A positive offsetRotationalVelocity with turn the robot counter-clockwise
  *
- * @param offsetRotationalVelocity
+ * @param offsetRotationalVelocity The rotational speed in degrees per
+ * second.
  */
-void Drive::backwards(int offset) {
-    this->setVelocity(-(this->_defaultSpeed), offset);
+void Drive::backwards(int offsetRotationalVelocity) {
+    this->setSpeed(-(this->_defaultSpeed), offsetRotationalVelocity);
 }
 
 /**
- * @brief Starts rotating the robot counter-clockwise, by setting the right
- * motor to the default speed and the left motor to the negative default
- * speed.
+ * @brief Starts rotating the robot counter-clockwise on the spot, at the
+ * default turn speed.
  */
 void Drive::turnLeft() {
-    // Set the linear velocity to 0, and the rotational velocity to the default
+    // Set the linear speed to 0, and the rotational speed to the default turn
     // speed.
-    this->setVelocity(0, this->_defaultSpeed);
+    this->setSpeed(0, this->_defaultTurnSpeed);
 }
 
 /**
- * @brief Starts rotating the robot clockwise, by setting the right motor to
- * the negative default speed and the left motor to the default speed.
+ * @brief Starts rotating the robot clockwise on the spot, at the default
+ * turn speed.
  */
 void Drive::turnRight() {
-    // Set the linear velocity to 0, and the rotational velocity to the negative
-    // default speed.
-    this->setVelocity(0, -this->_defaultSpeed);
+    // Set the linear speed to 0, and the rotational speed to the negative
+    // default turn speed.
+    this->setSpeed(0, -this->_defaultTurnSpeed);
 }
 
 /**
  * @brief Spins the robot clockwise as full speed.
  * This function should be used sparingly.
  */
-void Drive::fullSpeedSpinLeft() {
-    this->_leftMotor_P->setVelocity(-100);
-    this->_rightMotor_P->setVelocity(100);
-}
+void Drive::fullSpeedSpinLeft() { this->setVelocity(0, 100); }
 
 /**
- * @brief Stops the robot by setting both motors to 0% speed.
+ * @brief Stops the robot straight away, by setting both motors to 0% speed
+ * and clearing the speed controllers.
  */
-void Drive::stop() { this->setVelocity(0); }
\ No newline at end of file
+void Drive::stop() {
+    this->setVelocity(0);
+
+    this->_leftController.reset();
+    this->_rightController.reset();
+}
@@ -10,6 +10,12 @@
 #ifndef DRIVE_H
 #define DRIVE_H
 
+#include "speedController.h"
+
+// The rotational velocity in degrees per second to correct by, for each
+// degree that the robot is off its heading.
+#define HEADING_CORRECTION_GAIN 5
+
 // Forward declaration of the Motor class.
 class Motor;
 
@@ -23,15 +29,20 @@ class Drive {
      *
      * @param leftMotor_P Pointer to the left motor object.
      * @param rightMotor_P Pointer to the right motor object.
-     * @param defaultSpeed (int) The percentage of the motor's max speed to use
-     * as default.
+     * @param defaultSpeed (int) The speed in millimeters per second to use as
+     * default.
+     * @param defaultTurnSpeed (int) The rotational speed in degrees per
+     * second to use as default.
      */
-    Drive(Motor* leftMotor_P, Motor* rightMotor_P, int defaultSpeed);
+    Drive(Motor* leftMotor_P, Motor* rightMotor_P, int defaultSpeed,
+          int defaultTurnSpeed);
 
     /**
      * @brief Sets the speed of both motors based on a bipolar percentage of
      * their maximum speeds, allowing for both linear and rotational velocities.
      *
+     * This bypasses the speed controllers, until the next call to setSpeed().
+     *
      * The speeds are calculated as
      * - Left motor velocity = linearVelocity - rotationalVelocity
      * - right motor velocity = linearVelocity + rotationalVelocity
@@ -53,12 +64,89 @@ class Drive {
      */
     void setVelocity(int linearVelocity, int rotationalVelocity = 0);
 
+    /**
+     * @brief Sets the speed of the robot, which the speed controllers then
+     * hold each wheel at.
+     *
+     * A positive linearSpeed moves the robot forwards.
+     * A positive rotationalSpeed rotates the robot counter-clockwise.
+     *
+     * @param linearSpeed The speed of the centre of the robot in millimeters
+     * per second.
+     * @param rotationalSpeed The rotational speed of the robot in degrees per
+     * second, set to 0 by default.
+     */
+    void setSpeed(float linearSpeed, float rotationalSpeed = 0);
+
+    /**
+     * @brief Updates the speed controllers, this should be called every loop.
+     */
+    void poll();
+
+    /**
+     * @brief Gets the speed that the left wheel is currently being driven at
+     * by its speed controller.
+     *
+     * @return (float) The commanded speed in millimeters per second, or 0 if
+     * the motors are not being driven by the speed controllers.
+     */
+    float getLeftCommandedSpeed();
+
+    /**
+     * @brief Gets the speed that the right wheel is currently being driven at
+     * by its speed controller.
+     *
+     * @return (float) The commanded speed in millimeters per second, or 0 if
+     * the motors are not being driven by the speed controllers.
+     */
+    float getRightCommandedSpeed();
+
+    /**
+     * @brief Sets the speed used by forwards() and backwards().
+     *
+     * @param defaultSpeed The speed in millimeters per second to use as
+     * default.
+     */
+    void setDefaultSpeed(int defaultSpeed);
+
+    /**
+     * @brief Sets the difference in millimeters traveled by the two wheels for
+     * the robot to turn a full rotation, used to convert rotational speeds
+     * into wheel speeds.
+     *
+     * @param wheelDifferencePerRotation The difference in millimeters.
+     */
+    void setWheelDifferencePerRotation(float wheelDifferencePerRotation);
+
+    /**
+     * @brief Limits how fast the robot can drive forwards, whatever speed is
+     * asked for by setSpeed(). The limit applies to the current speed straight
+     * away, and the rotation is slowed by the same proportion so that the
+     * robot keeps to the same arc.
+     *
+     * @param speedLimit The fastest the centre of the robot can move forwards
+     * in millimeters per second, or -1 for no limit.
+     */
+    void setSpeedLimit(float speedLimit);
+
+    /**
+     * @brief Scales every speed asked for by setSpeed(), both linear and
+     * rotational, so that the robot can be slowed down whichever part of the
+     * code is driving it. The scale applies to the current speed straight
+     * away, and is applied before the speed limit.
+     *
+     * @param speedScale The fraction of the asked for speed to drive at, 1
+     * for full speed.
+     */
+    void setSpeedScale(float speedScale);
+
     /**
      * @brief Drives the robot forwards at the default speed, allowing for an
      * optional slight offset in rotational velocity.
      *
-     * @param offsetRotationalVelocity A positive offsetRotationalVelocity with
-     * turn the robot counter-clockwise.
+     * @param offsetRotationalVelocity The rotational speed in degrees per
+     * second, a positive offsetRotationalVelocity with turn the robot
+     * counter-clockwise.
      */
     void forwards(int offsetRotationalVelocity = 0);
 
@@ -66,21 +154,21 @@ class Drive {
      * @brief Drives the robot backwards at the default speed, allowing for an
      * optional slight offset in rotational velocity.
      *
-     * @param offsetRotationalVelocity A positive offsetRotationalVelocity with
-     * turn the robot counter-clockwise.
+     * @param offsetRotationalVelocity The rotational speed in degrees per
+     * second, a positive offsetRotationalVelocity with turn the robot
+     * counter-clockwise.
      */
     void backwards(int offsetRotationalVelocity = 0);
 
     /**
-     * @brief Starts rotating the robot counter-clockwise, by setting the right
-     * motor to the default speed and the left motor to the negative default
-     * speed.
+     * @brief Starts rotating the robot counter-clockwise on the spot, at the
+     * default turn speed.
      */
     void turnLeft();
 
     /**
-     * @brief Starts rotating the robot clockwise, by setting the right motor to
-     * the negative default speed and the left motor to the default speed.
+     * @brief Starts rotating the robot clockwise on the spot, at the default
+     * turn speed.
      */
     void turnRight();
 
@@ -91,7 +179,8 @@ class Drive {
     void fullSpeedSpinLeft();
 
     /**
-     * @brief Stops the robot by setting both motors to 0% speed.
+     * @brief Stops the robot straight away, by setting both motors to 0% speed
+     * and clearing the speed controllers.
      */
     void stop();
 
@@ -106,9 +195,54 @@ class Drive {
     Motor* _rightMotor_P;
 
     /**
-     * @brief The percentage of the motor's max speed to use as default.
+     * @brief The speed controller for the left wheel.
+     */
+    SpeedController _leftController;
+    /**
+     * @brief The speed controller for the right wheel.
+     */
+    SpeedController _rightController;
+
+    /**
+     * @brief Whether the motors are being driven by the speed controllers, or
+     * directly by setVelocity().
+     */
+    bool _closedLoop = false;
+
+    /**
+     * @brief The speed in millimeters per second to use as default.
      */
     int _defaultSpeed;
+
+    /**
+     * @brief The rotational speed in degrees per second to use as default.
+     */
+    int _defaultTurnSpeed;
+
+    /**
+     * @brief The difference in millimeters traveled by the two wheels for the
+     * robot to turn a full rotation.
+     */
+    float _wheelDifferencePerRotation;
+
+    /**
+     * @brief The fastest the robot can drive forwards in millimeters per
+     * second, or -1 for no limit.
+     */
+    float _speedLimit = -1;
+
+    /**
+     * @brief The fraction of the speeds asked for by setSpeed() to drive at.
+     */
+    float _speedScale = 1;
+
+    /**
+     * @brief The speeds last asked for by setSpeed(), before the scale and the
+     * speed limit were applied, so that they can be restored when either
+     * rises.
+     */
+    float _requestedLinearSpeed = 0;
+    float _requestedRotationalSpeed = 0;
 };
 
-#endif  // DRIVE_H
\ No newline at end of file
+#endif  // DRIVE_H
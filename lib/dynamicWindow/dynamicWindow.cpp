@@ -0,0 +1,231 @@
+/**
+ * @file dynamicWindow.cpp
+ * @brief Definition of the DynamicWindow class, a local planner responsible
+ * for choosing the speed of the robot as it follows the solved Map.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-08
+ * @copyright Copyright (c) 2024
+ */
+#include "dynamicWindow.h"
+
+#include "angleAndPosition.h"
+#include "drive.h"
+#include "map.h"
+#include "motionTracker.h"
+
+// The period in milliseconds between plans.
+#define PLAN_PERIOD 50
+
+// The accelerations the window is limited to, in millimeters per second
+// squared and degrees per second squared.
+#define WINDOW_ACCELERATION 600
+#define WINDOW_TURN_ACCELERATION 600
+
+// The number of speeds sampled across the window, for linear and rotational
+// speed.
+#define SPEED_SAMPLES 5
+#define TURN_SPEED_SAMPLES 9
+
+// How far ahead each trajectory is rolled forward, as a number of steps of a
+// given length in seconds. The horizon needs to be longer than the time it
+// takes to stop from full speed.
+#define ROLLOUT_STEPS 10
+#define ROLLOUT_STEP_TIME 0.1f
+
+// The weights given to the progress made towards the goal, the closest
+// distance to a wall, and the speed.
+#define PROGRESS_WEIGHT 1.0f
+#define CLEARANCE_WEIGHT 0.1f
+#define SPEED_WEIGHT 0.02f
+
+// Clearance beyond this distance in millimeters doesn't improve the score.
+#define MAX_USEFUL_CLEARANCE 200
+
+// The rotational speed in degrees per second to turn on the spot at, if
+// there are no safe trajectories.
+#define RECOVERY_TURN_SPEED 60
+
+/**
+ * @brief Construct a new DynamicWindow object.
+ *
+ * @param motionTracker_P Pointer to the motion tracker, used to get the
+ * pose of the robot.
+ * @param drive_P Pointer to the drive object, used to set the speed of the
+ * robot.
+ * @param map_P Pointer to the solved map to follow.
+ * @param maxSpeed The fastest linear speed in millimeters per second.
+ * @param maxTurnSpeed The fastest rotational speed in degrees per second.
+ */
+DynamicWindow::DynamicWindow(MotionTracker* motionTracker_P, Drive* drive_P,
+                             Map* map_P, int maxSpeed, int maxTurnSpeed)
+    : _motionTracker_P(motionTracker_P),
+      _drive_P(drive_P),
+      _map_P(map_P),
+      _maxSpeed(maxSpeed),
+      _maxTurnSpeed(maxTurnSpeed),
+      _planSchedule(PLAN_PERIOD) {}
+
+/**
+ * @brief Chooses and sets the speed of the robot, at a fixed rate. This
+ * should be called every loop while following the map.
+ */
+void DynamicWindow::plan() {
+    if (!this->_planSchedule.isReadyToRun()) {
+        return;
+    }
+
+    const float planTime = PLAN_PERIOD / 1000.0f;
+
+    // The window of speeds that can be reached before the next plan.
+    float minSpeed = max(this->_speed - WINDOW_ACCELERATION * planTime, 0.0f);
+    float maxSpeed = min(this->_speed + WINDOW_ACCELERATION * planTime,
+                         (float)this->_maxSpeed);
+
+    // If the max speed has dropped by more than the robot can slow down
+    // between plans, slow down as quickly as the speed controllers allow
+    // rather than going over it.
+    minSpeed = min(minSpeed, maxSpeed);
+
+    float minTurnSpeed =
+        max(this->_turnSpeed - WINDOW_TURN_ACCELERATION * planTime,
+            (float)-this->_maxTurnSpeed);
+    float maxTurnSpeed =
+        min(this->_turnSpeed + WINDOW_TURN_ACCELERATION * planTime,
+            (float)this->_maxTurnSpeed);
+
+    Pose robotPose = this->_motionTracker_P->getPose();
+
+    bool foundTrajectory = false;
+    float bestScore = 0;
+    float bestSpeed = 0;
+    float bestTurnSpeed = 0;
+
+    for (int i = 0; i < SPEED_SAMPLES; i++) {
+        float speed =
+            minSpeed + (maxSpeed - minSpeed) * i / (SPEED_SAMPLES - 1);
+
+        for (int j = 0; j < TURN_SPEED_SAMPLES; j++) {
+            float turnSpeed = minTurnSpeed + (maxTurnSpeed - minTurnSpeed) * j /
+                                                 (TURN_SPEED_SAMPLES - 1);
+
+            float score;
+            if (!this->_scoreTrajectory(robotPose, speed, turnSpeed,
+                                        &score)) {
+                continue;
+            }
+
+            if (!foundTrajectory || (score > bestScore)) {
+                foundTrajectory = true;
+                bestScore = score;
+                bestSpeed = speed;
+                bestTurnSpeed = turnSpeed;
+            }
+        }
+    }
+
+    // If every trajectory hits something, stop and turn towards the
+    // direction that the map says to drive.
+    if (!foundTrajectory) {
+        Angle angleToDrive = robotPose.angle;
+        this->_map_P->updateAngleToDrive(robotPose.position, &angleToDrive);
+        Angle angleToTurn = angleToDrive - robotPose.angle;
+
+        bestSpeed = 0;
+        bestTurnSpeed = (angleToTurn.getDegrees() >= 0) ? RECOVERY_TURN_SPEED
+                                                        : -RECOVERY_TURN_SPEED;
+    }
+
+    this->_speed = bestSpeed;
+    this->_turnSpeed = bestTurnSpeed;
+
+    this->_drive_P->setSpeed(this->_speed, this->_turnSpeed);
+}
+
+/**
+ * @brief Resets the planner so that the next plan starts from a
+ * standstill, this should be called whenever the robot is stopped.
+ */
+void DynamicWindow::reset() {
+    this->_speed = 0;
+    this->_turnSpeed = 0;
+}
+
+/**
+ * @brief Sets the fastest linear speed that the planner can choose, so that
+ * the robot can speed up and slow down along the map.
+ *
+ * @param maxSpeed The fastest linear speed in millimeters per second.
+ */
+void DynamicWindow::setMaxSpeed(int maxSpeed) { this->_maxSpeed = maxSpeed; }
+
+/**
+ * @brief Rolls a pair of speeds forward from the robot's pose, and scores
+ * the resulting trajectory.
+ *
+ * @param startPose The pose of the robot.
+ * @param speed The linear speed in millimeters per second.
+ * @param turnSpeed The rotational speed in degrees per second.
+ * @param score_P The pointer used to return the score of the trajectory.
+ * @return (true) If the trajectory stays clear of any blocked cells.
+ * @return (false) If the trajectory would hit something.
+ */
+bool DynamicWindow::_scoreTrajectory(Pose startPose, float speed,
+                                     float turnSpeed, float* score_P) {
+    Position position = startPose.position;
+    float heading = startPose.angle.getRadians();
+
+    int startDistanceToGoal = this->_map_P->getDistanceToGoal(position);
+    int startClearance = this->_map_P->getDistanceToWall(position);
+
+    float stepDistance = speed * ROLLOUT_STEP_TIME;
+    float stepTurn = turnSpeed * RADIANS_PER_DEGREE * ROLLOUT_STEP_TIME;
+
+    int lowestClearance = MAX_USEFUL_CLEARANCE;
+    int endDistanceToGoal = startDistanceToGoal;
+
+    for (int step = 0; step < ROLLOUT_STEPS; step++) {
+        // Move along the heading half way through the step, which follows the
+        // arc closely.
+        float midHeading = heading + stepTurn / 2;
+        position.x += stepDistance * cosf(midHeading);
+        position.y += stepDistance * sinf(midHeading);
+        heading += stepTurn;
+
+        int clearance = this->_map_P->getDistanceToWall(position);
+
+        // Never drive off the map.
+        if (clearance == -1) {
+            return false;
+        }
+
+        int distanceToGoal = this->_map_P->getDistanceToGoal(position);
+
+        // Blocked cells are closer to a wall than the radius of the robot, so
+        // are only allowed if the robot is already in one, and is moving away
+        // from the wall.
+        if (distanceToGoal == -1) {
+            bool startedBlocked = (startDistanceToGoal == -1);
+
+            if (!startedBlocked || (clearance < startClearance)) {
+                return false;
+            }
+        } else {
+            endDistanceToGoal = distanceToGoal;
+        }
+
+        lowestClearance = min(lowestClearance, clearance);
+    }
+
+    // If the robot started in a blocked cell, progress can't be measured, so
+    // only clearance and speed count.
+    float progress = 0;
+    if (startDistanceToGoal != -1) {
+        progress = startDistanceToGoal - endDistanceToGoal;
+    }
+
+    *score_P = (PROGRESS_WEIGHT * progress) +
+               (CLEARANCE_WEIGHT * lowestClearance) + (SPEED_WEIGHT * speed);
+
+    return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file dynamicWindow.h
+ * @brief Declaration of the DynamicWindow class, a local planner responsible
+ * for choosing the speed of the robot as it follows the solved Map.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-08
+ * @copyright Copyright (c) 2024
+ */
+#ifndef DYNAMIC_WINDOW_H
+#define DYNAMIC_WINDOW_H
+
+#include <Arduino.h>
+
+#include "angleAndPosition.h"
+#include "schedule.h"
+
+// Forward declaration of the MotionTracker, Drive and Map classes.
+class MotionTracker;
+class Drive;
+class Map;
+
+/**
+ * @brief DynamicWindow class, a Dynamic Window Approach planner.
+ *
+ * Every planning period, pairs of linear and rotational speeds that the robot
+ * can reach within its acceleration limits are sampled. Each pair is rolled
+ * forward over a short horizon across the Map, and the pair that makes the
+ * most progress towards the goal, while keeping clear of walls and keeping
+ * the speed up, is sent to the Drive.
+ */
+class DynamicWindow {
+   public:
+    /**
+     * @brief Construct a new DynamicWindow object.
+     *
+     * @param motionTracker_P Pointer to the motion tracker, used to get the
+     * pose of the robot.
+     * @param drive_P Pointer to the drive object, used to set the speed of the
+     * robot.
+     * @param map_P Pointer to the solved map to follow.
+     * @param maxSpeed The fastest linear speed in millimeters per second.
+     * @param maxTurnSpeed The fastest rotational speed in degrees per second.
+     */
+    DynamicWindow(MotionTracker* motionTracker_P, Drive* drive_P, Map* map_P,
+                  int maxSpeed, int maxTurnSpeed);
+
+    /**
+     * @brief Chooses and sets the speed of the robot, at a fixed rate. This
+     * should be called every loop while following the map.
+     */
+    void plan();
+
+    /**
+     * @brief Resets the planner so that the next plan starts from a
+     * standstill, this should be called whenever the robot is stopped.
+     */
+    void reset();
+
+    /**
+     * @brief Sets the fastest linear speed that the planner can choose, so
+     * that the robot can speed up and slow down along the map.
+     *
+     * @param maxSpeed The fastest linear speed in millimeters per second.
+     */
+    void setMaxSpeed(int maxSpeed);
+
+   private:
+    /**
+     * @brief Rolls a pair of speeds forward from the robot's pose, and scores
+     * the resulting trajectory.
+     *
+     * @param startPose The pose of the robot.
+     * @param speed The linear speed in millimeters per second.
+     * @param turnSpeed The rotational speed in degrees per second.
+     * @param score_P The pointer used to return the score of the trajectory.
+     * @return (true) If the trajectory stays clear of any blocked cells.
+     * @return (false) If the trajectory would hit something.
+     */
+    bool _scoreTrajectory(Pose startPose, float speed, float turnSpeed,
+                          float* score_P);
+
+    /**
+     * @brief Pointer to the motion tracker.
+     */
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief Pointer to the drive object.
+     */
+    Drive* _drive_P;
+
+    /**
+     * @brief Pointer to the map.
+     */
+    Map* _map_P;
+
+    /**
+     * @brief The fastest linear speed in millimeters per second.
+     */
+    int _maxSpeed;
+
+    /**
+     * @brief The fastest rotational speed in degrees per second.
+     */
+    int _maxTurnSpeed;
+
+    /**
+     * @brief The last linear speed sent to the drive.
+     */
+    float _speed = 0;
+
+    /**
+     * @brief The last rotational speed sent to the drive.
+     */
+    float _turnSpeed = 0;
+
+    /**
+     * @brief The schedule that sets the rate of the planner.
+     */
+    PassiveSchedule _planSchedule;
+};
+
+#endif  // DYNAMIC_WINDOW_H
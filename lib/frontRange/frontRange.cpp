@@ -0,0 +1,256 @@
+/**
+ * @file frontRange.cpp
+ * @brief Definition of the FrontRange class, responsible for combining the
+ * readings from the front ultrasonic sensor and the front pair of infrared
+ * sensors into a single estimate of the distance to the object in front of
+ * the robot.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-02
+ * @copyright Copyright (c) 2024
+ */
+#include "frontRange.h"
+
+#include "angleAndPosition.h"
+#include "infrared.h"
+#include "motionTracker.h"
+#include "ultrasonic.h"
+
+// The variance of the ultrasonic sensor, in millimeters squared.
+#define ULTRASONIC_VARIANCE 225
+
+// The standard deviation of the infrared sensors at point blank, and how much
+// it grows per millimeter of distance.
+#define INFRARED_BASE_DEVIATION 3
+#define INFRARED_DEVIATION_PER_MILLIMETER 0.02f
+
+// The extra variance given to a single infrared sensor, when the other can't
+// confirm that it is looking at the same wall.
+#define SINGLE_INFRARED_VARIANCE 400
+
+// How much the variance of a reading grows for every millisecond of its age.
+#define AGE_VARIANCE_PER_MILLISECOND 2
+
+// The fraction of the distance traveled since a reading that is assumed to be
+// error in the odometry.
+#define ODOMETRY_ERROR_FRACTION 0.05f
+
+// The oldest that a reading can be before it is ignored, in milliseconds.
+#define MAX_READING_AGE 300
+
+/**
+ * @brief Construct a new FrontRange object.
+ *
+ * @param ultrasonic_P Pointer to the front ultrasonic sensor.
+ * @param frontLeftInfrared_P Pointer to the front left infrared sensor.
+ * @param frontRightInfrared_P Pointer to the front right infrared sensor.
+ * @param motionTracker_P Pointer to the motion tracker, used to compensate
+ * readings for the distance traveled since they were taken.
+ * @param infraredSeparation The distance in millimeters between the front
+ * left and front right infrared sensors.
+ */
+FrontRange::FrontRange(Ultrasonic* ultrasonic_P, Infrared* frontLeftInfrared_P,
+                       Infrared* frontRightInfrared_P,
+                       MotionTracker* motionTracker_P, int infraredSeparation)
+    : _ultrasonic_P(ultrasonic_P),
+      _frontLeftInfrared_P(frontLeftInfrared_P),
+      _frontRightInfrared_P(frontRightInfrared_P),
+      _motionTracker_P(motionTracker_P),
+      _infraredSeparation(infraredSeparation) {}
+
+/**
+ * @brief Captures any new readings from the front sensors. This should be
+ * called after the sensors themselves have been polled.
+ */
+void FrontRange::poll() {
+    uint32_t currentTime = millis();
+    int distanceTraveled = this->_motionTracker_P->getDistanceTraveled();
+
+    // A sensor has taken a new reading if its age has dropped since the last
+    // poll.
+
+    // The ultrasonic sensor is only read straight after a new reading, so
+    // that it never has to block while waiting for a new pulse.
+    uint32_t ultrasonicAge = this->_ultrasonic_P->getAge();
+    if (ultrasonicAge < this->_lastUltrasonicAge) {
+        this->_ultrasonicReading.distance =
+            this->_ultrasonic_P->readFromRobotCenter();
+        this->_ultrasonicReading.distanceTraveled = distanceTraveled;
+        this->_ultrasonicReading.time = currentTime - ultrasonicAge;
+    }
+    this->_lastUltrasonicAge = ultrasonicAge;
+
+    uint32_t frontLeftAge = this->_frontLeftInfrared_P->getAge();
+    if (frontLeftAge < this->_lastFrontLeftAge) {
+        this->_frontLeftReading.distance =
+            this->_frontLeftInfrared_P->readFromRobotCenter();
+        this->_frontLeftReading.distanceTraveled = distanceTraveled;
+        this->_frontLeftReading.time = currentTime - frontLeftAge;
+    }
+    this->_lastFrontLeftAge = frontLeftAge;
+
+    uint32_t frontRightAge = this->_frontRightInfrared_P->getAge();
+    if (frontRightAge < this->_lastFrontRightAge) {
+        this->_frontRightReading.distance =
+            this->_frontRightInfrared_P->readFromRobotCenter();
+        this->_frontRightReading.distanceTraveled = distanceTraveled;
+        this->_frontRightReading.time = currentTime - frontRightAge;
+    }
+    this->_lastFrontRightAge = frontRightAge;
+}
+
+/**
+ * @brief Reads the fused distance from the centre of the robot to the
+ * object in front of it.
+ *
+ * @param variance_P The pointer used to return the variance of the fused
+ * distance, in millimeters squared.
+ * @return (int) The fused distance in millimeters.
+ * @return (-1) If none of the front sensors can see anything.
+ */
+int FrontRange::read(float* variance_P) {
+    // Each valid reading is weighted by the inverse of its variance.
+    float weightSum = 0;
+    float weightedDistanceSum = 0;
+
+    float distance;
+    float variance;
+
+    if (this->_compensate(this->_ultrasonicReading, ULTRASONIC_VARIANCE,
+                          &distance, &variance)) {
+        weightSum += 1 / variance;
+        weightedDistanceSum += distance / variance;
+    }
+
+    float leftDistance;
+    float leftVariance;
+    bool leftValid = this->_compensate(
+        this->_frontLeftReading,
+        this->_infraredVariance(this->_frontLeftReading.distance),
+        &leftDistance, &leftVariance);
+
+    float rightDistance;
+    float rightVariance;
+    bool rightValid = this->_compensate(
+        this->_frontRightReading,
+        this->_infraredVariance(this->_frontRightReading.distance),
+        &rightDistance, &rightVariance);
+
+    // The two infrared sensors sit either side of the robot's centre line, so
+    // their average is the distance to the wall along the centre line, even
+    // when the wall is at an angle.
+    if (leftValid && rightValid) {
+        distance = (leftDistance + rightDistance) / 2;
+        variance = (leftVariance + rightVariance) / 4;
+
+        weightSum += 1 / variance;
+        weightedDistanceSum += distance / variance;
+    }
+    // If only one sensor can see something, it could be the corner of a
+    // brick, so it is trusted less.
+    else if (leftValid || rightValid) {
+        distance = leftValid ? leftDistance : rightDistance;
+        variance = (leftValid ? leftVariance : rightVariance) +
+                   SINGLE_INFRARED_VARIANCE;
+
+        weightSum += 1 / variance;
+        weightedDistanceSum += distance / variance;
+    }
+
+    // If no sensors can see anything, return an error value.
+    if (weightSum == 0) {
+        return -1;
+    }
+
+    if (variance_P != nullptr) {
+        *variance_P = 1 / weightSum;
+    }
+
+    return round(weightedDistanceSum / weightSum);
+}
+
+/**
+ * @brief Reads the angle of the wall in front of the robot, from the
+ * difference between the front infrared sensors.
+ *
+ * @param wallAngle_P The pointer used to return the angle in degrees that
+ * the robot would need to turn counter-clockwise to face the wall squarely.
+ * @return (true) If both front infrared sensors can see the wall.
+ * @return (false) If the wall angle could not be measured.
+ */
+bool FrontRange::readWallAngle(float* wallAngle_P) {
+    float leftDistance;
+    float rightDistance;
+    float variance;
+
+    bool leftValid = this->_compensate(this->_frontLeftReading, 0,
+                                       &leftDistance, &variance);
+    bool rightValid = this->_compensate(this->_frontRightReading, 0,
+                                        &rightDistance, &variance);
+
+    if (!(leftValid && rightValid)) {
+        return false;
+    }
+
+    // If the right sensor is further from the wall than the left, the robot
+    // is facing to the right of the wall, and needs to turn left.
+    float wallAngleRadians =
+        atan2f(rightDistance - leftDistance, this->_infraredSeparation);
+
+    *wallAngle_P = wallAngleRadians * DEGREES_PER_RADIAN;
+
+    return true;
+}
+
+/**
+ * @brief Moves a reading to the robot's current position, and calculates
+ * its variance.
+ *
+ * @param reading The reading to compensate.
+ * @param baseVariance The variance of the sensor at the time the reading was
+ * taken, in millimeters squared.
+ * @param distance_P The pointer used to return the compensated distance.
+ * @param variance_P The pointer used to return the variance of the
+ * compensated distance.
+ * @return (true) If the reading is valid and recent enough to be used.
+ * @return (false) If the reading should be ignored.
+ */
+bool FrontRange::_compensate(RangeReading reading, float baseVariance,
+                             float* distance_P, float* variance_P) {
+    if (reading.distance == -1) {
+        return false;
+    }
+
+    uint32_t age = millis() - reading.time;
+
+    if (age > MAX_READING_AGE) {
+        return false;
+    }
+
+    // Anything in front of the robot gets closer as the robot drives forwards.
+    int distanceTraveled = this->_motionTracker_P->getDistanceTraveled();
+    int distanceSinceReading = distanceTraveled - reading.distanceTraveled;
+
+    *distance_P = max(reading.distance - distanceSinceReading, 0);
+
+    float odometryError = ODOMETRY_ERROR_FRACTION * distanceSinceReading;
+
+    *variance_P = baseVariance + (age * AGE_VARIANCE_PER_MILLISECOND) +
+                  (odometryError * odometryError);
+
+    return true;
+}
+
+/**
+ * @brief Calculates the variance of an infrared reading, as the noise of the
+ * sensor increases with distance.
+ *
+ * @param distance The distance read by the sensor.
+ * @return (float) The variance of the reading in millimeters squared.
+ */
+float FrontRange::_infraredVariance(int distance) {
+    float deviation =
+        INFRARED_BASE_DEVIATION + (INFRARED_DEVIATION_PER_MILLIMETER * distance);
+
+    return deviation * deviation;
+}
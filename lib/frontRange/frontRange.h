@@ -0,0 +1,185 @@
+/**
+ * @file frontRange.h
+ * @brief Declaration of the FrontRange class, responsible for combining the
+ * readings from the front ultrasonic sensor and the front pair of infrared
+ * sensors into a single estimate of the distance to the object in front of
+ * the robot.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-02
+ * @copyright Copyright (c) 2024
+ */
+#ifndef FRONT_RANGE_H
+#define FRONT_RANGE_H
+
+#include <Arduino.h>
+
+// Forward declarations.
+class Ultrasonic;
+class Infrared;
+class MotionTracker;
+
+/**
+ * @brief A single reading captured from one of the front sensors, along with
+ * when and where it was taken.
+ */
+struct RangeReading {
+    /**
+     * @brief The distance from the centre of the robot to the object seen by
+     * the sensor, in millimeters, or -1 if nothing was seen.
+     */
+    int distance = -1;
+
+    /**
+     * @brief The distance that the robot had traveled when the reading was
+     * taken, in millimeters.
+     */
+    int distanceTraveled = 0;
+
+    /**
+     * @brief The time in milliseconds at which the reading was taken.
+     */
+    uint32_t time = 0;
+};
+
+/**
+ * @brief FrontRange class, responsible for fusing the front sensors into a
+ * single distance, weighting each sensor by its expected variance.
+ *
+ * The variance of each reading grows with its age and with how far the robot
+ * has traveled since it was taken, so the faster infrared sensors dominate
+ * when they can see the wall, and the ultrasonic sensor fills in beyond
+ * their range.
+ */
+class FrontRange {
+   public:
+    /**
+     * @brief Construct a new FrontRange object.
+     *
+     * @param ultrasonic_P Pointer to the front ultrasonic sensor.
+     * @param frontLeftInfrared_P Pointer to the front left infrared sensor.
+     * @param frontRightInfrared_P Pointer to the front right infrared sensor.
+     * @param motionTracker_P Pointer to the motion tracker, used to
+     * compensate readings for the distance traveled since they were taken.
+     * @param infraredSeparation The distance in millimeters between the front
+     * left and front right infrared sensors.
+     */
+    FrontRange(Ultrasonic* ultrasonic_P, Infrared* frontLeftInfrared_P,
+               Infrared* frontRightInfrared_P, MotionTracker* motionTracker_P,
+               int infraredSeparation);
+
+    /**
+     * @brief Captures any new readings from the front sensors. This should be
+     * called after the sensors themselves have been polled.
+     */
+    void poll();
+
+    /**
+     * @brief Reads the fused distance from the centre of the robot to the
+     * object in front of it.
+     *
+     * @param variance_P The pointer used to return the variance of the fused
+     * distance, in millimeters squared.
+     * @return (int) The fused distance in millimeters.
+     * @return (-1) If none of the front sensors can see anything.
+     */
+    int read(float* variance_P = nullptr);
+
+    /**
+     * @brief Reads the angle of the wall in front of the robot, from the
+     * difference between the front infrared sensors.
+     *
+     * @param wallAngle_P The pointer used to return the angle in degrees that
+     * the robot would need to turn counter-clockwise to face the wall
+     * squarely.
+     * @return (true) If both front infrared sensors can see the wall.
+     * @return (false) If the wall angle could not be measured.
+     */
+    bool readWallAngle(float* wallAngle_P);
+
+   private:
+    /**
+     * @brief Pointer to the front ultrasonic sensor.
+     */
+    Ultrasonic* _ultrasonic_P;
+
+    /**
+     * @brief Pointer to the front left infrared sensor.
+     */
+    Infrared* _frontLeftInfrared_P;
+
+    /**
+     * @brief Pointer to the front right infrared sensor.
+     */
+    Infrared* _frontRightInfrared_P;
+
+    /**
+     * @brief Pointer to the motion tracker.
+     */
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief The distance in millimeters between the front infrared sensors.
+     */
+    int _infraredSeparation;
+
+    /**
+     * @brief The most recent reading from the ultrasonic sensor.
+     */
+    RangeReading _ultrasonicReading;
+
+    /**
+     * @brief The most recent reading from the front left infrared sensor.
+     */
+    RangeReading _frontLeftReading;
+
+    /**
+     * @brief The most recent reading from the front right infrared sensor.
+     */
+    RangeReading _frontRightReading;
+
+    /**
+     * @brief The age of the ultrasonic sensor's reading on the last poll,
+     * used to detect when a new reading has been taken.
+     */
+    uint32_t _lastUltrasonicAge = UINT32_MAX;
+
+    /**
+     * @brief The age of the front left infrared sensor's reading on the last
+     * poll.
+     */
+    uint32_t _lastFrontLeftAge = UINT32_MAX;
+
+    /**
+     * @brief The age of the front right infrared sensor's reading on the last
+     * poll.
+     */
+    uint32_t _lastFrontRightAge = UINT32_MAX;
+
+    /**
+     * @brief Moves a reading to the robot's current position, and calculates
+     * its variance.
+     *
+     * @param reading The reading to compensate.
+     * @param baseVariance The variance of the sensor at the time the reading
+     * was taken, in millimeters squared.
+     * @param distance_P The pointer used to return the compensated distance.
+     * @param variance_P The pointer used to return the variance of the
+     * compensated distance.
+     * @return (true) If the reading is valid and recent enough to be used.
+     * @return (false) If the reading should be ignored.
+     */
+    bool _compensate(RangeReading reading, float baseVariance,
+                     float* distance_P, float* variance_P);
+
+    /**
+     * @brief Calculates the variance of an infrared reading, as the noise of
+     * the sensor increases with distance.
+     *
+     * @param distance The distance read by the sensor.
+     * @return (float) The variance of the reading in millimeters squared.
+     */
+    float _infraredVariance(int distance);
+};
+
+#endif  // FRONT_RANGE_H
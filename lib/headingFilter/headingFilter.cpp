@@ -0,0 +1,110 @@
+/**
+ * @file headingFilter.cpp
+ * @brief Definition of the HeadingFilter class, a complementary filter that
+ * fuses the yaw rate from a gyroscope with the heading from the wheels.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#include "headingFilter.h"
+
+// How quickly the bias is learned while stationary, as the fraction of the
+// difference corrected on each sample.
+#define BIAS_LEARNING_RATE 0.01f
+
+// How much the wheels can disagree with the gyroscope before they are treated
+// as slipping, in degrees per second, plus a fixed allowance in degrees for
+// the resolution of the encoders.
+#define SLIP_RATE_THRESHOLD 15.0f
+#define SLIP_ANGLE_ALLOWANCE 0.25f
+
+// The wheels are most likely to slip during fast turns, where a few percent
+// of slip is too small to stand out from the noise of a single update, so
+// above this rate in degrees per second the gyroscope is always used.
+#define FAST_TURN_RATE 60.0f
+
+/**
+ * @brief Construct a new HeadingFilter object.
+ *
+ * @param timeConstant The time constant of the filter, in seconds.
+ */
+HeadingFilter::HeadingFilter(float timeConstant)
+    : _timeConstant(timeConstant) {}
+
+/**
+ * @brief Updates the heading with a new sample from the gyroscope.
+ *
+ * @param odometryChange The change in heading measured by the wheels since the
+ * last update, in degrees.
+ * @param yawRate The yaw rate read from the gyroscope, in degrees per second,
+ * counter-clockwise positive.
+ * @param timeStep The time since the last update, in seconds.
+ * @param stationary Whether the robot is known to be still, used to learn the
+ * bias of the gyroscope.
+ */
+void HeadingFilter::update(float odometryChange, float yawRate,
+                           float timeStep, bool stationary) {
+    float gyroChange;
+
+    if (stationary) {
+        // While the robot is still, everything the gyroscope reads is bias.
+        this->_bias += BIAS_LEARNING_RATE * (yawRate - this->_bias);
+        gyroChange = 0;
+    } else {
+        gyroChange = (yawRate - this->_bias) * timeStep;
+    }
+
+    // If the wheels turned further than the gyroscope saw, one of them has
+    // slipped, so the gyroscope stands in for them for this update.
+    float disagreement = abs(odometryChange - gyroChange);
+    float slipThreshold =
+        (SLIP_RATE_THRESHOLD * timeStep) + SLIP_ANGLE_ALLOWANCE;
+
+    bool turningFast = abs(yawRate - this->_bias) > FAST_TURN_RATE;
+
+    if (disagreement > slipThreshold) {
+        this->_reference += gyroChange;
+        this->_slipCount++;
+    } else if (turningFast) {
+        this->_reference += gyroChange;
+    } else {
+        this->_reference += odometryChange;
+    }
+
+    // Follow the gyroscope, while being pulled slowly towards the wheels.
+    float gyroWeight = this->_timeConstant / (this->_timeConstant + timeStep);
+
+    this->_angle = (gyroWeight * (this->_angle + gyroChange)) +
+                   ((1 - gyroWeight) * this->_reference);
+
+    // Both angles are moved back together after each full turn, so that
+    // they don't lose precision as the robot keeps turning.
+    if (abs(this->_reference) > 360) {
+        float fullTurns = (this->_reference > 0) ? 360 : -360;
+        this->_reference -= fullTurns;
+        this->_angle -= fullTurns;
+    }
+}
+
+/**
+ * @brief Gets the fused change in heading since the filter started.
+ *
+ * @return (float) The change in heading in degrees.
+ */
+float HeadingFilter::getAngle() { return this->_angle; }
+
+/**
+ * @brief Gets the learned bias of the gyroscope.
+ *
+ * @return (float) The bias in degrees per second.
+ */
+float HeadingFilter::getBias() { return this->_bias; }
+
+/**
+ * @brief Gets the number of updates where the wheels disagreed with the
+ * gyroscope, and were treated as slipping.
+ *
+ * @return (uint32_t) The number of slipping updates.
+ */
+uint32_t HeadingFilter::getSlipCount() { return this->_slipCount; }
@@ -0,0 +1,106 @@
+/**
+ * @file headingFilter.h
+ * @brief Declaration of the HeadingFilter class, a complementary filter that
+ * fuses the yaw rate from a gyroscope with the heading from the wheels.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#ifndef HEADING_FILTER_H
+#define HEADING_FILTER_H
+
+#include <Arduino.h>
+
+// The default time constant of the filter in seconds, changes in heading
+// quicker than this follow the gyroscope, and slower ones follow the wheels.
+#define HEADING_FILTER_TIME_CONSTANT 2.0f
+
+/**
+ * @brief HeadingFilter class, follows the gyroscope over short periods and
+ * the wheels over long ones, so that neither the bias of the gyroscope nor
+ * the noise of the wheels builds up.
+ *
+ * The wheels are only trusted while they agree with the gyroscope and the
+ * robot isn't turning quickly, otherwise the gyroscope is used in their
+ * place, so that wheel slip in a fast spin doesn't leave the heading
+ * permanently wrong. The bias of the gyroscope is
+ * learned whenever the robot is stationary.
+ *
+ * All angles are in degrees, and are only ever wrapped by whole turns, so
+ * that a change of more than half a turn between updates isn't lost.
+ */
+class HeadingFilter {
+   public:
+    /**
+     * @brief Construct a new HeadingFilter object.
+     *
+     * @param timeConstant The time constant of the filter, in seconds.
+     */
+    HeadingFilter(float timeConstant = HEADING_FILTER_TIME_CONSTANT);
+
+    /**
+     * @brief Updates the heading with a new sample from the gyroscope.
+     *
+     * @param odometryChange The change in heading measured by the wheels
+     * since the last update, in degrees.
+     * @param yawRate The yaw rate read from the gyroscope, in degrees per
+     * second, counter-clockwise positive.
+     * @param timeStep The time since the last update, in seconds.
+     * @param stationary Whether the robot is known to be still, used to learn
+     * the bias of the gyroscope.
+     */
+    void update(float odometryChange, float yawRate, float timeStep,
+                bool stationary);
+
+    /**
+     * @brief Gets the fused change in heading since the filter started.
+     *
+     * @return (float) The change in heading in degrees.
+     */
+    float getAngle();
+
+    /**
+     * @brief Gets the learned bias of the gyroscope.
+     *
+     * @return (float) The bias in degrees per second.
+     */
+    float getBias();
+
+    /**
+     * @brief Gets the number of updates where the wheels disagreed with the
+     * gyroscope, and were treated as slipping.
+     *
+     * @return (uint32_t) The number of slipping updates.
+     */
+    uint32_t getSlipCount();
+
+   private:
+    /**
+     * @brief The time constant of the filter, in seconds.
+     */
+    float _timeConstant;
+
+    /**
+     * @brief The fused change in heading, in degrees.
+     */
+    float _angle = 0;
+
+    /**
+     * @brief The change in heading from the wheels, with the slipping updates
+     * replaced by the gyroscope, in degrees.
+     */
+    float _reference = 0;
+
+    /**
+     * @brief The learned bias of the gyroscope, in degrees per second.
+     */
+    float _bias = 0;
+
+    /**
+     * @brief The number of slipping updates.
+     */
+    uint32_t _slipCount = 0;
+};
+
+#endif  // HEADING_FILTER_H
@@ -93,3 +93,19 @@ uint16_t History::countErrors() {
     }
     return occurrences;
 }
+
+/**
+ * @brief Replaces every value in the queue that is not less than the given
+ * limit with -1, so that values recorded with a larger limit can be
+ * compared with new values.
+ *
+ * @param limit (int16_t) The value that all stored values must be less
+ * than.
+ */
+void History::limitTo(int16_t limit) {
+    for (auto& item : this->_values) {
+        if (item >= limit) {
+            item = -1;
+        }
+    }
+}
@@ -68,6 +68,16 @@ class History {
      */
     uint16_t countErrors();
 
+    /**
+     * @brief Replaces every value in the queue that is not less than the given
+     * limit with -1, so that values recorded with a larger limit can be
+     * compared with new values.
+     *
+     * @param limit (int16_t) The value that all stored values must be less
+     * than.
+     */
+    void limitTo(int16_t limit);
+
    private:
     /**
      * @brief The vector that stores the queue of int16_ts.
@@ -0,0 +1,66 @@
+/**
+ * @file imu.cpp
+ * @brief Definition of the SimulatedImu class, an Imu that stands in for the
+ * hardware when testing.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#include "imu.h"
+
+/**
+ * @brief Construct a new SimulatedImu object.
+ *
+ * @param bias The error added to every reading, in degrees per second.
+ */
+SimulatedImu::SimulatedImu(float bias) : _bias(bias) {}
+
+/**
+ * @brief Starts the simulated IMU, which always succeeds.
+ *
+ * @return (true) Always.
+ */
+bool SimulatedImu::setup() {
+    this->_isReady = true;
+    return true;
+}
+
+/**
+ * @brief Returns whether the simulated IMU has been started.
+ *
+ * @return (true) If setup() has been called.
+ * @return (false) If setup() hasn't been called.
+ */
+bool SimulatedImu::isReady() { return this->_isReady; }
+
+/**
+ * @brief Reads the yaw rate, a new sample is available after each call to
+ * setYawRate().
+ *
+ * @param yawRate_P The pointer used to return the yaw rate in degrees per
+ * second, counter-clockwise positive.
+ * @return (true) If a new sample was read.
+ * @return (false) If there is no new sample.
+ */
+bool SimulatedImu::readYawRate(float* yawRate_P) {
+    if (!(this->_isReady && this->_hasNewSample)) {
+        return false;
+    }
+
+    *yawRate_P = this->_yawRate + this->_bias;
+    this->_hasNewSample = false;
+
+    return true;
+}
+
+/**
+ * @brief Sets the true yaw rate of the simulated robot, and makes a new sample
+ * available.
+ *
+ * @param yawRate The true yaw rate in degrees per second.
+ */
+void SimulatedImu::setYawRate(float yawRate) {
+    this->_yawRate = yawRate;
+    this->_hasNewSample = true;
+}
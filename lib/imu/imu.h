@@ -0,0 +1,125 @@
+/**
+ * @file imu.h
+ * @brief Declaration of the Imu interface, used to read the yaw rate of the
+ * robot from whichever inertial measurement unit is available, and the
+ * SimulatedImu class that stands in for one when testing.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#ifndef IMU_H
+#define IMU_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Imu interface, the parts of an inertial measurement unit needed to
+ * track the heading of the robot.
+ */
+class Imu {
+   public:
+    /**
+     * @brief Destroy the Imu object.
+     */
+    virtual ~Imu() {}
+
+    /**
+     * @brief Starts the IMU.
+     *
+     * @return (true) If the IMU was started.
+     * @return (false) If the IMU could not be found.
+     */
+    virtual bool setup() = 0;
+
+    /**
+     * @brief Returns whether the IMU has been started successfully.
+     *
+     * @return (true) If the IMU is ready to read.
+     * @return (false) If the IMU isn't available.
+     */
+    virtual bool isReady() = 0;
+
+    /**
+     * @brief Reads the rate that the robot is turning at, if a new sample is
+     * available.
+     *
+     * @param yawRate_P The pointer used to return the yaw rate in degrees per
+     * second, counter-clockwise positive.
+     * @return (true) If a new sample was read.
+     * @return (false) If there is no new sample.
+     */
+    virtual bool readYawRate(float* yawRate_P) = 0;
+};
+
+/**
+ * @brief SimulatedImu class, an Imu that returns a yaw rate set by the test,
+ * plus a fixed bias, so that the heading fusion can be tested without the
+ * hardware.
+ */
+class SimulatedImu : public Imu {
+   public:
+    /**
+     * @brief Construct a new SimulatedImu object.
+     *
+     * @param bias The error added to every reading, in degrees per second.
+     */
+    SimulatedImu(float bias = 0);
+
+    /**
+     * @brief Starts the simulated IMU, which always succeeds.
+     *
+     * @return (true) Always.
+     */
+    bool setup() override;
+
+    /**
+     * @brief Returns whether the simulated IMU has been started.
+     *
+     * @return (true) If setup() has been called.
+     * @return (false) If setup() hasn't been called.
+     */
+    bool isReady() override;
+
+    /**
+     * @brief Reads the yaw rate, a new sample is available after each call to
+     * setYawRate().
+     *
+     * @param yawRate_P The pointer used to return the yaw rate in degrees per
+     * second, counter-clockwise positive.
+     * @return (true) If a new sample was read.
+     * @return (false) If there is no new sample.
+     */
+    bool readYawRate(float* yawRate_P) override;
+
+    /**
+     * @brief Sets the true yaw rate of the simulated robot, and makes a new
+     * sample available.
+     *
+     * @param yawRate The true yaw rate in degrees per second.
+     */
+    void setYawRate(float yawRate);
+
+   private:
+    /**
+     * @brief The error added to every reading, in degrees per second.
+     */
+    float _bias;
+
+    /**
+     * @brief The true yaw rate in degrees per second.
+     */
+    float _yawRate = 0;
+
+    /**
+     * @brief Whether a new sample is available.
+     */
+    bool _hasNewSample = false;
+
+    /**
+     * @brief Whether setup() has been called.
+     */
+    bool _isReady = false;
+};
+
+#endif  // IMU_H
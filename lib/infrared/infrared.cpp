@@ -48,7 +48,34 @@
 // The period to wait between taking readings.
 #define POLL_PERIOD 10
 
-#define MAX_IR_RANGE 639
+// The number of readings either side of a corner that must agree before the
+// corner is reported.
+#define EDGE_CONFIRMATION_SAMPLES 3
+
+// The number of readings allowed to sit part way between the two sides of a
+// corner, for when the sensor catches the very edge of a brick.
+#define EDGE_TRANSITION_SAMPLES 1
+
+// How closely the readings of a wall must agree with each other, in
+// millimeters.
+#define EDGE_STABILITY_TOLERANCE 15
+
+// The shift values for each of the sensor's range modes.
+#define SHORT_RANGE_SHIFT 0x02
+#define LONG_RANGE_SHIFT 0x01
+
+// The largest value that can be held in the 12 bit distance registers.
+#define IR_DISTANCE_REG_MAX 0xFFF
+
+// In auto range mode, the median reading that the sensor must see before
+// switching back to short range. This is kept well below the 64cm limit of
+// short range so that the sensor doesn't keep switching between the two
+// modes when something is at the edge of short range.
+#define AUTO_RANGE_SHORTEN_DISTANCE 500
+
+// The number of readings to skip after changing range mode, as the sensor
+// may still be returning a measurement taken in the previous mode.
+#define RANGE_SETTLING_SAMPLES 4
 
 /**
  * @brief Construct a new Infrared object from its given index on the
@@ -95,8 +122,37 @@ void Infrared::setup() {
 
     // Read in the shift value from the I2C bus.
     this->_shiftValue = Wire.read();
+
+    // Calculate the max range from the full scale of the distance registers.
+    this->_maxRange = (IR_DISTANCE_REG_MAX * 10) >> (4 + this->_shiftValue);
 }
 
+/**
+ * @brief Sets the range mode of the sensor. In auto range mode, the
+ * sensor switches to long range when nothing can be seen within short
+ * range, and back to short range when something comes close.
+ *
+ * @param range The range mode to use.
+ */
+void Infrared::setRange(InfraredRange range) {
+    this->_range = range;
+
+    // Auto range mode always starts in short range, as it is the most precise.
+    uint8_t shiftValue =
+        (range == LongRange) ? LONG_RANGE_SHIFT : SHORT_RANGE_SHIFT;
+
+    if (shiftValue != this->_shiftValue) {
+        this->_writeShiftValue(shiftValue);
+    }
+}
+
+/**
+ * @brief Gets the maximum distance that the sensor can currently read.
+ *
+ * @return (int16_t) The maximum distance in millimeters.
+ */
+int16_t Infrared::getMaxRange() { return this->_maxRange; }
+
 /**
  * @brief Read the distance from the sensor.
  *
@@ -140,7 +196,7 @@ int16_t Infrared::read() {
     uint16_t distance = (((high << 4) | low) * 10) >> (4 + this->_shiftValue);
 
     // if the distance is out of range, return -1.
-    return (distance < MAX_IR_RANGE) ? distance : -1;
+    return (distance < this->_maxRange) ? distance : -1;
 }
 
 /**
@@ -152,7 +208,7 @@ int16_t Infrared::read() {
  */
 int16_t Infrared::readSafe() {
     // In this context, errors mostly just mean the reading was out of
-    // range(exceeded 64cm).
+    // range(exceeded 64cm, or 128cm in long range mode).
 
     // How many errors is to many errors.
     const uint8_t errorThreshold = 1;
@@ -199,68 +255,76 @@ int Infrared::readFromRobotCenter(bool getOldReading) {
 
 /**
  * @brief Checks if the robot has seen a starting corner of a brick, based
- * on the rate of change that the sensor has read. A sudden drop in distance
- * indicated that a corner has been seen.
+ * on the edge detector run over the recent sample history. A confirmed
+ * drop in distance indicates that a corner has been seen.
+ *
+ * Each edge is only reported once, on the poll that confirms it.
  *
  * @param range The range that the newly seen reading has to be withing to
  * be considered valid.
  * @param requiredDistanceChange The amount of change that must occur for a
  * reading to be considered valid.
+ * @param wallDistance_P The pointer used to return the distance from the
+ * centre of the robot to the newly seen wall.
+ * @param distanceSinceCorner_P The pointer used to return the distance in
+ * millimeters that the robot has traveled since passing the corner.
  * @return (true) If a starting corner has been seen.
  * @return (false) If a starting corner has not been seen.
  */
-bool Infrared::seenStartingCorner(int range, int requiredDistanceChange) {
-    int mostRecentValue = this->_mostRecentValue;
-    if (mostRecentValue == -1) {
-        mostRecentValue = MAX_IR_RANGE;
+bool Infrared::seenStartingCorner(int range, int requiredDistanceChange,
+                                  int* wallDistance_P,
+                                  int* distanceSinceCorner_P) {
+    uint32_t edgeSample = 0;
+
+    bool brickAppeared =
+        this->_findEdge(false, range, requiredDistanceChange, &edgeSample,
+                        wallDistance_P, distanceSinceCorner_P);
+
+    // If this edge has already been reported, don't report it again.
+    if (!brickAppeared || (edgeSample == this->_lastStartingCornerSample)) {
+        return false;
     }
 
-    int secondMostRecentValue = this->_secondMostRecentValue;
-    if (secondMostRecentValue == -1) {
-        secondMostRecentValue = MAX_IR_RANGE;
-    }
-
-    int distanceChange = mostRecentValue - secondMostRecentValue;
-
-    bool wallInRange = (mostRecentValue < range);
-    bool enoughChange = (distanceChange < -(requiredDistanceChange));
+    this->_lastStartingCornerSample = edgeSample;
 
-    bool brickAppeared = (wallInRange && enoughChange);
-
-    return brickAppeared;
+    return true;
 }
 
 /**
  * @brief Checks if the robot has seen an ending corner of a brick, based
- * on the rate of change that the sensor has read. A sudden rise in distance
- * indicated that a ending corner has been seen.
+ * on the edge detector run over the recent sample history. A confirmed
+ * rise in distance indicates that a ending corner has been seen.
+ *
+ * Each edge is only reported once, on the poll that confirms it.
  *
  * @param range The range that the seen reading bust have been before
  * rising.
  * @param requiredDistanceChange The amount the value must have rose by
  * to be considered valid.
+ * @param wallDistance_P The pointer used to return the distance from the
+ * centre of the robot to the wall that has just ended.
+ * @param distanceSinceCorner_P The pointer used to return the distance in
+ * millimeters that the robot has traveled since passing the corner.
  * @return (true) If a ending corner has been seen.
  * @return (false) If a ending corner has not been seen.
  */
-bool Infrared::seenEndingCorner(int range, int requiredDistanceChange) {
-    int mostRecentValue = this->_mostRecentValue;
-    if (mostRecentValue == -1) {
-        mostRecentValue = MAX_IR_RANGE;
-    }
-
-    int secondMostRecentValue = this->_secondMostRecentValue;
-    if (secondMostRecentValue == -1) {
-        secondMostRecentValue = MAX_IR_RANGE;
+bool Infrared::seenEndingCorner(int range, int requiredDistanceChange,
+                                int* wallDistance_P,
+                                int* distanceSinceCorner_P) {
+    uint32_t edgeSample = 0;
+
+    bool brickDisappeared =
+        this->_findEdge(true, range, requiredDistanceChange, &edgeSample,
+                        wallDistance_P, distanceSinceCorner_P);
+
+    // If this edge has already been reported, don't report it again.
+    if (!brickDisappeared || (edgeSample == this->_lastEndingCornerSample)) {
+        return false;
     }
 
-    int distanceChange = mostRecentValue - secondMostRecentValue;
-
-    bool wallWasInRange = (secondMostRecentValue < range);
-    bool enoughChange = (distanceChange > requiredDistanceChange);
-
-    bool brickDisappeared = (wallWasInRange && enoughChange);
+    this->_lastEndingCornerSample = edgeSample;
 
-    return brickDisappeared;
+    return true;
 }
 
 /**
@@ -273,18 +337,130 @@ bool Infrared::seenEndingCorner(int range, int requiredDistanceChange) {
  */
 int16_t Infrared::average() { return this->_valueHistory.getMedian(); }
 
+/**
+ * @brief Gets the age of the most recent reading from the sensor.
+ *
+ * @return (uint32_t) The time in milliseconds since the value history was
+ * last updated.
+ */
+uint32_t Infrared::getAge() { return millis() - this->_lastReadingTime; }
+
+/**
+ * @brief Gets the time of the most recent reading from the sensor, which only
+ * changes when a new reading is taken.
+ *
+ * @return (uint32_t) The time in milliseconds that the value history was last
+ * updated.
+ */
+uint32_t Infrared::getReadingTime() { return this->_lastReadingTime; }
+
 /**
  * @brief Updates the value history, if enough time has passed.
+ *
+ * @param distanceTraveled The distance in millimeters that the robot has
+ * traveled, used to place each sample along the robot's path.
  */
-void Infrared::poll() {
+void Infrared::poll(int distanceTraveled) {
     // If enough time has passed since this function last ran,
     if (this->_historyUpdater.isReadyToRun()) {
+        // Skip the readings taken while the sensor settles into a new range
+        // mode.
+        if (this->_settlingSamples > 0) {
+            this->_settlingSamples--;
+            return;
+        }
+
+        int16_t newReading = this->read();
+
         // add a new reading to the value history.
-        this->_valueHistory.add(this->read());
+        this->_valueHistory.add(newReading);
+        this->_lastReadingTime = millis();
+
+        // Add the raw reading to the edge detector, along with how far the
+        // robot had traveled when it was taken. Out of range readings are
+        // treated as the furthest distance that the sensor can see.
+        uint8_t edgeIndex = this->_edgeSampleCount % EDGE_HISTORY;
+        this->_edgeValues[edgeIndex] =
+            (newReading == -1) ? this->_maxRange : newReading;
+        this->_edgeDistances[edgeIndex] = distanceTraveled;
+        this->_edgeSampleCount++;
 
         // Update the most recent and second most recent values.
         this->_secondMostRecentValue = this->_mostRecentValue;
         this->_mostRecentValue = this->readSafe();
+
+        if (this->_range == AutoRange) {
+            this->_updateAutoRange();
+        }
+    }
+}
+
+/**
+ * @brief Writes a new shift value to the sensor, and updates the maximum
+ * range and the stored readings to match it.
+ *
+ * @param shiftValue The shift value to write, 1 for 128cm or 2 for 64cm.
+ */
+void Infrared::_writeShiftValue(uint8_t shiftValue) {
+    // Connect the current sensor to to the I2C bus.
+    this->_setMultiplexer();
+
+    // Write the new shift value to the shift register.
+    Wire.beginTransmission(IR_SLAVE_ADDRESS);
+    Wire.write(IR_SHIFT_REG_ADDRESS);
+    Wire.write(shiftValue);
+
+    // If the sensor did not acknowledge the write, raise a critical error.
+    if (Wire.endTransmission() != 0) {
+        String errorMessage =
+            "Cannot set range of IR sensor " + String(this->_index) + ".";
+        ErrorIndicator_G.errorOccurred(__FILE__, __LINE__, errorMessage);
+    }
+
+    this->_shiftValue = shiftValue;
+    this->_maxRange = (IR_DISTANCE_REG_MAX * 10) >> (4 + this->_shiftValue);
+
+    // All readings are stored in millimeters, so they stay valid across range
+    // modes, apart from the readings beyond the new max range, which are
+    // treated the same as an out of range reading would be.
+    this->_valueHistory.limitTo(this->_maxRange);
+
+    for (uint8_t i = 0; i < EDGE_HISTORY; i++) {
+        this->_edgeValues[i] = min(this->_edgeValues[i], this->_maxRange);
+    }
+
+    if (this->_mostRecentValue >= this->_maxRange) {
+        this->_mostRecentValue = -1;
+    }
+    if (this->_secondMostRecentValue >= this->_maxRange) {
+        this->_secondMostRecentValue = -1;
+    }
+
+    this->_settlingSamples = RANGE_SETTLING_SAMPLES;
+}
+
+/**
+ * @brief Switches between short and long range when in auto range mode,
+ * based on the recent readings.
+ */
+void Infrared::_updateAutoRange() {
+    // The median is used so that a single anomalous reading can't change the
+    // range mode.
+    int16_t medianReading = this->_valueHistory.getMedian();
+
+    bool inShortRange = (this->_shiftValue == SHORT_RANGE_SHIFT);
+
+    // If most of the recent readings are out of short range, switch to long
+    // range.
+    if (inShortRange && (medianReading == -1)) {
+        this->_writeShiftValue(LONG_RANGE_SHIFT);
+    }
+
+    // If something has come close in long range, switch back to short range
+    // for the extra precision.
+    else if (!inShortRange && (medianReading != -1) &&
+             (medianReading < AUTO_RANGE_SHORTEN_DISTANCE)) {
+        this->_writeShiftValue(SHORT_RANGE_SHIFT);
     }
 }
 
@@ -300,3 +476,164 @@ void Infrared::_setMultiplexer() {
     // End the transmission.
     Wire.endTransmission();
 }
+
+/**
+ * @brief Gets a reading from the edge detector history.
+ *
+ * @param samplesAgo How many samples ago the reading was taken, where 0
+ * is the most recent reading.
+ * @return (int) The reading, with out of range readings replaced by the
+ * maximum range.
+ */
+int Infrared::_getEdgeValue(uint32_t samplesAgo) {
+    uint32_t sampleNumber = this->_edgeSampleCount - 1 - samplesAgo;
+    return this->_edgeValues[sampleNumber % EDGE_HISTORY];
+}
+
+/**
+ * @brief Gets the distance the robot had traveled when a reading from the
+ * edge detector history was taken.
+ *
+ * @param samplesAgo How many samples ago the reading was taken, where 0
+ * is the most recent reading.
+ * @return (int32_t) The distance traveled in millimeters.
+ */
+int32_t Infrared::_getEdgeDistance(uint32_t samplesAgo) {
+    uint32_t sampleNumber = this->_edgeSampleCount - 1 - samplesAgo;
+    return this->_edgeDistances[sampleNumber % EDGE_HISTORY];
+}
+
+/**
+ * @brief Searches the recent readings for a step in distance, that has
+ * been confirmed by several readings either side of it.
+ *
+ * The readings on the near side of the step must all be within range and
+ * agree with each other, and the readings on the far side must all be
+ * further than the near side by at least the required change. A single
+ * transition reading is allowed between the two sides, for when the
+ * sensor catches the very edge of a brick.
+ *
+ * @param rising True to search for a rise in distance (ending corner),
+ * false to search for a drop in distance (starting corner).
+ * @param range The range that the near side of the step must be within.
+ * @param requiredDistanceChange The minimum size of the step.
+ * @param edgeSample_P The pointer used to return the sample number of the
+ * last reading before the step, used to identify the edge.
+ * @param wallDistance_P The pointer used to return the distance from the
+ * centre of the robot to the near side of the step.
+ * @param distanceSinceCorner_P The pointer used to return the distance
+ * that the robot has traveled since the interpolated step.
+ * @return (true) If a confirmed step was found.
+ * @return (false) If no confirmed step was found.
+ */
+bool Infrared::_findEdge(bool rising, int range, int requiredDistanceChange,
+                         uint32_t* edgeSample_P, int* wallDistance_P,
+                         int* distanceSinceCorner_P) {
+    const uint32_t sideLength = EDGE_CONFIRMATION_SAMPLES;
+
+    // The readings are split into the side before the step (older) and the
+    // side after the step (newer), with an optional transition reading
+    // between them.
+    for (uint32_t gap = 0; gap <= EDGE_TRANSITION_SAMPLES; gap++) {
+        uint32_t olderStart = sideLength + gap;
+
+        // If there are not enough readings yet, there cannot be an edge.
+        if (this->_edgeSampleCount < (olderStart + sideLength)) {
+            return false;
+        }
+
+        // A drop in distance has the wall on the newer side, and a rise in
+        // distance has the wall on the older side.
+        uint32_t nearStart = rising ? olderStart : 0;
+        uint32_t farStart = rising ? 0 : olderStart;
+
+        // Check that every reading of the wall is within range, and that they
+        // all agree with each other.
+        int nearMin = this->_maxRange;
+        int nearMax = 0;
+        int nearSum = 0;
+
+        for (uint32_t i = nearStart; i < (nearStart + sideLength); i++) {
+            int value = this->_getEdgeValue(i);
+            nearMin = min(nearMin, value);
+            nearMax = max(nearMax, value);
+            nearSum += value;
+        }
+
+        bool wallInRange = (nearMax < range);
+        bool wallIsStable = ((nearMax - nearMin) <= EDGE_STABILITY_TOLERANCE);
+
+        if (!(wallInRange && wallIsStable)) {
+            continue;
+        }
+
+        float nearLevel = (float)nearSum / sideLength;
+
+        // Check that every reading on the other side of the step is far enough
+        // away from the wall.
+        bool enoughChange = true;
+        int farSum = 0;
+
+        for (uint32_t i = farStart; i < (farStart + sideLength); i++) {
+            int value = this->_getEdgeValue(i);
+            farSum += value;
+
+            if (value <= (nearLevel + requiredDistanceChange)) {
+                enoughChange = false;
+            }
+        }
+
+        if (!enoughChange) {
+            continue;
+        }
+
+        float farLevel = (float)farSum / sideLength;
+
+        // The step is placed where the readings cross the halfway point
+        // between the two sides, interpolated using how far the robot traveled
+        // between each reading.
+        float midLevel = (nearLevel + farLevel) / 2;
+
+        float crossingDistance = this->_getEdgeDistance(sideLength);
+
+        // Search outwards from the newer side, so that the crossing closest to
+        // the confirmed readings is used.
+        for (uint32_t i = sideLength; i < (olderStart + sideLength); i++) {
+            float olderValue = this->_getEdgeValue(i);
+            float newerValue = this->_getEdgeValue(i - 1);
+
+            bool olderAbove = (olderValue >= midLevel);
+            bool newerAbove = (newerValue >= midLevel);
+
+            if (olderAbove != newerAbove) {
+                float olderDistance = this->_getEdgeDistance(i);
+                float newerDistance = this->_getEdgeDistance(i - 1);
+
+                float fraction =
+                    (olderValue - midLevel) / (olderValue - newerValue);
+
+                crossingDistance =
+                    olderDistance + (newerDistance - olderDistance) * fraction;
+                break;
+            }
+        }
+
+        // The edge is identified by the last reading before the step, which
+        // stays the same for every transition gap.
+        *edgeSample_P = this->_edgeSampleCount - 1 - olderStart;
+
+        if (wallDistance_P != nullptr) {
+            *wallDistance_P = round(nearLevel) + this->_distanceFromCentre;
+        }
+
+        if (distanceSinceCorner_P != nullptr) {
+            float currentDistance = this->_getEdgeDistance(0);
+            *distanceSinceCorner_P =
+                round(abs(currentDistance - crossingDistance));
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -22,6 +22,18 @@
 #include "history.h"
 #include "schedule.h"
 
+// The number of readings kept for detecting the corners of bricks.
+#define EDGE_HISTORY 8
+
+/**
+ * @brief The range modes that the infrared sensor can be set to.
+ */
+enum InfraredRange {
+    ShortRange,  // Up to 64cm, at the sensor's full resolution.
+    LongRange,   // Up to 128cm, at half of the sensor's resolution.
+    AutoRange    // Switches between the two based on what the sensor can see.
+};
+
 /**
  * @brief Responsible for reading valued from the GP2Y0E02B Infrared sensor,
  * and controlling the PCA9546 I2C multiplexer that connect the sensor to the
@@ -49,6 +61,22 @@ class Infrared {
      */
     void setup();
 
+    /**
+     * @brief Sets the range mode of the sensor. In auto range mode, the
+     * sensor switches to long range when nothing can be seen within short
+     * range, and back to short range when something comes close.
+     *
+     * @param range The range mode to use.
+     */
+    void setRange(InfraredRange range);
+
+    /**
+     * @brief Gets the maximum distance that the sensor can currently read.
+     *
+     * @return (int16_t) The maximum distance in millimeters.
+     */
+    int16_t getMaxRange();
+
     /**
      * @brief Read the distance from the sensor.
      *
@@ -81,31 +109,47 @@ class Infrared {
 
     /**
      * @brief Checks if the robot has seen a starting corner of a brick, based
-     * on the rate of change that the sensor has read. A sudden drop in distance
-     * indicated that a corner has been seen.
+     * on the edge detector run over the recent sample history. A confirmed
+     * drop in distance indicates that a corner has been seen.
+     *
+     * Each edge is only reported once, on the poll that confirms it.
      *
      * @param range The range that the newly seen reading has to be withing to
      * be considered valid.
      * @param requiredDistanceChange The amount the value must have dropped by
      * to be considered valid.
+     * @param wallDistance_P The pointer used to return the distance from the
+     * centre of the robot to the newly seen wall.
+     * @param distanceSinceCorner_P The pointer used to return the distance in
+     * millimeters that the robot has traveled since passing the corner.
      * @return (true) If a starting corner has been seen.
      * @return (false) If a starting corner has not been seen.
      */
-    bool seenStartingCorner(int range, int requiredDistanceChange);
+    bool seenStartingCorner(int range, int requiredDistanceChange,
+                            int* wallDistance_P = nullptr,
+                            int* distanceSinceCorner_P = nullptr);
 
     /**
      * @brief Checks if the robot has seen an ending corner of a brick, based
-     * on the rate of change that the sensor has read. A sudden rise in distance
-     * indicated that a ending corner has been seen.
+     * on the edge detector run over the recent sample history. A confirmed
+     * rise in distance indicates that a ending corner has been seen.
+     *
+     * Each edge is only reported once, on the poll that confirms it.
      *
      * @param range The range that the seen reading bust have been before
      * rising.
      * @param requiredDistanceChange The amount the value must have rose by
      * to be considered valid.
+     * @param wallDistance_P The pointer used to return the distance from the
+     * centre of the robot to the wall that has just ended.
+     * @param distanceSinceCorner_P The pointer used to return the distance in
+     * millimeters that the robot has traveled since passing the corner.
      * @return (true) If a ending corner has been seen.
      * @return (false) If a ending corner has not been seen.
      */
-    bool seenEndingCorner(int range, int requiredDistanceChange);
+    bool seenEndingCorner(int range, int requiredDistanceChange,
+                          int* wallDistance_P = nullptr,
+                          int* distanceSinceCorner_P = nullptr);
 
     /**
      * @brief Returns the median value from the reading history, this removed
@@ -117,10 +161,30 @@ class Infrared {
      */
     int16_t average();
 
+    /**
+     * @brief Gets the age of the most recent reading from the sensor.
+     *
+     * @return (uint32_t) The time in milliseconds since the value history was
+     * last updated.
+     */
+    uint32_t getAge();
+
+    /**
+     * @brief Gets the time of the most recent reading from the sensor, which
+     * only changes when a new reading is taken.
+     *
+     * @return (uint32_t) The time in milliseconds that the value history was
+     * last updated.
+     */
+    uint32_t getReadingTime();
+
     /**
      * @brief Updates the value history, if enough time has passed.
+     *
+     * @param distanceTraveled The distance in millimeters that the robot has
+     * traveled, used to place each sample along the robot's path.
      */
-    void poll();
+    void poll(int distanceTraveled = 0);
 
    private:
     /**
@@ -150,6 +214,29 @@ class Infrared {
      */
     uint8_t _shiftValue;
 
+    /**
+     * @brief The range mode that the sensor has been set to.
+     */
+    InfraredRange _range = ShortRange;
+
+    /**
+     * @brief The maximum distance that can be read with the current shift
+     * value, in millimeters.
+     */
+    int16_t _maxRange;
+
+    /**
+     * @brief The number of readings left to discard after the shift value has
+     * been changed, while the sensor settles into the new mode.
+     */
+    uint8_t _settlingSamples = 0;
+
+    /**
+     * @brief The time in milliseconds at which the value history was last
+     * updated.
+     */
+    uint32_t _lastReadingTime = 0;
+
     /**
      * @brief The most recent reading from the readSafe() function.
      */
@@ -160,6 +247,96 @@ class Infrared {
      */
     int _secondMostRecentValue = -1;
 
+    /**
+     * @brief The raw readings used by the edge detector, with out of range
+     * readings replaced by the maximum range, stored as a circular buffer.
+     */
+    int16_t _edgeValues[EDGE_HISTORY];
+
+    /**
+     * @brief The distance the robot had traveled when each of the readings in
+     * _edgeValues was taken.
+     */
+    int32_t _edgeDistances[EDGE_HISTORY];
+
+    /**
+     * @brief The total number of readings added to the edge detector.
+     */
+    uint32_t _edgeSampleCount = 0;
+
+    /**
+     * @brief The sample number of the last starting corner reported, used to
+     * only report each edge once.
+     */
+    uint32_t _lastStartingCornerSample = 0;
+
+    /**
+     * @brief The sample number of the last ending corner reported, used to
+     * only report each edge once.
+     */
+    uint32_t _lastEndingCornerSample = 0;
+
+    /**
+     * @brief Gets a reading from the edge detector history.
+     *
+     * @param samplesAgo How many samples ago the reading was taken, where 0
+     * is the most recent reading.
+     * @return (int) The reading, with out of range readings replaced by the
+     * maximum range.
+     */
+    int _getEdgeValue(uint32_t samplesAgo);
+
+    /**
+     * @brief Gets the distance the robot had traveled when a reading from the
+     * edge detector history was taken.
+     *
+     * @param samplesAgo How many samples ago the reading was taken, where 0
+     * is the most recent reading.
+     * @return (int32_t) The distance traveled in millimeters.
+     */
+    int32_t _getEdgeDistance(uint32_t samplesAgo);
+
+    /**
+     * @brief Searches the recent readings for a step in distance, that has
+     * been confirmed by several readings either side of it.
+     *
+     * The readings on the near side of the step must all be within range and
+     * agree with each other, and the readings on the far side must all be
+     * further than the near side by at least the required change. A single
+     * transition reading is allowed between the two sides, for when the
+     * sensor catches the very edge of a brick.
+     *
+     * @param rising True to search for a rise in distance (ending corner),
+     * false to search for a drop in distance (starting corner).
+     * @param range The range that the near side of the step must be within.
+     * @param requiredDistanceChange The minimum size of the step.
+     * @param edgeSample_P The pointer used to return the sample number of the
+     * last reading before the step, used to identify the edge.
+     * @param wallDistance_P The pointer used to return the distance from the
+     * centre of the robot to the near side of the step.
+     * @param distanceSinceCorner_P The pointer used to return the distance
+     * that the robot has traveled since the interpolated step.
+     * @return (true) If a confirmed step was found.
+     * @return (false) If no confirmed step was found.
+     */
+    bool _findEdge(bool rising, int range, int requiredDistanceChange,
+                   uint32_t* edgeSample_P, int* wallDistance_P,
+                   int* distanceSinceCorner_P);
+
+    /**
+     * @brief Writes a new shift value to the sensor, and updates the maximum
+     * range and the stored readings to match it.
+     *
+     * @param shiftValue The shift value to write, 1 for 128cm or 2 for 64cm.
+     */
+    void _writeShiftValue(uint8_t shiftValue);
+
+    /**
+     * @brief Switches between short and long range when in auto range mode,
+     * based on the recent readings.
+     */
+    void _updateAutoRange();
+
     /**
      * @brief Connects this sensor the the I2C bus by writing its index to the
      * multiplexer.
@@ -0,0 +1,63 @@
+/**
+ * @file lsm9ds1Imu.cpp
+ * @brief Definition of the Lsm9ds1Imu class, the Imu on board the Arduino
+ * Nano 33 BLE.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#include "lsm9ds1Imu.h"
+
+#include <Arduino_LSM9DS1.h>
+
+/**
+ * @brief Construct a new Lsm9ds1Imu object.
+ *
+ * @param yawInverted Whether the board is mounted upside down, so that the
+ * gyroscope's z axis points down.
+ */
+Lsm9ds1Imu::Lsm9ds1Imu(bool yawInverted) : _yawInverted(yawInverted) {}
+
+/**
+ * @brief Starts the IMU.
+ *
+ * @return (true) If the IMU was started.
+ * @return (false) If the IMU could not be found.
+ */
+bool Lsm9ds1Imu::setup() {
+    this->_isReady = IMU.begin();
+    return this->_isReady;
+}
+
+/**
+ * @brief Returns whether the IMU has been started successfully.
+ *
+ * @return (true) If the IMU is ready to read.
+ * @return (false) If the IMU isn't available.
+ */
+bool Lsm9ds1Imu::isReady() { return this->_isReady; }
+
+/**
+ * @brief Reads the rate that the robot is turning at, if a new sample is
+ * available.
+ *
+ * @param yawRate_P The pointer used to return the yaw rate in degrees per
+ * second, counter-clockwise positive.
+ * @return (true) If a new sample was read.
+ * @return (false) If there is no new sample.
+ */
+bool Lsm9ds1Imu::readYawRate(float* yawRate_P) {
+    if (!(this->_isReady && IMU.gyroscopeAvailable())) {
+        return false;
+    }
+
+    float x, y, z;
+    IMU.readGyroscope(x, y, z);
+
+    // With the board facing up, the z axis points up, so a positive rate
+    // about it is counter-clockwise when looking down on the robot.
+    *yawRate_P = this->_yawInverted ? -z : z;
+
+    return true;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file lsm9ds1Imu.h
+ * @brief Declaration of the Lsm9ds1Imu class, the Imu on board the Arduino
+ * Nano 33 BLE.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-13
+ * @copyright Copyright (c) 2024
+ */
+#ifndef LSM9DS1_IMU_H
+#define LSM9DS1_IMU_H
+
+#include <Arduino.h>
+
+#include "imu.h"
+
+/**
+ * @brief Lsm9ds1Imu class, reads the yaw rate from the gyroscope of the
+ * LSM9DS1 on board the Arduino Nano 33 BLE.
+ */
+class Lsm9ds1Imu : public Imu {
+   public:
+    /**
+     * @brief Construct a new Lsm9ds1Imu object.
+     *
+     * @param yawInverted Whether the board is mounted upside down, so that
+     * the gyroscope's z axis points down.
+     */
+    Lsm9ds1Imu(bool yawInverted);
+
+    /**
+     * @brief Starts the IMU.
+     *
+     * @return (true) If the IMU was started.
+     * @return (false) If the IMU could not be found.
+     */
+    bool setup() override;
+
+    /**
+     * @brief Returns whether the IMU has been started successfully.
+     *
+     * @return (true) If the IMU is ready to read.
+     * @return (false) If the IMU isn't available.
+     */
+    bool isReady() override;
+
+    /**
+     * @brief Reads the rate that the robot is turning at, if a new sample is
+     * available.
+     *
+     * @param yawRate_P The pointer used to return the yaw rate in degrees per
+     * second, counter-clockwise positive.
+     * @return (true) If a new sample was read.
+     * @return (false) If there is no new sample.
+     */
+    bool readYawRate(float* yawRate_P) override;
+
+   private:
+    /**
+     * @brief Whether the board is mounted upside down.
+     */
+    bool _yawInverted;
+
+    /**
+     * @brief Whether the IMU was started successfully.
+     */
+    bool _isReady = false;
+};
+
+#endif  // LSM9DS1_IMU_H
@@ -11,22 +11,49 @@
 #include "map.h"
 
 #include <queue>
+#include <vector>
 
 #include "angleAndPosition.h"
 #include "brick.h"
 #include "errorIndicator.h"
+#include "pathLimits.h"
 
 /**
  * @brief The maximum value of an 11 bit unsigned integer, equivalent to 2047
  */
 #define UINT11_MAX (0x7ff)
 
+/**
+ * @brief The maximum value of a 4 bit unsigned integer, equivalent to 15
+ */
+#define UINT4_MAX (0xf)
+
 #define ROBOT_RADIUS 120
 
 // 2 and 3 are roughly proportional to 1 and sqrt(2), while remaining integers.
 #define ORTHOGONAL_DISTANCE 2
 #define DIAGONAL_DISTANCE 3
 
+// The slowest and fastest speeds in millimeters per second that the safeSpeed
+// layer is filled with, the same as the limits of the path followers, so that
+// they agree with the map about how fast each part of the path can be driven.
+#define MAP_MIN_SPEED PATH_MIN_SPEED
+#define MAP_MAX_SPEED PATH_MAX_SPEED
+
+// How much faster in millimeters per second it is safe to drive for each
+// millimeter of clearance the robot has from the closest wall, on top of its
+// radius.
+#define SPEED_PER_CLEARANCE 5
+
+// The number of cells along the path between the points used to measure how
+// sharply the path turns, so that the steps between orthogonal and diagonal
+// directions average out.
+#define TURN_CHORD_LENGTH 15
+
+// The number of cells along the path between each waypoint of an extracted
+// path, so 50mm between waypoints.
+#define PATH_WAYPOINT_SPACING 5
+
 /**
  * @brief Construct a new Map Point object
  *
@@ -194,7 +221,7 @@ void Map::incrementSeenPosition(Position seenPosition) {
     // If the given position has been seen less times than its max value,
     // increment its count.
     int currentSeenCount = this->_getSeen(seenPoint);
-    if (currentSeenCount < UINT8_MAX) {
+    if (currentSeenCount < UINT4_MAX) {
         this->_setSeen(seenPoint, currentSeenCount + 1);
     };
 }
@@ -345,6 +372,9 @@ void Map::solve(BrickList brickList, Position endPosition) {
     // After the distances in the map have all been solved, set all the
     // directions.
     this->_populateDirections();
+
+    // The safe speeds depend on the path ahead, so they are set last.
+    this->_populateSafeSpeeds();
 }
 
 /**
@@ -385,8 +415,131 @@ void Map::updateAngleToDrive(Position robotPosition, Angle* angleToUpdate_P) {
     *angleToUpdate_P = direction_I * 45;
 }
 
+/**
+ * @brief Gets the distance to the goal from a given position, via the
+ * path calculated by solve().
+ *
+ * @param position The position to look up.
+ * @return (int) The distance to the goal, in the same units as the
+ * distanceToGoal layer.
+ * @return (-1) If the position is off the map or blocked.
+ */
+int Map::getDistanceToGoal(Position position) {
+    MapPoint point;
+    point.setFromPosition(position);
+
+    if (!this->_validatePoint(point) || this->_getBlocked(point)) {
+        return -1;
+    }
+
+    return this->_getDistanceToGoal(point);
+}
+
+/**
+ * @brief Gets the distance from a given position to the closest wall.
+ *
+ * @param position The position to look up.
+ * @return (int) The distance to the closest wall in millimeters, capped
+ * at 255.
+ * @return (-1) If the position is off the map.
+ */
+int Map::getDistanceToWall(Position position) {
+    MapPoint point;
+    point.setFromPosition(position);
+
+    if (!this->_validatePoint(point)) {
+        return -1;
+    }
+
+    return this->_getDistanceToWall(point);
+}
+
+/**
+ * @brief Gets the fastest speed that is safe to drive at from a given
+ * position, based on how close the walls are and how sharply the path
+ * calculated by solve() turns ahead of it.
+ *
+ * @param position The position to look up.
+ * @return (int) The safe speed in millimeters per second.
+ * @return (-1) If the position is off the map.
+ */
+int Map::getSafeSpeed(Position position) {
+    MapPoint point;
+    point.setFromPosition(position);
+
+    if (!this->_validatePoint(point)) {
+        return -1;
+    }
+
+    return MAP_MIN_SPEED + (this->_getSafeSpeed(point) * MAP_SPEED_STEP);
+}
+
+/**
+ * @brief Extracts the path calculated by solve() from a given position to the
+ * goal, as a list of waypoints spaced evenly along the direction layer.
+ *
+ * @param startPosition The position to start the path from, which is used as
+ * the first waypoint.
+ * @param path_P The pointer used to return the waypoints, ending at the goal.
+ * @return (true) If a path to the goal was found.
+ * @return (false) If the start position is off the map or can't reach the
+ * goal, in which case the path is left empty.
+ */
+bool Map::extractPath(Position startPosition, std::vector<Position>* path_P) {
+    path_P->clear();
+
+    MapPoint point;
+    point.setFromPosition(startPosition);
+
+    if (!this->_validatePoint(point)) {
+        return false;
+    }
+
+    // Cells that the flood fill never reached have no route to the goal.
+    if (this->_getDistanceToGoal(point) == UINT11_MAX) {
+        return false;
+    }
+
+    path_P->push_back(startPosition);
+
+    // Every step moves one cell closer to the goal, so the path can't be
+    // longer than the number of cells in the map.
+    int maxWaypoints = this->_dimension / PATH_WAYPOINT_SPACING;
+
+    for (int i = 0; i < maxWaypoints; i++) {
+        if (this->_getDistanceToGoal(point) == 0) {
+            break;
+        }
+
+        MapPoint nextPoint = this->_followPath(point, PATH_WAYPOINT_SPACING);
+
+        // The path has stopped at the edge of the map.
+        if (nextPoint == point) {
+            break;
+        }
+
+        point = nextPoint;
+        path_P->push_back(point.createPosition());
+    }
+
+    if (this->_getDistanceToGoal(point) != 0) {
+        path_P->clear();
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief Send the entire contents of the Map over the serial port.
+ *
+ * Each cell is sent as its x and y position, one byte each, followed by the
+ * four bytes of its MapItem, least significant byte first. From the least
+ * significant bit of the MapItem, the fields are been (bit 0), blocked (bit
+ * 1), direction (bits 2-4), distanceToGoal (bits 5-15), distanceToWall (bits
+ * 16-23), seen (bits 24-27) and safeSpeed (bits 28-31). Before the safeSpeed
+ * layer was added, seen took up all of bits 24-31, so older readers of the
+ * serial data will see the two fields as one.
  */
 void Map::sendOverSerial() {
     // Create a new stuck to bundle the x and y position of a MapItem, along
@@ -505,6 +658,110 @@ void Map::_populateDirections() {
     }
 }
 
+/**
+ * @brief Iterates through each point in the map and calculates the fastest
+ * speed that is safe to drive at, from the distance to the wall and the
+ * sharpest turn along the path ahead. This must be called after the
+ * directions have been populated.
+ */
+void Map::_populateSafeSpeeds() {
+    // Iterate through every point on the map.
+    for (int index = 0; index < this->_dimension; index++) {
+        int x = index % this->_width;
+        int y = index / this->_width;
+
+        MapPoint scanPoint = MapPoint(x, y);
+
+        // Blocked points are too close to a wall to drive quickly.
+        if (this->_getBlocked(scanPoint)) {
+            this->_setSafeSpeed(scanPoint, 0);
+            continue;
+        }
+
+        // The more room there is either side of the robot, the less it
+        // matters if it wanders off the path.
+        int clearance = this->_getDistanceToWall(scanPoint) - ROBOT_RADIUS;
+        float clearanceSpeed = MAP_MIN_SPEED + SPEED_PER_CLEARANCE * clearance;
+
+        // The turn ahead is measured between two chords along the path, and
+        // the radius of the circle through their ends gives the speed the
+        // robot can take it at, v = sqrt(a * r).
+        MapPoint middlePoint = this->_followPath(scanPoint, TURN_CHORD_LENGTH);
+        MapPoint endPoint = this->_followPath(middlePoint, TURN_CHORD_LENGTH);
+
+        int firstChordX = middlePoint.x - scanPoint.x;
+        int firstChordY = middlePoint.y - scanPoint.y;
+        int secondChordX = endPoint.x - middlePoint.x;
+        int secondChordY = endPoint.y - middlePoint.y;
+
+        float firstChordLength =
+            sqrtf(firstChordX * firstChordX + firstChordY * firstChordY);
+        float secondChordLength =
+            sqrtf(secondChordX * secondChordX + secondChordY * secondChordY);
+
+        float turnSpeed = MAP_MAX_SPEED;
+
+        // If the path reaches the goal before the end of either chord, there
+        // is no turn to slow down for.
+        if ((firstChordLength > 0) && (secondChordLength > 0)) {
+            float cosineOfTurn = (firstChordX * secondChordX +
+                                  firstChordY * secondChordY) /
+                                 (firstChordLength * secondChordLength);
+            cosineOfTurn = constrain(cosineOfTurn, -1.0f, 1.0f);
+
+            // sin(turn / 2) from the half angle formula.
+            float sineOfHalfTurn = sqrtf((1 - cosineOfTurn) / 2);
+
+            if (sineOfHalfTurn > 0) {
+                // The chords are in centimeters, the radius is in
+                // millimeters.
+                float averageChordLength =
+                    (firstChordLength + secondChordLength) / 2;
+                float turnRadius =
+                    averageChordLength * 10 / (2 * sineOfHalfTurn);
+
+                turnSpeed = sqrtf(PATH_LATERAL_ACCELERATION * turnRadius);
+            }
+        }
+
+        float safeSpeed = min(clearanceSpeed, turnSpeed);
+        safeSpeed = constrain(safeSpeed, MAP_MIN_SPEED, MAP_MAX_SPEED);
+
+        // Round down, so that the stored speed is never faster than is safe.
+        this->_setSafeSpeed(
+            scanPoint, (uint8_t)((safeSpeed - MAP_MIN_SPEED) / MAP_SPEED_STEP));
+    }
+}
+
+/**
+ * @brief Follows the direction layer from a given point, for a given number of
+ * steps or until the goal is reached.
+ *
+ * @param startPoint The point to start from.
+ * @param steps The number of cells to move.
+ * @return (MapPoint) The point that was reached.
+ */
+MapPoint Map::_followPath(MapPoint startPoint, int steps) {
+    MapPoint point = startPoint;
+
+    for (int step = 0; step < steps; step++) {
+        if (this->_getDistanceToGoal(point) == 0) {
+            break;
+        }
+
+        uint8_t direction_I = this->_getDirection(point);
+        MapPoint nextPoint = point + this->_neighbors[direction_I];
+
+        if (!this->_validatePoint(nextPoint)) {
+            break;
+        }
+
+        point = nextPoint;
+    }
+
+    return point;
+}
+
 /**
  * @brief Takes a given point and test whether it is with the bounds of the
  * map.
@@ -782,6 +1039,43 @@ void Map::_setSeen(MapPoint point, uint8_t seenOccurrence) {
     }
 }
 
+/**
+ * @brief Gets the "safeSpeed" value at given point on the map.
+ *
+ * @param point The given point of the map.
+ * @return (uint8_t) The safe speed, in steps of MAP_SPEED_STEP above
+ * PATH_MIN_SPEED.
+ */
+uint8_t Map::_getSafeSpeed(MapPoint point) {
+    if (this->_validatePoint(point)) {
+        return this->_mapData[point.y][point.x].safeSpeed;
+    } else {
+        String errorMessage = "";
+        errorMessage += point.toString();
+        errorMessage += " is out of range.";
+        ErrorIndicator_G.errorOccurred(__FILE__, __LINE__, errorMessage);
+        return 0;
+    }
+}
+
+/**
+ * @brief Sets the "safeSpeed" value at given point on the map.
+ *
+ * @param point The given point of the map.
+ * @param newSafeSpeed The safe speed, in steps of MAP_SPEED_STEP above
+ * PATH_MIN_SPEED.
+ */
+void Map::_setSafeSpeed(MapPoint point, uint8_t newSafeSpeed) {
+    if (this->_validatePoint(point)) {
+        this->_mapData[point.y][point.x].safeSpeed = newSafeSpeed;
+    } else {
+        String errorMessage = "";
+        errorMessage += point.toString();
+        errorMessage += " is out of range.";
+        ErrorIndicator_G.errorOccurred(__FILE__, __LINE__, errorMessage);
+    }
+}
+
 /**
  * @brief Resets all the data in a Map by setting evert value of every layer
  * to 0, aside from the distanceToGoal layer, in which evert value is set
@@ -800,5 +1094,6 @@ void Map::_resetData() {
         this->_setDirection(scanPoint, 0);
         this->_setDistanceToGoal(scanPoint, UINT11_MAX);
         this->_setDistanceToWall(scanPoint, 0);
+        this->_setSafeSpeed(scanPoint, 0);
     }
 }
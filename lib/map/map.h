@@ -12,6 +12,8 @@
 
 #include <Arduino.h>
 
+#include <vector>
+
 /**
  * @brief The number of rows in the map, equal to the hight of the map in
  * centimeters.
@@ -23,6 +25,13 @@
  */
 #define MAP_WIDTH_CM 150
 
+/**
+ * @brief The size of each step of the safeSpeed layer, in millimeters per
+ * second. The layer counts up from PATH_MIN_SPEED, so the 15 steps cover up to
+ * 415 mm/s, just under PATH_MAX_SPEED.
+ */
+#define MAP_SPEED_STEP 25
+
 // Forwards declaration of BrickList, Position and Angle class.
 class BrickList;
 class Position;
@@ -155,10 +164,17 @@ struct __attribute__((packed)) MapItem {
     unsigned int distanceToWall : 8;
 
     /**
-     * @brief how mant times a cell has been seen by a sensor , as an 8 bit
-     * unsigned integer, 0 - 255.
+     * @brief how mant times a cell has been seen by a sensor , as a 4 bit
+     * unsigned integer, 0 - 15.
      */
-    unsigned int seen : 8;
+    unsigned int seen : 4;
+
+    /**
+     * @brief The fastest speed that is safe to drive at from the current cell,
+     * in steps of MAP_SPEED_STEP millimeters per second above PATH_MIN_SPEED,
+     * as a 4 bit unsigned integer, 0 - 15.
+     */
+    unsigned int safeSpeed : 4;
 };
 
 class Map {
@@ -231,8 +247,64 @@ class Map {
      */
     void updateAngleToDrive(Position robotPosition, Angle* angleToUpdate_P);
 
+    /**
+     * @brief Gets the distance to the goal from a given position, via the
+     * path calculated by solve().
+     *
+     * @param position The position to look up.
+     * @return (int) The distance to the goal, in the same units as the
+     * distanceToGoal layer.
+     * @return (-1) If the position is off the map or blocked.
+     */
+    int getDistanceToGoal(Position position);
+
+    /**
+     * @brief Gets the distance from a given position to the closest wall.
+     *
+     * @param position The position to look up.
+     * @return (int) The distance to the closest wall in millimeters, capped
+     * at 255.
+     * @return (-1) If the position is off the map.
+     */
+    int getDistanceToWall(Position position);
+
+    /**
+     * @brief Gets the fastest speed that is safe to drive at from a given
+     * position, based on how close the walls are and how sharply the path
+     * calculated by solve() turns ahead of it.
+     *
+     * @param position The position to look up.
+     * @return (int) The safe speed in millimeters per second.
+     * @return (-1) If the position is off the map.
+     */
+    int getSafeSpeed(Position position);
+
+    /**
+     * @brief Extracts the path calculated by solve() from a given position to
+     * the goal, as a list of waypoints spaced evenly along the direction
+     * layer.
+     *
+     * @param startPosition The position to start the path from, which is used
+     * as the first waypoint.
+     * @param path_P The pointer used to return the waypoints, ending at the
+     * goal.
+     * @return (true) If a path to the goal was found.
+     * @return (false) If the start position is off the map or can't reach the
+     * goal, in which case the path is left empty.
+     */
+    bool extractPath(Position startPosition, std::vector<Position>* path_P);
+
     /**
      * @brief Send the entire contents of the Map over the serial port.
+     *
+     * Each cell is sent as its x and y position, one byte each, followed by
+     * the four bytes of its MapItem, least significant byte first. From the
+     * least significant bit of the MapItem, the fields are been (bit 0),
+     * blocked (bit 1), direction (bits 2-4), distanceToGoal (bits 5-15),
+     * distanceToWall (bits 16-23), seen (bits 24-27) and safeSpeed (bits
+     * 28-31). Before the safeSpeed layer was added, seen took up all of bits
+     * 24-31, so older readers of the serial data will see the two fields as
+     * one.
      */
     void sendOverSerial();
 
@@ -276,6 +348,24 @@ class Map {
      */
     void _populateDirections();
 
+    /**
+     * @brief Iterates through each point in the map and calculates the
+     * fastest speed that is safe to drive at, from the distance to the wall
+     * and the sharpest turn along the path ahead. This must be called after
+     * the directions have been populated.
+     */
+    void _populateSafeSpeeds();
+
+    /**
+     * @brief Follows the direction layer from a given point, for a given
+     * number of steps or until the goal is reached.
+     *
+     * @param startPoint The point to start from.
+     * @param steps The number of cells to move.
+     * @return (MapPoint) The point that was reached.
+     */
+    MapPoint _followPath(MapPoint startPoint, int steps);
+
     /**
      * @brief Takes a given point and test whether it is with the bounds of the
      * map.
@@ -396,6 +486,24 @@ class Map {
      */
     void _setSeen(MapPoint point, uint8_t seenOccurrence);
 
+    /**
+     * @brief Gets the "safeSpeed" value at given point on the map.
+     *
+     * @param point The given point of the map.
+     * @return (uint8_t) The safe speed, in steps of MAP_SPEED_STEP above
+     * PATH_MIN_SPEED.
+     */
+    uint8_t _getSafeSpeed(MapPoint point);
+
+    /**
+     * @brief Sets the "safeSpeed" value at given point on the map.
+     *
+     * @param point The given point of the map.
+     * @param newSafeSpeed The safe speed, in steps of MAP_SPEED_STEP above
+     * PATH_MIN_SPEED.
+     */
+    void _setSafeSpeed(MapPoint point, uint8_t newSafeSpeed);
+
     /**
      * @brief Resets all the data in a Map by setting evert value of every layer
      * to 0, aside from the distanceToGoal layer, in which evert value is set
@@ -0,0 +1,232 @@
+/**
+ * @file motionMonitor.cpp
+ * @brief Definition of the MotionMonitor class, responsible for detecting
+ * when the wheels slip or stall, or when the robot is blocked, by comparing
+ * the commanded motion with the measured motion.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-14
+ * @copyright Copyright (c) 2024
+ */
+#include "motionMonitor.h"
+
+#include "drive.h"
+#include "infrared.h"
+#include "motionTracker.h"
+#include "motor.h"
+
+// The period in milliseconds between checks of the motion.
+#define MOTION_MONITOR_POLL_RATE 10
+
+// The slowest commanded wheel speed in millimeters per second that is checked
+// for a stall, below this the wheel can legitimately be too slow to measure.
+#define STALL_MIN_SPEED 80
+
+// The fraction of the commanded speed that a wheel has to reach to not count
+// as stalling, low enough that a wheel still spinning up isn't caught.
+#define STALL_SPEED_FRACTION 0.25f
+
+// How long in milliseconds a wheel has to be stalling for to be reported.
+#define STALL_TIME 50
+
+// The length in milliseconds of each window that the front distance is
+// compared with the distance traveled over.
+#define BLOCKED_WINDOW_TIME 75
+
+// The number of windows in a row that the robot has to be blocked for to be
+// reported.
+#define BLOCKED_WINDOW_COUNT 2
+
+// The least distance in millimeters that the wheels have to travel in a
+// window for the window to be checked.
+#define BLOCKED_MIN_TRAVEL 10
+
+// The fraction of the distance traveled by the wheels that the front distance
+// has to change by for the robot to not count as blocked.
+#define BLOCKED_CLOSING_FRACTION 0.3f
+
+// The furthest an object can be in front of the robot in millimeters for it to
+// be used to check if the robot is blocked.
+#define BLOCKED_MAX_FRONT_DISTANCE 400
+
+/**
+ * @brief Construct a new MotionMonitor object.
+ *
+ * @param drive_P Pointer to the drive, used to get the commanded speeds.
+ * @param leftMotor_P Pointer to the left motor, used to get its measured
+ * speed.
+ * @param rightMotor_P Pointer to the right motor, used to get its measured
+ * speed.
+ * @param frontLeftInfrared_P Pointer to the front left infrared sensor.
+ * @param frontRightInfrared_P Pointer to the front right infrared sensor.
+ * @param motionTracker_P Pointer to the motion tracker, used to get the
+ * distance traveled and the number of slips seen by the heading filter.
+ */
+MotionMonitor::MotionMonitor(Drive* drive_P, Motor* leftMotor_P,
+                             Motor* rightMotor_P,
+                             Infrared* frontLeftInfrared_P,
+                             Infrared* frontRightInfrared_P,
+                             MotionTracker* motionTracker_P)
+    : _drive_P(drive_P),
+      _leftMotor_P(leftMotor_P),
+      _rightMotor_P(rightMotor_P),
+      _frontLeftInfrared_P(frontLeftInfrared_P),
+      _frontRightInfrared_P(frontRightInfrared_P),
+      _motionTracker_P(motionTracker_P),
+      _pollSchedule(MOTION_MONITOR_POLL_RATE) {}
+
+/**
+ * @brief Checks the commanded motion against the measured motion, at a fixed
+ * rate.
+ *
+ * @return (MotionEvent) The event that has just started, or NoMotionEvent if
+ * nothing new has gone wrong. If several start at once, the most serious is
+ * returned, Blocked first and WheelSlip last.
+ */
+MotionEvent MotionMonitor::poll() {
+    if (!this->_pollSchedule.isReadyToRun()) {
+        return NoMotionEvent;
+    }
+
+    bool leftStalled = this->_checkStall(
+        this->_drive_P->getLeftCommandedSpeed(),
+        this->_leftMotor_P->getVelocity(), &this->_leftStallStartTime);
+    bool rightStalled = this->_checkStall(
+        this->_drive_P->getRightCommandedSpeed(),
+        this->_rightMotor_P->getVelocity(), &this->_rightStallStartTime);
+    bool blocked = this->_checkBlocked();
+
+    uint32_t slipCount = this->_motionTracker_P->getSlipCount();
+    bool slipped = slipCount != this->_lastSlipCount;
+    this->_lastSlipCount = slipCount;
+
+    // Only report each condition when it starts.
+    bool blockedStarted = blocked && !this->_wasBlocked;
+    bool leftStallStarted = leftStalled && !this->_leftWasStalled;
+    bool rightStallStarted = rightStalled && !this->_rightWasStalled;
+
+    this->_wasBlocked = blocked;
+    this->_leftWasStalled = leftStalled;
+    this->_rightWasStalled = rightStalled;
+
+    if (blockedStarted) {
+        return Blocked;
+    }
+    if (leftStallStarted) {
+        return LeftWheelStall;
+    }
+    if (rightStallStarted) {
+        return RightWheelStall;
+    }
+    if (slipped) {
+        return WheelSlip;
+    }
+    return NoMotionEvent;
+}
+
+/**
+ * @brief Checks if a wheel has been stalled for long enough to report.
+ *
+ * @param commandedSpeed The speed the wheel is being driven at, in
+ * millimeters per second.
+ * @param measuredSpeed The speed measured by the wheel's encoder, in
+ * millimeters per second.
+ * @param stallStartTime_P Pointer to the time the wheel started stalling, 0
+ * when it isn't stalling.
+ * @return (true) If the wheel has been stalled for at least STALL_TIME.
+ * @return (false) If the wheel is turning as expected.
+ */
+bool MotionMonitor::_checkStall(float commandedSpeed, float measuredSpeed,
+                                uint32_t* stallStartTime_P) {
+    // The measured speed is taken in the direction of the commanded speed, so
+    // a wheel being pushed backwards counts as stalling too.
+    bool isStalling = (abs(commandedSpeed) >= STALL_MIN_SPEED) &&
+                      (measuredSpeed * commandedSpeed <
+                       STALL_SPEED_FRACTION * commandedSpeed * commandedSpeed);
+
+    if (!isStalling) {
+        *stallStartTime_P = 0;
+        return false;
+    }
+
+    uint32_t currentTime = millis();
+
+    if (*stallStartTime_P == 0) {
+        // Avoid 0, as it means the wheel isn't stalling.
+        *stallStartTime_P = max(currentTime, (uint32_t)1);
+        return false;
+    }
+
+    return (currentTime - *stallStartTime_P) >= STALL_TIME;
+}
+
+/**
+ * @brief Checks if the robot is blocked, by comparing how far the wheels have
+ * traveled with how much the front distance has changed, once per window.
+ *
+ * @return (true) If the robot has been blocked for BLOCKED_WINDOW_COUNT
+ * windows in a row.
+ * @return (false) If the robot is not blocked.
+ */
+bool MotionMonitor::_checkBlocked() {
+    uint32_t currentTime = millis();
+
+    if ((currentTime - this->_windowStartTime) < BLOCKED_WINDOW_TIME) {
+        return this->_blockedWindowCount >= BLOCKED_WINDOW_COUNT;
+    }
+
+    int distanceTraveled = this->_motionTracker_P->getDistanceTraveled();
+    int frontDistance = this->_readFrontDistance();
+
+    int wheelTravel = distanceTraveled - this->_windowStartDistanceTraveled;
+    int frontChange = this->_windowStartFrontDistance - frontDistance;
+
+    bool frontIsValid = (frontDistance != -1) &&
+                        (this->_windowStartFrontDistance != -1) &&
+                        (frontDistance < BLOCKED_MAX_FRONT_DISTANCE);
+
+    // Only forwards travel is checked, as there are no sensors behind the
+    // robot. The front distance has to stay put rather than just not close,
+    // so that a new object coming into view doesn't count.
+    bool windowIsBlocked =
+        frontIsValid && (wheelTravel >= BLOCKED_MIN_TRAVEL) &&
+        (abs(frontChange) < BLOCKED_CLOSING_FRACTION * wheelTravel);
+
+    if (windowIsBlocked) {
+        if (this->_blockedWindowCount < BLOCKED_WINDOW_COUNT) {
+            this->_blockedWindowCount++;
+        }
+    } else {
+        this->_blockedWindowCount = 0;
+    }
+
+    this->_windowStartTime = currentTime;
+    this->_windowStartDistanceTraveled = distanceTraveled;
+    this->_windowStartFrontDistance = frontDistance;
+
+    return this->_blockedWindowCount >= BLOCKED_WINDOW_COUNT;
+}
+
+/**
+ * @brief Reads the distance to the closest object in front of the robot, from
+ * the latest readings of the front infrared sensors.
+ *
+ * The raw readings are used rather than the FrontRange, as the FrontRange
+ * moves older readings along by the distance traveled by the wheels, which
+ * would hide the robot not moving.
+ *
+ * @return (int) The distance from the centre of the robot in millimeters, or
+ * -1 if neither sensor has a valid reading.
+ */
+int MotionMonitor::_readFrontDistance() {
+    int leftDistance = this->_frontLeftInfrared_P->readFromRobotCenter();
+    int rightDistance = this->_frontRightInfrared_P->readFromRobotCenter();
+
+    if (leftDistance == -1) {
+        return rightDistance;
+    }
+    if (rightDistance == -1) {
+        return leftDistance;
+    }
+    return min(leftDistance, rightDistance);
+}
@@ -0,0 +1,161 @@
+/**
+ * @file motionMonitor.h
+ * @brief Declaration of the MotionMonitor class, responsible for detecting
+ * when the wheels slip or stall, or when the robot is blocked, by comparing
+ * the commanded motion with the measured motion.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-14
+ * @copyright Copyright (c) 2024
+ */
+#ifndef MOTION_MONITOR_H
+#define MOTION_MONITOR_H
+
+#include <Arduino.h>
+
+#include "schedule.h"
+
+// Forward declaration of the Drive, Motor, Infrared and MotionTracker classes.
+class Drive;
+class Motor;
+class Infrared;
+class MotionTracker;
+
+/**
+ * @brief Enum for the events raised by the MotionMonitor.
+ */
+enum MotionEvent {
+    NoMotionEvent,
+    WheelSlip,
+    LeftWheelStall,
+    RightWheelStall,
+    Blocked
+};
+
+/**
+ * @brief MotionMonitor class, watches for the robot not moving the way it has
+ * been told to.
+ *
+ * - A wheel has stalled if it is being driven but has barely turned for a
+ * short time.
+ * - The robot is blocked if the wheels are turning forwards but the distance
+ * to whatever is in front of it isn't closing, meaning the wheels are
+ * spinning in place against something the bumpers didn't catch.
+ * - A wheel has slipped if the heading from the wheels disagreed with the
+ * gyroscope, which only works when there is an IMU.
+ *
+ * Each event is only reported once, on the poll that it starts on.
+ */
+class MotionMonitor {
+   public:
+    /**
+     * @brief Construct a new MotionMonitor object.
+     *
+     * @param drive_P Pointer to the drive, used to get the commanded speeds.
+     * @param leftMotor_P Pointer to the left motor, used to get its measured
+     * speed.
+     * @param rightMotor_P Pointer to the right motor, used to get its
+     * measured speed.
+     * @param frontLeftInfrared_P Pointer to the front left infrared sensor.
+     * @param frontRightInfrared_P Pointer to the front right infrared sensor.
+     * @param motionTracker_P Pointer to the motion tracker, used to get the
+     * distance traveled and the number of slips seen by the heading filter.
+     */
+    MotionMonitor(Drive* drive_P, Motor* leftMotor_P, Motor* rightMotor_P,
+                  Infrared* frontLeftInfrared_P,
+                  Infrared* frontRightInfrared_P,
+                  MotionTracker* motionTracker_P);
+
+    /**
+     * @brief Checks the commanded motion against the measured motion, at a
+     * fixed rate.
+     *
+     * @return (MotionEvent) The event that has just started, or NoMotionEvent
+     * if nothing new has gone wrong. If several start at once, the most
+     * serious is returned, Blocked first and WheelSlip last.
+     */
+    MotionEvent poll();
+
+   private:
+    /**
+     * @brief Checks if a wheel has been stalled for long enough to report.
+     *
+     * @param commandedSpeed The speed the wheel is being driven at, in
+     * millimeters per second.
+     * @param measuredSpeed The speed measured by the wheel's encoder, in
+     * millimeters per second.
+     * @param stallStartTime_P Pointer to the time the wheel started stalling,
+     * 0 when it isn't stalling.
+     * @return (true) If the wheel has been stalled for at least STALL_TIME.
+     * @return (false) If the wheel is turning as expected.
+     */
+    bool _checkStall(float commandedSpeed, float measuredSpeed,
+                     uint32_t* stallStartTime_P);
+
+    /**
+     * @brief Checks if the robot is blocked, by comparing how far the wheels
+     * have traveled with how much the front distance has changed, once per
+     * window.
+     *
+     * @return (true) If the robot has been blocked for BLOCKED_WINDOW_COUNT
+     * windows in a row.
+     * @return (false) If the robot is not blocked.
+     */
+    bool _checkBlocked();
+
+    /**
+     * @brief Reads the distance to the closest object in front of the robot,
+     * from the latest readings of the front infrared sensors.
+     *
+     * @return (int) The distance from the centre of the robot in millimeters,
+     * or -1 if neither sensor has a valid reading.
+     */
+    int _readFrontDistance();
+
+    Drive* _drive_P;
+    Motor* _leftMotor_P;
+    Motor* _rightMotor_P;
+    Infrared* _frontLeftInfrared_P;
+    Infrared* _frontRightInfrared_P;
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief The times in milliseconds that each wheel started stalling, or 0
+     * when it isn't stalling.
+     */
+    uint32_t _leftStallStartTime = 0;
+    uint32_t _rightStallStartTime = 0;
+
+    /**
+     * @brief The distance traveled and the front distance at the start of the
+     * current blocked window.
+     */
+    int _windowStartDistanceTraveled = 0;
+    int _windowStartFrontDistance = -1;
+    uint32_t _windowStartTime = 0;
+
+    /**
+     * @brief The number of windows in a row where the robot was blocked.
+     */
+    uint8_t _blockedWindowCount = 0;
+
+    /**
+     * @brief The number of slips seen by the heading filter on the last poll.
+     */
+    uint32_t _lastSlipCount = 0;
+
+    /**
+     * @brief Whether each condition was true on the last poll, so that only
+     * the start of each condition is reported.
+     */
+    bool _leftWasStalled = false;
+    bool _rightWasStalled = false;
+    bool _wasBlocked = false;
+
+    /**
+     * @brief The schedule that limits how often the motion is checked.
+     */
+    PassiveSchedule _pollSchedule;
+};
+
+#endif  // MOTION_MONITOR_H
@@ -1,44 +1,76 @@
 #include "motionTracker.h"
 
+#include "imu.h"
 #include "mazeConstants.h"
 
-// Calibrated value
-#define STEPS_PER_ROTATION 855
-
-// The period to wait between updating the angle and position.
-#define MOTION_TRACKER_POLL_RATE 10
-
 MotionTracker::MotionTracker(Motor* leftMotor_P, Motor* rightMotor_P,
-                             Angle statingAngle)
+                             Angle statingAngle, uint32_t pollPeriod,
+                             Imu* imu_P)
     : _leftMotor_P(leftMotor_P),
       _rightMotor_P(rightMotor_P),
       _statingAngle(statingAngle),
       _currentAngle(statingAngle),
       _angleCalibration(0),
-      _currentAverageDistance(0),
-      _lastAverageDistance(0),
+      _lastLeftSteps(0),
+      _lastRightSteps(0),
+      _wheelDifferencePerRotation(WHEEL_DIFFERENCE_PER_ROTATION),
+      _imu_P(imu_P),
+      _lastOdometryAngle(0),
+      _lastImuTime(0),
+      _lastMovementTime(0),
 
-      _pollSchedule(MOTION_TRACKER_POLL_RATE) {}
+      _pollSchedule(pollPeriod) {}
 
-// TODO Check if the values of distance traveled has changes before doing all
-// that maths
 Angle MotionTracker::angleFromOdometry() {
-    int leftTravelDistance = this->_leftMotor_P->getDistanceTraveled();
-    int rightTravelDistance = this->_rightMotor_P->getDistanceTraveled();
-
-    int16_t motorTravelDifference = rightTravelDistance - leftTravelDistance;
-
-    Angle angle = (int16_t)(motorTravelDifference * 360 / STEPS_PER_ROTATION);
-
-    return angle;
+    // Each wheel is converted to millimeters separately, as the wheels can be
+    // calibrated to slightly different sizes.
+    float leftTravel = this->_leftMotor_P->getSteps() /
+                       this->_leftMotor_P->getStepsPerMillimeter();
+    float rightTravel = this->_rightMotor_P->getSteps() /
+                        this->_rightMotor_P->getStepsPerMillimeter();
+
+    return this->_travelToAngle(rightTravel - leftTravel);
 }
 
 bool MotionTracker::updateAngle() {
-    Angle newAngle = this->_statingAngle + this->angleFromOdometry() +
-                     this->_angleCalibration;
+    Angle odometryAngle = this->angleFromOdometry();
+    Angle headingChange = odometryAngle;
+
+    // With an IMU, the heading from the wheels is fused with the gyroscope,
+    // so that wheel slip during fast turns doesn't corrupt it.
+    if ((this->_imu_P != nullptr) && this->_imu_P->isReady()) {
+        float yawRate;
+
+        if (this->_imu_P->readYawRate(&yawRate)) {
+            uint32_t currentTime = micros();
+
+            // The first sample only sets the time, as there is no time step
+            // to integrate over yet.
+            if (this->_lastImuTime != 0) {
+                float timeStep = (currentTime - this->_lastImuTime) / 1e6f;
+                float odometryChange =
+                    (odometryAngle - this->_lastOdometryAngle).getDegrees();
+                bool stationary =
+                    (millis() - this->_lastMovementTime) > STATIONARY_TIME;
+
+                this->_headingFilter.update(odometryChange, yawRate, timeStep,
+                                            stationary);
+            }
+
+            this->_lastImuTime = currentTime;
+            this->_lastOdometryAngle = odometryAngle;
+        }
+
+        headingChange = Angle::fromDegrees(this->_headingFilter.getAngle());
+    }
+
+    Angle newAngle =
+        this->_statingAngle + headingChange + this->_angleCalibration;
 
     bool hasMoved = false;
-    if (this->_currentAngle != newAngle) {
+    // Compare the binary angles, so that changes smaller than a degree are
+    // still picked up.
+    if (this->_currentAngle.getBinary() != newAngle.getBinary()) {
         hasMoved = true;
         this->_currentAngle = newAngle;
     }
@@ -47,23 +79,51 @@ bool MotionTracker::updateAngle() {
 }
 
 bool MotionTracker::updatePosition() {
-    bool hasMoved = false;
+    // The ISR keeps counting the steps between polls, so no steps are lost
+    // however long the gap between polls is.
+    int32_t leftSteps = this->_leftMotor_P->getSteps();
+    int32_t rightSteps = this->_rightMotor_P->getSteps();
 
-    int changeInDistance = this->_getChangeInDistance();
+    int32_t leftStepChange = leftSteps - this->_lastLeftSteps;
+    int32_t rightStepChange = rightSteps - this->_lastRightSteps;
 
-    if (changeInDistance != 0) {
-        hasMoved = true;
+    this->_lastLeftSteps = leftSteps;
+    this->_lastRightSteps = rightSteps;
+
+    if ((leftStepChange == 0) && (rightStepChange == 0)) {
+        return false;
+    }
 
-        float sinAngle = sin(this->_currentAngle.getRadians());
-        float cosAngle = cos(this->_currentAngle.getRadians());
+    this->_lastMovementTime = millis();
 
-        float xDif = changeInDistance * cosAngle;
-        float yDif = changeInDistance * sinAngle;
+    float leftTravelChange =
+        leftStepChange / this->_leftMotor_P->getStepsPerMillimeter();
+    float rightTravelChange =
+        rightStepChange / this->_rightMotor_P->getStepsPerMillimeter();
 
-        this->_currentPosition.x += xDif;
-        this->_currentPosition.y += yDif;
-    }
-    return hasMoved;
+    float changeInDistance = (leftTravelChange + rightTravelChange) / 2;
+
+    // The robot drives along an arc, so rather than moving along the heading
+    // at the end of the step, it moves along the chord of the arc, which
+    // points along the heading half way through the step.
+    Angle changeInAngle =
+        this->_travelToAngle(rightTravelChange - leftTravelChange);
+
+    Angle midpointAngle = this->_currentAngle -
+                          Angle::fromBinary(changeInAngle.getBinary() / 2);
+
+    // The chord is slightly shorter than the arc,
+    // chord = arc * sin(h) / h, where h is half of the change in angle.
+    // For the small angles turned between polls, sin(h) / h = 1 - h^2 / 6.
+    float halfChangeInAngle = changeInAngle.getRadians() / 2;
+    float chordScale = 1 - (halfChangeInAngle * halfChangeInAngle) / 6;
+
+    float chordLength = changeInDistance * chordScale;
+
+    this->_currentPosition.x += chordLength * midpointAngle.getCosine();
+    this->_currentPosition.y += chordLength * midpointAngle.getSine();
+
+    return true;
 }
 
 bool MotionTracker::poll() {
@@ -142,6 +202,41 @@ int MotionTracker::recalibratePosition(int frontDistance, int leftDistance) {
     return 0;
 }
 
+void MotionTracker::applyAngleCorrection(Angle correction) {
+    this->_angleCalibration += correction;
+    this->updateAngle();
+}
+
+void MotionTracker::applyPositionCorrection(Position correction) {
+    this->_currentPosition += correction;
+}
+
+void MotionTracker::setOdometryCalibration(float leftStepsPerMillimeter,
+                                           float rightStepsPerMillimeter,
+                                           float wheelDifferencePerRotation) {
+    // The heading from the wheels is worked out from the total steps since the
+    // start, so changing the calibration would make it jump. The jump is
+    // cancelled out, so that the new calibration only applies to movement
+    // from now on.
+    Angle oldOdometryAngle = this->angleFromOdometry();
+
+    this->_leftMotor_P->setStepsPerMillimeter(leftStepsPerMillimeter);
+    this->_rightMotor_P->setStepsPerMillimeter(rightStepsPerMillimeter);
+    this->_wheelDifferencePerRotation = wheelDifferencePerRotation;
+
+    Angle odometryJump = this->angleFromOdometry() - oldOdometryAngle;
+
+    // The heading filter only takes the change in the odometry angle between
+    // updates, so it just needs the last angle moving along with the jump.
+    this->_lastOdometryAngle += odometryJump;
+
+    if ((this->_imu_P == nullptr) || !this->_imu_P->isReady()) {
+        this->_angleCalibration -= odometryJump;
+    }
+
+    this->updateAngle();
+}
+
 Angle MotionTracker::getAngle() { return this->_currentAngle; }
 
 Position MotionTracker::getPosition() { return this->_currentPosition; }
@@ -153,6 +248,18 @@ Pose MotionTracker::getPose() {
     return poseToReturn;
 }
 
+int MotionTracker::getDistanceTraveled() { return this->_getAverageDistance(); }
+
+float MotionTracker::getGyroBias() { return this->_headingFilter.getBias(); }
+
+uint32_t MotionTracker::getSlipCount() {
+    return this->_headingFilter.getSlipCount();
+}
+
+float MotionTracker::getWheelDifferencePerRotation() {
+    return this->_wheelDifferencePerRotation;
+}
+
 int MotionTracker::_getAverageDistance() {
     int leftTravelDistance = this->_leftMotor_P->getDistanceTraveled();
     int rightTravelDistance = this->_rightMotor_P->getDistanceTraveled();
@@ -162,10 +269,14 @@ int MotionTracker::_getAverageDistance() {
     return averageTravelDistance;
 }
 
-int MotionTracker::_getChangeInDistance() {
-    this->_currentAverageDistance = this->_getAverageDistance();
-    int changeInDistance = _currentAverageDistance - _lastAverageDistance;
-    this->_lastAverageDistance = this->_currentAverageDistance;
+Angle MotionTracker::_travelToAngle(float travelDifference) {
+    // Only the difference within a single rotation matters, which also keeps
+    // the conversion to a binary angle from overflowing.
+    travelDifference =
+        fmodf(travelDifference, this->_wheelDifferencePerRotation);
+
+    int32_t binaryAngle = lroundf(travelDifference * BINARY_ANGLE_PER_ROTATION /
+                                  this->_wheelDifferencePerRotation);
 
-    return changeInDistance;
+    return Angle::fromBinary((int16_t)(uint16_t)binaryAngle);
 }
@@ -5,15 +5,26 @@
 
 #include "angleAndPosition.h"
 #include "bluetoothLowEnergy.h"
+#include "headingFilter.h"
 #include "motor.h"
 #include "schedule.h"
 
-// Forward declaration of the Motor class.
+// Forward declaration of the Motor and Imu classes.
 class Motor;
+class Imu;
+
+// The default period in milliseconds between updating the angle and position.
+#define MOTION_TRACKER_POLL_RATE 2
+
+// How long in milliseconds the wheels must be still for the robot to count as
+// stationary, so that the bias of the gyroscope can be learned.
+#define STATIONARY_TIME 200
 
 class MotionTracker {
    public:
-    MotionTracker(Motor* leftMotor_P, Motor* rightMotor_P, Angle statingAngle);
+    MotionTracker(Motor* leftMotor_P, Motor* rightMotor_P, Angle statingAngle,
+                  uint32_t pollPeriod = MOTION_TRACKER_POLL_RATE,
+                  Imu* imu_P = nullptr);
 
     Angle angleFromOdometry();
 
@@ -22,10 +33,19 @@ class MotionTracker {
     bool poll();
 
     int recalibratePosition(int frontDistance, int leftDistance);
+    void applyAngleCorrection(Angle correction);
+    void applyPositionCorrection(Position correction);
+    void setOdometryCalibration(float leftStepsPerMillimeter,
+                                float rightStepsPerMillimeter,
+                                float wheelDifferencePerRotation);
 
     Angle getAngle();
     Position getPosition();
     Pose getPose();
+    int getDistanceTraveled();
+    float getGyroBias();
+    uint32_t getSlipCount();
+    float getWheelDifferencePerRotation();
 
    private:
     Motor* _leftMotor_P;
@@ -36,13 +56,21 @@ class MotionTracker {
     Angle _currentAngle;
     Angle _angleCalibration;
 
-    int _currentAverageDistance;
-    int _lastAverageDistance;
+    int32_t _lastLeftSteps;
+    int32_t _lastRightSteps;
+
+    float _wheelDifferencePerRotation;
+
+    Imu* _imu_P;
+    HeadingFilter _headingFilter;
+    Angle _lastOdometryAngle;
+    uint32_t _lastImuTime;
+    uint32_t _lastMovementTime;
 
     PassiveSchedule _pollSchedule;
 
     int _getAverageDistance();
-    int _getChangeInDistance();
+    Angle _travelToAngle(float travelDifference);
 };
 
 #endif  // MOTION_TRACKER_H
\ No newline at end of file
@@ -2,6 +2,41 @@
 
 #include "errorIndicator.h"
 
+// The number of microseconds in a second.
+#define MICROSECONDS_PER_SECOND 1000000.0f
+
+// The length of the window that steps are counted over, in microseconds.
+#define VELOCITY_WINDOW 20000
+
+// The number of steps that need to be counted over a window before the count
+// is precise enough to be used over the cycle period. 16 steps in 20ms is
+// about 200mm/s.
+#define MIN_WINDOW_STEPS 16
+
+// The time in microseconds after the last edge that the wheel is assumed to
+// have stopped.
+#define VELOCITY_TIMEOUT 100000
+
+// The number of edges in the same direction needed for the cycle period to be
+// valid. The period is timed from the edge a full cycle ago, so that edge has
+// to be in the same direction too. This also means that every time used has
+// been written to the ring buffer since boot, rather than being its initial 0.
+#define EDGES_FOR_VALID_PERIOD (EDGES_PER_CYCLE + 1)
+
+// Marks a transition in the quadrature table where both channels changed.
+#define ILLEGAL_TRANSITION 2
+
+// The change in steps for each transition of the encoder, indexed by the
+// previous state in the upper two bits and the current state in the lower two
+// bits, where each state holds channel A in bit 1 and channel B in bit 0.
+// Driving forwards steps through the states 0, 2, 3, 1.
+static const int8_t QUADRATURE_TABLE[16] = {
+    0,  -1, 1,  ILLEGAL_TRANSITION,  // From state 0.
+    1,  0,  ILLEGAL_TRANSITION, -1,  // From state 1.
+    -1, ILLEGAL_TRANSITION, 0,  1,   // From state 2.
+    ILLEGAL_TRANSITION, 1,  -1, 0    // From state 3.
+};
+
 /**
  * @brief Construct a new Motor object
  *
@@ -34,8 +69,15 @@ void Motor::setup(voidFuncPtr isr_P) {
     pinMode(this->_encoderChannelA, INPUT);
     pinMode(this->_encoderChannelB, INPUT);
 
+    this->_encoderState = (digitalRead(this->_encoderChannelA) << 1) |
+                          digitalRead(this->_encoderChannelB);
+
+    // Interrupt on both channels so that all four edges of the quadrature
+    // cycle are counted.
     attachInterrupt(digitalPinToInterrupt(this->_encoderChannelA), isr_P,
                     CHANGE);
+    attachInterrupt(digitalPinToInterrupt(this->_encoderChannelB), isr_P,
+                    CHANGE);
 }
 
 /**
@@ -77,7 +119,7 @@ void Motor::stop() { this->_setSpeedAndDir(0, 0); }
  *
  * @return (int32_t) The distance traveled by the motor in millimeters.
  */
-long Motor::getDistanceTraveled() {
+int32_t Motor::getDistanceTraveled() {
     // One rotation is 300 steps
     // and the wheel circumference is 147.65mm
     // so 1 step is like 0.5mm
@@ -87,19 +129,183 @@ long Motor::getDistanceTraveled() {
     // further testing showed that 200 mm is 390 steps, so distance can be
     // calculated by dividing the steps by 1.95.
 
-    return this->_encoderSteps / 1.95;
+    // Counting every edge of both channels doubles this to 3.9.
+
+    return this->getSteps() / this->_stepsPerMillimeter;
 }
 
 /**
- * @brief The interrupt service routine for the encoder.
+ * @brief Gets the number of encoder steps the motor has taken, read with
+ * interrupts disabled so that the ISR can't change it mid read.
+ *
+ * @return (int32_t) The number of encoder steps.
+ */
+int32_t Motor::getSteps() {
+    noInterrupts();
+    int32_t encoderSteps = this->_encoderSteps;
+    interrupts();
+
+    return encoderSteps;
+}
+
+/**
+ * @brief Gets the number of illegal transitions seen by the encoder,
+ * where both channels changed at once, meaning that a step was missed.
+ *
+ * @return (uint32_t) The number of illegal transitions.
+ */
+uint32_t Motor::getEncoderErrors() {
+    noInterrupts();
+    uint32_t encoderErrors = this->_encoderErrors;
+    interrupts();
+
+    return encoderErrors;
+}
+
+/**
+ * @brief Gets a copy of the encoder state, read with interrupts disabled
+ * so that the values are all from the same edge.
+ *
+ * @return (EncoderSnapshot) The copy of the encoder state.
+ */
+EncoderSnapshot Motor::getEncoderSnapshot() {
+    EncoderSnapshot snapshot;
+
+    noInterrupts();
+    snapshot.steps = this->_encoderSteps;
+    snapshot.direction = this->_lastDirection;
+
+    // The last edge is the one before the next index in the ring buffer.
+    uint8_t lastIndex =
+        (this->_edgeIndex + EDGES_PER_CYCLE - 1) % EDGES_PER_CYCLE;
+    snapshot.lastEdgeTime = this->_edgeTimes[lastIndex];
+
+    // The period is only valid once a full cycle has been turned without the
+    // direction changing, from the edge a cycle ago to the latest edge.
+    snapshot.cyclePeriod =
+        (this->_edgesSinceReversal == EDGES_FOR_VALID_PERIOD)
+            ? this->_cyclePeriod
+            : 0;
+    interrupts();
+
+    return snapshot;
+}
+
+/**
+ * @brief Gets the velocity of the wheel in millimeters per second.
+ *
+ * At low speed this is calculated from the time taken by the last
+ * quadrature cycle, and at high speed from the number of steps counted
+ * over a fixed window.
+ *
+ * @return (float) The velocity of the wheel in millimeters per second,
+ * positive when driving forwards.
+ */
+float Motor::getVelocity() {
+    EncoderSnapshot snapshot = this->getEncoderSnapshot();
+    uint32_t currentTime = micros();
+
+    // Once the window is complete, count the steps taken across it.
+    uint32_t windowLength = currentTime - this->_windowStartTime;
+    if (windowLength >= VELOCITY_WINDOW) {
+        this->_windowSteps = snapshot.steps - this->_windowStartSteps;
+        this->_windowVelocity = this->_windowSteps * MICROSECONDS_PER_SECOND /
+                                (windowLength * this->_stepsPerMillimeter);
+
+        this->_windowStartSteps = snapshot.steps;
+        this->_windowStartTime = currentTime;
+    }
+
+    uint32_t timeSinceLastEdge = currentTime - snapshot.lastEdgeTime;
+
+    if ((snapshot.cyclePeriod == 0) || (timeSinceLastEdge > VELOCITY_TIMEOUT)) {
+        return 0;
+    }
+
+    // At high speed, the count is the more precise of the two, and isn't
+    // affected by jitter in the edge timestamps.
+    if (abs(this->_windowSteps) >= MIN_WINDOW_STEPS) {
+        return this->_windowVelocity;
+    }
+
+    // If the wheel is slowing down, the time since the last edge is already
+    // longer than the last period, so the wheel can be no faster than that.
+    uint32_t period = max(snapshot.cyclePeriod, timeSinceLastEdge);
+
+    float velocity = EDGES_PER_CYCLE * MICROSECONDS_PER_SECOND /
+                     (period * this->_stepsPerMillimeter);
+
+    return velocity * snapshot.direction;
+}
+
+/**
+ * @brief Sets the number of encoder steps per millimeter traveled by the
+ * wheel, used to convert the steps into distances and velocities.
+ *
+ * @param stepsPerMillimeter The number of steps per millimeter.
+ */
+void Motor::setStepsPerMillimeter(float stepsPerMillimeter) {
+    this->_stepsPerMillimeter = stepsPerMillimeter;
+}
+
+/**
+ * @brief Gets the number of encoder steps per millimeter traveled by the
+ * wheel.
+ *
+ * @return (float) The number of steps per millimeter.
+ */
+float Motor::getStepsPerMillimeter() { return this->_stepsPerMillimeter; }
+
+/**
+ * @brief The interrupt service routine for the encoder, called on every
+ * edge of both channels.
  *
  */
 void Motor::isr() {
-    if (digitalRead(this->_encoderChannelA) !=
-        (digitalRead(this->_encoderChannelB) ^ this->_rotationInverted)) {
-        this->_encoderSteps++;
-    } else {
-        this->_encoderSteps--;
+    uint8_t newState = (digitalRead(this->_encoderChannelA) << 1) |
+                       digitalRead(this->_encoderChannelB);
+
+    int8_t stepChange =
+        QUADRATURE_TABLE[(this->_encoderState << 2) | newState];
+
+    this->_encoderState = newState;
+
+    // The direction of the step can't be known if both channels changed, so
+    // it is counted as an error rather than a step.
+    if (stepChange == ILLEGAL_TRANSITION) {
+        this->_encoderErrors++;
+        return;
+    }
+
+    if (this->_rotationInverted) {
+        stepChange = -stepChange;
+    }
+
+    this->_encoderSteps += stepChange;
+
+    // Only a change in state counts as an edge, anything else is just noise.
+    if (stepChange == 0) {
+        return;
+    }
+
+    if (stepChange != this->_lastDirection) {
+        this->_lastDirection = stepChange;
+        this->_edgesSinceReversal = 0;
+    }
+
+    uint32_t currentTime = micros();
+
+    // The oldest time in the ring buffer is from the edge a full cycle ago,
+    // timing a full cycle rather than a single edge means that the uneven
+    // spacing of the edges within a cycle cancels out.
+    this->_cyclePeriod = currentTime - this->_edgeTimes[this->_edgeIndex];
+    this->_edgeTimes[this->_edgeIndex] = currentTime;
+    this->_edgeIndex = (this->_edgeIndex + 1) % EDGES_PER_CYCLE;
+
+    // The edge that reversed the direction counts as the first edge in the
+    // new direction.
+    if (this->_edgesSinceReversal < EDGES_FOR_VALID_PERIOD) {
+        this->_edgesSinceReversal++;
     }
 }
 
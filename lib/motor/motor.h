@@ -12,6 +12,46 @@
 
 #include <Arduino.h>
 
+// The default number of encoder steps per millimeter traveled by the wheel,
+// testing showed that 200 mm is 390 steps when counting only the edges of
+// channel A, and all four edges of the quadrature cycle gives twice as many.
+// This can be replaced at runtime by the odometry calibration.
+#define STEPS_PER_MILLIMETER 3.9f
+
+// The default difference in millimeters traveled by the two wheels for the
+// robot to turn a full rotation, this can also be replaced at runtime by the
+// odometry calibration.
+#define WHEEL_DIFFERENCE_PER_ROTATION 855
+
+// The number of edges in a full quadrature cycle of the encoder.
+#define EDGES_PER_CYCLE 4
+
+/**
+ * @brief Struct for storing a consistent copy of the encoder state, which is
+ * changed by the ISR.
+ */
+struct EncoderSnapshot {
+    /**
+     * @brief The number of encoder steps the motor has taken.
+     */
+    int32_t steps;
+    /**
+     * @brief The time of the last encoder edge in microseconds.
+     */
+    uint32_t lastEdgeTime;
+    /**
+     * @brief The time in microseconds taken by the last full quadrature
+     * cycle, or 0 if the motor hasn't turned a full cycle in the same
+     * direction.
+     */
+    uint32_t cyclePeriod;
+    /**
+     * @brief The direction of the last step, 1 for forwards and -1 for
+     * backwards.
+     */
+    int8_t direction;
+};
+
 /**
  * @brief Motor class, used to control a motor with an encoder.
  *
@@ -62,7 +102,60 @@ class Motor {
     int32_t getDistanceTraveled();
 
     /**
-     * @brief The interrupt service routine for the encoder.
+     * @brief Gets the number of encoder steps the motor has taken, read with
+     * interrupts disabled so that the ISR can't change it mid read.
+     *
+     * @return (int32_t) The number of encoder steps.
+     */
+    int32_t getSteps();
+
+    /**
+     * @brief Gets the number of illegal transitions seen by the encoder,
+     * where both channels changed at once, meaning that a step was missed.
+     *
+     * @return (uint32_t) The number of illegal transitions.
+     */
+    uint32_t getEncoderErrors();
+
+    /**
+     * @brief Gets a copy of the encoder state, read with interrupts disabled
+     * so that the values are all from the same edge.
+     *
+     * @return (EncoderSnapshot) The copy of the encoder state.
+     */
+    EncoderSnapshot getEncoderSnapshot();
+
+    /**
+     * @brief Gets the velocity of the wheel in millimeters per second.
+     *
+     * At low speed this is calculated from the time taken by the last
+     * quadrature cycle, and at high speed from the number of steps counted
+     * over a fixed window.
+     *
+     * @return (float) The velocity of the wheel in millimeters per second,
+     * positive when driving forwards.
+     */
+    float getVelocity();
+
+    /**
+     * @brief Sets the number of encoder steps per millimeter traveled by the
+     * wheel, used to convert the steps into distances and velocities.
+     *
+     * @param stepsPerMillimeter The number of steps per millimeter.
+     */
+    void setStepsPerMillimeter(float stepsPerMillimeter);
+
+    /**
+     * @brief Gets the number of encoder steps per millimeter traveled by the
+     * wheel.
+     *
+     * @return (float) The number of steps per millimeter.
+     */
+    float getStepsPerMillimeter();
+
+    /**
+     * @brief The interrupt service routine for the encoder, called on every
+     * edge of both channels.
      *
      */
     void isr();
@@ -102,6 +195,75 @@ class Motor {
      */
     volatile int32_t _encoderSteps = 0;
 
+    /**
+     * @brief The number of illegal transitions seen by the encoder.
+     */
+    volatile uint32_t _encoderErrors = 0;
+
+    /**
+     * @brief The last state of the encoder, with channel A in bit 1 and
+     * channel B in bit 0.
+     */
+    volatile uint8_t _encoderState = 0;
+
+    /**
+     * @brief The times in microseconds of the last four encoder edges, used
+     * as a ring buffer.
+     */
+    volatile uint32_t _edgeTimes[EDGES_PER_CYCLE] = {0};
+
+    /**
+     * @brief The index in _edgeTimes to write the next edge time to.
+     */
+    volatile uint8_t _edgeIndex = 0;
+
+    /**
+     * @brief The number of edges since the motor last changed direction,
+     * including the edge that changed it, capped at one more than
+     * EDGES_PER_CYCLE.
+     */
+    volatile uint8_t _edgesSinceReversal = 0;
+
+    /**
+     * @brief The time in microseconds taken by the last full quadrature
+     * cycle.
+     */
+    volatile uint32_t _cyclePeriod = 0;
+
+    /**
+     * @brief The direction of the last step, 1 for forwards and -1 for
+     * backwards.
+     */
+    volatile int8_t _lastDirection = 1;
+
+    /**
+     * @brief The number of steps at the start of the current velocity window.
+     */
+    int32_t _windowStartSteps = 0;
+
+    /**
+     * @brief The time in microseconds at the start of the current velocity
+     * window.
+     */
+    uint32_t _windowStartTime = 0;
+
+    /**
+     * @brief The number of steps counted over the last complete velocity
+     * window.
+     */
+    int32_t _windowSteps = 0;
+
+    /**
+     * @brief The velocity in millimeters per second, calculated from the
+     * number of steps counted over the last complete velocity window.
+     */
+    float _windowVelocity = 0;
+
+    /**
+     * @brief The number of encoder steps per millimeter traveled by the wheel.
+     */
+    float _stepsPerMillimeter = STEPS_PER_MILLIMETER;
+
     /**
      * @brief A boolean representing whether the motor's rotation is inverted.
      */
@@ -5,6 +5,23 @@
 #include "drive.h"
 #include "motionTracker.h"
 
+// The acceleration used for the motion profiles, in millimeters per second
+// squared when driving, and degrees per second squared when turning.
+#define PROFILE_ACCELERATION 600
+#define PROFILE_TURN_ACCELERATION 400
+
+// The slowest speeds that the profiles will decelerate down to, so that the
+// robot still creeps into the target rather than stalling short of it.
+#define PROFILE_MIN_SPEED 40
+#define PROFILE_MIN_TURN_SPEED 15
+
+// The largest time step in seconds that the profiles will ramp up over.
+#define PROFILE_MAX_TIME_STEP 0.05f
+
+// The distance in millimeters past a turn to aim for, so that the turn can be
+// driven as an arc.
+#define TURN_LEAD_OUT_DISTANCE 100
+
 PathPoint::operator String() const {
     String stringToReturn = "[";
 
@@ -19,8 +36,13 @@ PathPoint::operator String() const {
     return stringToReturn;
 }
 
-Navigator::Navigator(MotionTracker* motionTracker_P, Drive* drive_P)
-    : _motionTracker_P(motionTracker_P), _drive_P(drive_P) {}
+Navigator::Navigator(MotionTracker* motionTracker_P, Drive* drive_P,
+                     int maxSpeed, int maxTurnSpeed)
+    : _motionTracker_P(motionTracker_P),
+      _drive_P(drive_P),
+      _maxSpeed(maxSpeed),
+      _maxTurnSpeed(maxTurnSpeed),
+      _purePursuit(motionTracker_P, drive_P, maxSpeed) {}
 
 bool Navigator::hasNoPath() { return this->_pathQueue.empty(); }
 
@@ -57,6 +79,15 @@ void Navigator::turn(Angle localAngleToTurn, int distanceToDriveBeforeTurning) {
 
     if (distanceToDriveBeforeTurning != 0) {
         this->_pushLocalPosition(0, distanceToDriveBeforeTurning);
+
+        // Add a point past the turn in the new direction, so that the robot
+        // drives around the corner in an arc, rather than stopping and turning
+        // on the spot.
+        float leadOutX = -TURN_LEAD_OUT_DISTANCE * localAngleToTurn.getSine();
+        float leadOutY = TURN_LEAD_OUT_DISTANCE * localAngleToTurn.getCosine();
+
+        this->_pushLocalPosition(leadOutX,
+                                 distanceToDriveBeforeTurning + leadOutY);
     }
 
     Angle currentAngle = this->_motionTracker_P->getAngle();
@@ -77,22 +108,82 @@ void Navigator::moveToTarget() {
         return;
     }
 
+    // The time since the last move, used to ramp up the profiles.
+    uint32_t currentTime = millis();
+    this->_timeStep = (currentTime - this->_lastMoveTime) / 1000.0f;
+    this->_timeStep = min(this->_timeStep, PROFILE_MAX_TIME_STEP);
+    this->_lastMoveTime = currentTime;
+
     PathPoint currentTarget = this->_pathQueue.front();
 
     bool reachedDestination = false;
 
     if (currentTarget.usingPosition) {
+        // Runs of positions are followed as a single path, so that the robot
+        // doesn't stop at each one.
+        if (this->_followPositions()) {
+            return;
+        }
         reachedDestination = this->_goToPosition(currentTarget.position);
     } else {
-        reachedDestination = this->_goToAngle(currentTarget.angle);
+        reachedDestination = this->_goToAngle(currentTarget.angle,
+                                              this->_turnArrivalTolerance);
     }
 
     if (reachedDestination) {
         this->_drive_P->stop();
+        this->_resetProfile();
         this->_pathQueue.pop();
     }
 }
 
+// Follows the run of positions at the front of the queue with pure pursuit,
+// returns false if the positions should be driven to one by one instead.
+bool Navigator::_followPositions() {
+    if (!this->_purePursuit.hasPath()) {
+        Position currentPosition = this->_motionTracker_P->getPosition();
+        Angle currentAngle = this->_motionTracker_P->getAngle();
+
+        // Pure pursuit only drives forwards, so targets behind the robot, like
+        // backing off from a bumper hit, are driven to one by one.
+        Position firstTarget = this->_pathQueue.front().position;
+        Angle angleToTarget =
+            currentPosition.calculateAngleTo(firstTarget) - currentAngle;
+
+        if (abs(angleToTarget.getDegrees()) > 90) {
+            return false;
+        }
+
+        std::vector<Position> path;
+        path.push_back(currentPosition);
+
+        std::queue<PathPoint> tempQueue = this->_pathQueue;
+        while (!tempQueue.empty() && tempQueue.front().usingPosition) {
+            path.push_back(tempQueue.front().position);
+            tempQueue.pop();
+        }
+
+        this->_pursuitPointCount = path.size() - 1;
+        this->_purePursuit.setPath(path);
+    }
+
+    if (this->_purePursuit.follow()) {
+        for (size_t i = 0; i < this->_pursuitPointCount; i++) {
+            this->_pathQueue.pop();
+        }
+        this->_pursuitPointCount = 0;
+
+        // Only stop if there is nothing left to do, otherwise carry on
+        // straight into the next target.
+        if (this->hasNoPath()) {
+            this->_drive_P->stop();
+        }
+        this->_resetProfile();
+    }
+
+    return true;
+}
+
 void Navigator::hitBumper(byte bumperData) {
     bool frontPressed = (bumperData & 1);
     bool frontRightPressed = (bumperData & 2);
@@ -153,11 +244,34 @@ void Navigator::hitBumper(byte bumperData) {
 
 void Navigator::goDirection(Angle angleToDrive) {
     const int distanceToDrive = 100;
-    int localX = distanceToDrive * sin(angleToDrive.getRadians());
-    int localY = distanceToDrive * cos(angleToDrive.getRadians());
+    int localX = distanceToDrive * angleToDrive.getSine();
+    int localY = distanceToDrive * angleToDrive.getCosine();
     this->_pushOffsetPosition(localX, localY);
 }
 
+// Replaces the current path with a planned trajectory, a path starting at the
+// robot's position along with the speed to drive at each of its waypoints,
+// which is followed with pure pursuit.
+void Navigator::followTrajectory(std::vector<Position> path,
+                                 std::vector<float> speeds) {
+    this->_clearQueue();
+    this->_resetProfile();
+
+    if (path.size() < 2) {
+        return;
+    }
+
+    // The waypoints are still queued, so that the trajectory is cleared like
+    // any other path if the robot hits something.
+    for (size_t i = 1; i < path.size(); i++) {
+        this->_pushPosition(path[i]);
+    }
+
+    this->_purePursuit.setPath(path);
+    this->_purePursuit.setSpeedProfile(speeds);
+    this->_pursuitPointCount = path.size() - 1;
+}
+
 String Navigator::getPathAsString() {
     std::queue<PathPoint> tempQueue = this->_pathQueue;
 
@@ -176,20 +290,28 @@ String Navigator::getPathAsString() {
     return stringToReturn;
 }
 
-bool Navigator::_goToAngle(Angle angleToGoTo) {
+bool Navigator::_goToAngle(Angle angleToGoTo, int tolerance) {
     Angle currentAngle = this->_motionTracker_P->getAngle();
     Angle angleToTurn = angleToGoTo - currentAngle;
 
-    const int upperAngle = this->_angleTolerance;
-    const int lowerAngle = -(this->_angleTolerance);
+    float remainingAngle = abs(angleToTurn.getDegrees());
 
-    if (angleToTurn <= lowerAngle) {
-        this->_drive_P->turnRight();
-    } else if (angleToTurn >= upperAngle) {
-        this->_drive_P->turnLeft();
-    } else {
+    if (remainingAngle < tolerance) {
         return true;
     }
+
+    // While turning on the spot, the robot isn't driving forwards.
+    this->_linearProfileSpeed = 0;
+
+    this->_turnProfileSpeed = this->_profileSpeed(
+        remainingAngle, this->_turnProfileSpeed, this->_maxTurnSpeed,
+        PROFILE_TURN_ACCELERATION, PROFILE_MIN_TURN_SPEED);
+
+    if (angleToTurn.getDegrees() > 0) {
+        this->_drive_P->setSpeed(0, this->_turnProfileSpeed);
+    } else {
+        this->_drive_P->setSpeed(0, -this->_turnProfileSpeed);
+    }
     return false;
 }
 
@@ -219,24 +341,53 @@ bool Navigator::_goToPosition(Position positionToGoTo) {
         drivingForwards = false;
     }
 
-    bool pointingToTarget = this->_goToAngle(globalAngleToTarget);
+    bool pointingToTarget =
+        this->_goToAngle(globalAngleToTarget, this->_angleTolerance);
 
     if (pointingToTarget) {
         // If pointing towards target.
+        this->_turnProfileSpeed = 0;
 
         int angleAdjustment =
             constrain((int)angleToTurn, lowerAngle, upperAngle);
 
+        int rotationalSpeed = angleAdjustment * HEADING_CORRECTION_GAIN;
+
+        this->_linearProfileSpeed = this->_profileSpeed(
+            distanceToTarget, this->_linearProfileSpeed, this->_maxSpeed,
+            PROFILE_ACCELERATION, PROFILE_MIN_SPEED);
+
         if (drivingForwards) {
-            this->_drive_P->forwards(angleAdjustment);
+            this->_drive_P->setSpeed(this->_linearProfileSpeed,
+                                     rotationalSpeed);
         } else {
-            this->_drive_P->backwards(angleAdjustment);
+            this->_drive_P->setSpeed(-this->_linearProfileSpeed,
+                                     rotationalSpeed);
         }
     }
 
     return false;  // signifies destination has not been reached
 }
 
+// Calculates the speed to move at for a trapezoidal profile, ramping up from
+// the current speed, capped at the max speed, and slowing down so that the
+// robot can stop in the remaining distance, using v^2 = 2as.
+float Navigator::_profileSpeed(float remaining, float currentSpeed,
+                               float maxSpeed, float acceleration,
+                               float minSpeed) {
+    float rampedSpeed = currentSpeed + (acceleration * this->_timeStep);
+    float stoppingSpeed = sqrtf(2 * acceleration * remaining);
+
+    float speed = min(min(rampedSpeed, stoppingSpeed), maxSpeed);
+
+    return max(speed, minSpeed);
+}
+
+void Navigator::_resetProfile() {
+    this->_linearProfileSpeed = 0;
+    this->_turnProfileSpeed = 0;
+}
+
 void Navigator::_pushPosition(Position positionToPush) {
     PathPoint pointToPush;
 
@@ -250,8 +401,8 @@ void Navigator::_pushLocalPosition(float localX, float localY) {
 
     Angle rotationAngle = currentAngle - 90;
 
-    float sinAngle = sin(rotationAngle.getRadians());
-    float cosAngle = cos(rotationAngle.getRadians());
+    float sinAngle = rotationAngle.getSine();
+    float cosAngle = rotationAngle.getCosine();
 
     float rotatedLocalX = localX * cosAngle - localY * sinAngle;
     float rotatedLocalY = localY * cosAngle + localX * sinAngle;
@@ -285,6 +436,9 @@ void Navigator::_pushAngle(Angle angleToPush) {
 }
 
 void Navigator::_clearQueue() {
+    this->_purePursuit.clear();
+    this->_pursuitPointCount = 0;
+
     while (!this->_pathQueue.empty()) {
         this->_pathQueue.pop();
     }
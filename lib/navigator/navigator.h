@@ -4,6 +4,7 @@
 #include <queue>
 
 #include "angleAndPosition.h"
+#include "purePursuit.h"
 
 // Forward declaration of the MotionTracker and Drive class.
 class MotionTracker;
@@ -19,7 +20,8 @@ struct PathPoint {
 
 class Navigator {
    public:
-    Navigator(MotionTracker* motionTracker_P, Drive* drive_P);
+    Navigator(MotionTracker* motionTracker_P, Drive* drive_P, int maxSpeed,
+              int maxTurnSpeed);
 
     bool hasNoPath();
 
@@ -36,17 +38,38 @@ class Navigator {
 
     void goDirection(Angle angleToDrive);
 
+    void followTrajectory(std::vector<Position> path,
+                          std::vector<float> speeds);
+
    private:
     MotionTracker* _motionTracker_P;
     Drive* _drive_P;
 
-    int _inRangeTolerance = 30;
+    int _inRangeTolerance = 10;
     int _angleTolerance = 10;
+    int _turnArrivalTolerance = 2;
     bool _hasTarget = false;
 
-    bool _goToAngle(Angle angleToGoTo);
+    int _maxSpeed;
+    int _maxTurnSpeed;
+
+    float _linearProfileSpeed = 0;
+    float _turnProfileSpeed = 0;
+    float _timeStep = 0;
+    uint32_t _lastMoveTime = 0;
+
+    PurePursuit _purePursuit;
+    size_t _pursuitPointCount = 0;
+
+    bool _goToAngle(Angle angleToGoTo, int tolerance);
     bool _goToPosition(Position positionToGoTo);
 
+    float _profileSpeed(float remaining, float currentSpeed, float maxSpeed,
+                        float acceleration, float minSpeed);
+    void _resetProfile();
+
+    bool _followPositions();
+
     void _pushPosition(Position positionToPush);
     void _pushLocalPosition(float localX, float LocalY);
     void _pushOffsetPosition(float offsetX, float offsetY);
@@ -0,0 +1,75 @@
+/**
+ * @file nesController.cpp
+ * @brief Definitions of the NESController class, responsible for decoding the
+ * buttons of the NES controller from the shared shift register bus.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-04
+ * @copyright Copyright (c) 2024
+ */
+
+#include "nesController.h"
+
+#include "shiftRegisterBus.h"
+
+// The order that the NES controller sends its buttons, starting from the lsb.
+#define NES_BUTTON_A_BIT 0
+#define NES_BUTTON_B_BIT 1
+#define NES_BUTTON_SELECT_BIT 2
+#define NES_BUTTON_START_BIT 3
+#define NES_BUTTON_UP_BIT 4
+#define NES_BUTTON_DOWN_BIT 5
+#define NES_BUTTON_LEFT_BIT 6
+#define NES_BUTTON_RIGHT_BIT 7
+
+// If no controller is plugged in, the data line can be pulled low, which looks
+// like every button being pressed at once.
+#define NES_DISCONNECTED_DATA 0xFF
+
+/**
+ * @brief Checks if any of the buttons are pressed.
+ *
+ * @return (true) If at least one button is pressed.
+ * @return (false) If no buttons are pressed.
+ */
+bool NESInput::anyButtonPressed() {
+    return buttonA || buttonB || buttonSelect || buttonStart || buttonUp ||
+           buttonDown || buttonLeft || buttonRight;
+}
+
+/**
+ * @brief Construct a new NESController object.
+ *
+ * @param shiftRegisterBus_P Pointer to the bus that reads the NES
+ * controller's shift register.
+ */
+NESController::NESController(ShiftRegisterBus* shiftRegisterBus_P)
+    : _shiftRegisterBus_P(shiftRegisterBus_P) {}
+
+/**
+ * @brief Gets the state of the buttons from the most recent snapshot of the
+ * shift register bus.
+ *
+ * @return (NESInput) The state of each of the buttons.
+ */
+NESInput NESController::getNESInput() {
+    NESInput input;
+
+    uint8_t nesData = this->_shiftRegisterBus_P->getNESData();
+
+    // If the controller is unplugged, report no buttons as pressed.
+    if (nesData == NES_DISCONNECTED_DATA) {
+        return input;
+    }
+
+    input.buttonA = bitRead(nesData, NES_BUTTON_A_BIT);
+    input.buttonB = bitRead(nesData, NES_BUTTON_B_BIT);
+    input.buttonSelect = bitRead(nesData, NES_BUTTON_SELECT_BIT);
+    input.buttonStart = bitRead(nesData, NES_BUTTON_START_BIT);
+    input.buttonUp = bitRead(nesData, NES_BUTTON_UP_BIT);
+    input.buttonDown = bitRead(nesData, NES_BUTTON_DOWN_BIT);
+    input.buttonLeft = bitRead(nesData, NES_BUTTON_LEFT_BIT);
+    input.buttonRight = bitRead(nesData, NES_BUTTON_RIGHT_BIT);
+
+    return input;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file nesController.h
+ * @brief Declaration of the NESController class, responsible for decoding the
+ * buttons of the NES controller from the shared shift register bus.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-04
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef NES_CONTROLLER_H
+#define NES_CONTROLLER_H
+
+#include <Arduino.h>
+
+// Forward declaration of the ShiftRegisterBus class.
+class ShiftRegisterBus;
+
+/**
+ * @brief The state of each of the buttons on the NES controller, where true
+ * indicates that the button is pressed.
+ */
+struct NESInput {
+    bool buttonA = false;
+    bool buttonB = false;
+    bool buttonSelect = false;
+    bool buttonStart = false;
+    bool buttonUp = false;
+    bool buttonDown = false;
+    bool buttonLeft = false;
+    bool buttonRight = false;
+
+    /**
+     * @brief Checks if any of the buttons are pressed.
+     *
+     * @return (true) If at least one button is pressed.
+     * @return (false) If no buttons are pressed.
+     */
+    bool anyButtonPressed();
+};
+
+/**
+ * @brief The NESController class, responsible for decoding the buttons of the
+ * NES controller from the snapshot held by the shift register bus.
+ */
+class NESController {
+   public:
+    /**
+     * @brief Construct a new NESController object.
+     *
+     * @param shiftRegisterBus_P Pointer to the bus that reads the NES
+     * controller's shift register.
+     */
+    NESController(ShiftRegisterBus* shiftRegisterBus_P);
+
+    /**
+     * @brief Gets the state of the buttons from the most recent snapshot of
+     * the shift register bus.
+     *
+     * @return (NESInput) The state of each of the buttons.
+     */
+    NESInput getNESInput();
+
+   private:
+    /**
+     * @brief Pointer to the bus that reads the NES controller's shift
+     * register.
+     */
+    ShiftRegisterBus* _shiftRegisterBus_P;
+};
+
+#endif  // NES_CONTROLLER_H
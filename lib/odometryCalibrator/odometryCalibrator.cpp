@@ -0,0 +1,414 @@
+/**
+ * @file odometryCalibrator.cpp
+ * @brief Definition of the OdometryCalibrator class, responsible for
+ * measuring the size of each wheel and the distance between them, by driving
+ * to and from a wall and spinning on the spot in front of it.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-15
+ * @copyright Copyright (c) 2024
+ */
+#include "odometryCalibrator.h"
+
+#include "angleAndPosition.h"
+#include "drive.h"
+#include "frontRange.h"
+#include "motionTracker.h"
+#include "motor.h"
+#include "schedule.h"
+
+// The number of times to drive away from the wall and back again.
+#define CALIBRATION_RUNS 3
+
+// The distance in millimeters to drive away from the wall on each run.
+#define CALIBRATION_DISTANCE 300
+
+// The speed in millimeters per second to drive at, slow so that the wheels
+// don't slip.
+#define CALIBRATION_DRIVE_SPEED 100
+
+// The number of full rotations to spin in each direction.
+#define CALIBRATION_TURNS 2
+
+// The speed in degrees per second to spin at.
+#define CALIBRATION_TURN_SPEED 90
+
+// The time in milliseconds to wait after stopping before measuring the wall,
+// so that the robot has stopped rocking and the sensors have new readings.
+#define CALIBRATION_SETTLE_TIME 500
+
+// The time in milliseconds to average the wall measurements over.
+#define CALIBRATION_SAMPLE_TIME 500
+
+// The period in milliseconds between wall samples.
+#define CALIBRATION_SAMPLE_PERIOD 10
+
+// The fraction of the samples that need to see the wall for the measurement
+// to be used.
+#define CALIBRATION_MIN_VALID_FRACTION 0.8f
+
+// How long in milliseconds a single move can take before the robot is assumed
+// to be stuck.
+#define CALIBRATION_MOVE_TIMEOUT 15000
+
+/**
+ * @brief Construct a new OdometryCalibrator object.
+ *
+ * @param leftMotor_P Pointer to the left motor.
+ * @param rightMotor_P Pointer to the right motor.
+ * @param drive_P Pointer to the drive, used to move the robot.
+ * @param motionTracker_P Pointer to the motion tracker, used to get the
+ * current distance between the wheels.
+ * @param frontRange_P Pointer to the front range, used to measure the distance
+ * and angle of the wall.
+ */
+OdometryCalibrator::OdometryCalibrator(Motor* leftMotor_P, Motor* rightMotor_P,
+                                       Drive* drive_P,
+                                       MotionTracker* motionTracker_P,
+                                       FrontRange* frontRange_P)
+    : _leftMotor_P(leftMotor_P),
+      _rightMotor_P(rightMotor_P),
+      _drive_P(drive_P),
+      _motionTracker_P(motionTracker_P),
+      _frontRange_P(frontRange_P),
+      _leftStepsPerMillimeter(STEPS_PER_MILLIMETER),
+      _rightStepsPerMillimeter(STEPS_PER_MILLIMETER),
+      _wheelDifferencePerRotation(WHEEL_DIFFERENCE_PER_ROTATION) {}
+
+/**
+ * @brief Runs the calibration, blocking until it has finished.
+ *
+ * @param polls_P A pointer to a function that polls the sensors and the drive,
+ * called continuously while the calibration runs.
+ * @return (true) If the calibration finished, and the results are ready.
+ * @return (false) If the wall could not be measured, or the robot didn't move,
+ * in which case the results are left at their previous values.
+ */
+bool OdometryCalibrator::run(voidFuncPtr polls_P) {
+    this->_polls_P = polls_P;
+
+    // Each run drives away from the wall and back again, so that any
+    // difference between driving forwards and backwards averages out.
+    float stepsPerMillimeterSum = 0;
+    float wheelSizeRatioSum = 0;
+    int straightCount = 0;
+
+    for (int run = 0; run < CALIBRATION_RUNS; run++) {
+        for (int direction = -1; direction <= 1; direction += 2) {
+            float stepsPerMillimeter;
+            float wheelSizeRatio;
+
+            if (!this->_driveStraight(direction * CALIBRATION_DISTANCE,
+                                      &stepsPerMillimeter, &wheelSizeRatio)) {
+                return false;
+            }
+
+            stepsPerMillimeterSum += stepsPerMillimeter;
+            wheelSizeRatioSum += wheelSizeRatio;
+            straightCount++;
+        }
+    }
+
+    float stepsPerMillimeter = stepsPerMillimeterSum / straightCount;
+    float wheelSizeRatio = wheelSizeRatioSum / straightCount;
+
+    // The spins are measured with the new wheel sizes, so the results are
+    // stored before spinning, but only kept if the spins succeed.
+    float oldLeftStepsPerMillimeter = this->_leftStepsPerMillimeter;
+    float oldRightStepsPerMillimeter = this->_rightStepsPerMillimeter;
+
+    this->_leftStepsPerMillimeter = stepsPerMillimeter * (1 + wheelSizeRatio);
+    this->_rightStepsPerMillimeter = stepsPerMillimeter * (1 - wheelSizeRatio);
+
+    // Spinning both ways cancels out any difference between the directions,
+    // like the clockwise and counter-clockwise squares of the UMBmark test.
+    float leftSpinDifference;
+    float rightSpinDifference;
+
+    if (!this->_spin(true, &leftSpinDifference) ||
+        !this->_spin(false, &rightSpinDifference)) {
+        this->_leftStepsPerMillimeter = oldLeftStepsPerMillimeter;
+        this->_rightStepsPerMillimeter = oldRightStepsPerMillimeter;
+        return false;
+    }
+
+    this->_wheelDifferencePerRotation =
+        (leftSpinDifference + rightSpinDifference) / 2;
+
+    return true;
+}
+
+/**
+ * @brief Gets the number of encoder steps per millimeter traveled by the left
+ * wheel.
+ *
+ * @return (float) The number of steps per millimeter.
+ */
+float OdometryCalibrator::getLeftStepsPerMillimeter() {
+    return this->_leftStepsPerMillimeter;
+}
+
+/**
+ * @brief Gets the number of encoder steps per millimeter traveled by the right
+ * wheel.
+ *
+ * @return (float) The number of steps per millimeter.
+ */
+float OdometryCalibrator::getRightStepsPerMillimeter() {
+    return this->_rightStepsPerMillimeter;
+}
+
+/**
+ * @brief Gets the difference in millimeters traveled by the two wheels for the
+ * robot to turn a full rotation.
+ *
+ * @return (float) The difference in millimeters.
+ */
+float OdometryCalibrator::getWheelDifferencePerRotation() {
+    return this->_wheelDifferencePerRotation;
+}
+
+/**
+ * @brief Drives straight for a given distance, measuring the wall before and
+ * after.
+ *
+ * @param distance The distance to drive by the odometry, in millimeters,
+ * negative to drive backwards.
+ * @param stepsPerMillimeter_P The pointer used to return the average number of
+ * steps per millimeter of the two wheels.
+ * @param wheelSizeRatio_P The pointer used to return the fractional difference
+ * in the number of steps per millimeter, where the left wheel has (1 + ratio)
+ * times the average, and the right wheel (1 - ratio).
+ * @return (true) If the run was measured.
+ * @return (false) If the run could not be measured.
+ */
+bool OdometryCalibrator::_driveStraight(float distance,
+                                        float* stepsPerMillimeter_P,
+                                        float* wheelSizeRatio_P) {
+    float startDistance;
+    float startWallAngle;
+
+    if (!this->_measureWall(&startDistance, &startWallAngle)) {
+        return false;
+    }
+
+    int32_t leftStartSteps = this->_leftMotor_P->getSteps();
+    int32_t rightStartSteps = this->_rightMotor_P->getSteps();
+
+    // The distance is judged with the calibration the motors already have,
+    // it only needs to be roughly right.
+    float currentStepsPerMillimeter =
+        (this->_leftMotor_P->getStepsPerMillimeter() +
+         this->_rightMotor_P->getStepsPerMillimeter()) /
+        2;
+    float stepsToDrive = abs(distance) * currentStepsPerMillimeter;
+
+    int direction = (distance < 0) ? -1 : 1;
+    uint32_t startTime = millis();
+
+    this->_drive_P->setSpeed(direction * CALIBRATION_DRIVE_SPEED);
+
+    while (true) {
+        this->_polls_P();
+
+        int32_t leftSteps = this->_leftMotor_P->getSteps() - leftStartSteps;
+        int32_t rightSteps = this->_rightMotor_P->getSteps() - rightStartSteps;
+
+        if (abs(leftSteps + rightSteps) / 2.0f >= stepsToDrive) {
+            break;
+        }
+
+        if ((millis() - startTime) > CALIBRATION_MOVE_TIMEOUT) {
+            this->_drive_P->stop();
+            return false;
+        }
+    }
+
+    this->_drive_P->stop();
+
+    float endDistance;
+    float endWallAngle;
+
+    if (!this->_measureWall(&endDistance, &endWallAngle)) {
+        return false;
+    }
+
+    // The steps are counted after the robot has settled, to include any
+    // coasting after it was stopped.
+    float leftSteps = this->_leftMotor_P->getSteps() - leftStartSteps;
+    float rightSteps = this->_rightMotor_P->getSteps() - rightStartSteps;
+
+    // Driving away from the wall, the distance to it grows.
+    float distanceTraveled = startDistance - endDistance;
+
+    if ((distanceTraveled * direction) <= 0) {
+        return false;
+    }
+
+    float stepsPerMillimeter =
+        (leftSteps + rightSteps) / (2 * distanceTraveled);
+
+    // The wall angle is how far the robot would have to turn to face the
+    // wall, so turning counter-clockwise makes it go down.
+    float headingChange = startWallAngle - endWallAngle;
+
+    // For small differences in the sizes of the wheels, with the left wheel
+    // at (1 + k) times the average steps per millimeter and the right at
+    // (1 - k), the difference in the distances traveled by the wheels is
+    //   (rightSteps - leftSteps + k * (leftSteps + rightSteps)) / average,
+    // which is solved for k from the measured change in heading.
+    float wheelDifferencePerRotation =
+        this->_motionTracker_P->getWheelDifferencePerRotation();
+    float travelDifference =
+        headingChange * wheelDifferencePerRotation / DEGREES_PER_ROTATION;
+
+    float wheelSizeRatio =
+        (travelDifference * stepsPerMillimeter - (rightSteps - leftSteps)) /
+        (leftSteps + rightSteps);
+
+    *stepsPerMillimeter_P = stepsPerMillimeter;
+    *wheelSizeRatio_P = wheelSizeRatio;
+    return true;
+}
+
+/**
+ * @brief Spins on the spot for CALIBRATION_TURNS rotations, measuring the wall
+ * before and after.
+ *
+ * @param turnLeft Whether to spin counter-clockwise.
+ * @param wheelDifferencePerRotation_P The pointer used to return the
+ * difference in millimeters traveled by the two wheels for a full rotation.
+ * @return (true) If the spin was measured.
+ * @return (false) If the spin could not be measured.
+ */
+bool OdometryCalibrator::_spin(bool turnLeft,
+                               float* wheelDifferencePerRotation_P) {
+    float distance;
+    float startWallAngle;
+
+    if (!this->_measureWall(&distance, &startWallAngle)) {
+        return false;
+    }
+
+    int32_t leftStartSteps = this->_leftMotor_P->getSteps();
+    int32_t rightStartSteps = this->_rightMotor_P->getSteps();
+
+    float currentWheelDifference =
+        this->_motionTracker_P->getWheelDifferencePerRotation();
+    float travelDifferenceToSpin = CALIBRATION_TURNS * currentWheelDifference;
+
+    int direction = turnLeft ? 1 : -1;
+    uint32_t startTime = millis();
+
+    this->_drive_P->setSpeed(0, direction * CALIBRATION_TURN_SPEED);
+
+    while (true) {
+        this->_polls_P();
+
+        float leftTravel = (this->_leftMotor_P->getSteps() - leftStartSteps) /
+                           this->_leftStepsPerMillimeter;
+        float rightTravel =
+            (this->_rightMotor_P->getSteps() - rightStartSteps) /
+            this->_rightStepsPerMillimeter;
+
+        if (abs(rightTravel - leftTravel) >= travelDifferenceToSpin) {
+            break;
+        }
+
+        if ((millis() - startTime) > CALIBRATION_MOVE_TIMEOUT) {
+            this->_drive_P->stop();
+            return false;
+        }
+    }
+
+    this->_drive_P->stop();
+
+    float endWallAngle;
+
+    if (!this->_measureWall(&distance, &endWallAngle)) {
+        return false;
+    }
+
+    float leftTravel = (this->_leftMotor_P->getSteps() - leftStartSteps) /
+                       this->_leftStepsPerMillimeter;
+    float rightTravel = (this->_rightMotor_P->getSteps() - rightStartSteps) /
+                        this->_rightStepsPerMillimeter;
+
+    // The robot is assumed to have turned the whole number of rotations, plus
+    // however far the wall has moved, as the odometry is never far enough out
+    // to be off by half a rotation.
+    float rotation = direction * CALIBRATION_TURNS * DEGREES_PER_ROTATION +
+                     (startWallAngle - endWallAngle);
+
+    *wheelDifferencePerRotation_P =
+        (rightTravel - leftTravel) * DEGREES_PER_ROTATION / rotation;
+    return true;
+}
+
+/**
+ * @brief Waits for the robot to settle, then averages the distance and angle
+ * of the wall in front of it.
+ *
+ * @param distance_P The pointer used to return the distance to the wall in
+ * millimeters.
+ * @param wallAngle_P The pointer used to return the angle the robot would need
+ * to turn counter-clockwise to face the wall squarely, in degrees.
+ * @return (true) If the wall was seen for enough of the samples.
+ * @return (false) If the wall could not be measured.
+ */
+bool OdometryCalibrator::_measureWall(float* distance_P, float* wallAngle_P) {
+    this->_wait(CALIBRATION_SETTLE_TIME);
+
+    PassiveSchedule sampleSchedule(CALIBRATION_SAMPLE_PERIOD);
+
+    float distanceSum = 0;
+    float wallAngleSum = 0;
+    int sampleCount = 0;
+    int validCount = 0;
+
+    uint32_t startTime = millis();
+
+    while ((millis() - startTime) < CALIBRATION_SAMPLE_TIME) {
+        this->_polls_P();
+
+        if (!sampleSchedule.isReadyToRun()) {
+            continue;
+        }
+
+        sampleCount++;
+
+        int distance = this->_frontRange_P->read();
+        float wallAngle;
+
+        if ((distance == -1) ||
+            !this->_frontRange_P->readWallAngle(&wallAngle)) {
+            continue;
+        }
+
+        distanceSum += distance;
+        wallAngleSum += wallAngle;
+        validCount++;
+    }
+
+    if ((validCount == 0) ||
+        (validCount < CALIBRATION_MIN_VALID_FRACTION * sampleCount)) {
+        return false;
+    }
+
+    *distance_P = distanceSum / validCount;
+    *wallAngle_P = wallAngleSum / validCount;
+    return true;
+}
+
+/**
+ * @brief Keeps polling for a given amount of time.
+ *
+ * @param duration The time to wait in milliseconds.
+ */
+void OdometryCalibrator::_wait(uint32_t duration) {
+    uint32_t startTime = millis();
+
+    while ((millis() - startTime) < duration) {
+        this->_polls_P();
+    }
+}
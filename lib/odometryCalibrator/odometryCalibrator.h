@@ -0,0 +1,160 @@
+/**
+ * @file odometryCalibrator.h
+ * @brief Declaration of the OdometryCalibrator class, responsible for
+ * measuring the size of each wheel and the distance between them, by driving
+ * to and from a wall and spinning on the spot in front of it.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-15
+ * @copyright Copyright (c) 2024
+ */
+#ifndef ODOMETRY_CALIBRATOR_H
+#define ODOMETRY_CALIBRATOR_H
+
+#include <Arduino.h>
+
+// Forward declaration of the Motor, Drive, MotionTracker and FrontRange
+// classes.
+class Motor;
+class Drive;
+class MotionTracker;
+class FrontRange;
+
+/**
+ * @brief OdometryCalibrator class, fits the odometry constants to measurements
+ * of a wall in front of the robot, in the same way as the UMBmark test.
+ *
+ * - Driving straight away from the wall and back again, the change in the
+ * distance to the wall gives the number of steps per millimeter, and the
+ * change in the angle of the wall gives how much the robot curved, from which
+ * the difference in size between the two wheels is found.
+ * - Spinning on the spot a whole number of times in each direction, the angle
+ * of the wall before and after gives how far the robot really turned, which
+ * gives the difference the wheels travel for a full rotation.
+ *
+ * The robot must start square on to a wall about 150mm in front of it, with at
+ * least 400mm of space behind it and room to spin.
+ */
+class OdometryCalibrator {
+   public:
+    /**
+     * @brief Construct a new OdometryCalibrator object.
+     *
+     * @param leftMotor_P Pointer to the left motor.
+     * @param rightMotor_P Pointer to the right motor.
+     * @param drive_P Pointer to the drive, used to move the robot.
+     * @param motionTracker_P Pointer to the motion tracker, used to get the
+     * current distance between the wheels.
+     * @param frontRange_P Pointer to the front range, used to measure the
+     * distance and angle of the wall.
+     */
+    OdometryCalibrator(Motor* leftMotor_P, Motor* rightMotor_P, Drive* drive_P,
+                       MotionTracker* motionTracker_P,
+                       FrontRange* frontRange_P);
+
+    /**
+     * @brief Runs the calibration, blocking until it has finished.
+     *
+     * @param polls_P A pointer to a function that polls the sensors and the
+     * drive, called continuously while the calibration runs.
+     * @return (true) If the calibration finished, and the results are ready.
+     * @return (false) If the wall could not be measured, or the robot didn't
+     * move, in which case the results are left at their previous values.
+     */
+    bool run(voidFuncPtr polls_P);
+
+    /**
+     * @brief Gets the number of encoder steps per millimeter traveled by the
+     * left wheel.
+     *
+     * @return (float) The number of steps per millimeter.
+     */
+    float getLeftStepsPerMillimeter();
+
+    /**
+     * @brief Gets the number of encoder steps per millimeter traveled by the
+     * right wheel.
+     *
+     * @return (float) The number of steps per millimeter.
+     */
+    float getRightStepsPerMillimeter();
+
+    /**
+     * @brief Gets the difference in millimeters traveled by the two wheels for
+     * the robot to turn a full rotation.
+     *
+     * @return (float) The difference in millimeters.
+     */
+    float getWheelDifferencePerRotation();
+
+   private:
+    /**
+     * @brief Drives straight for a given distance, measuring the wall before
+     * and after.
+     *
+     * @param distance The distance to drive by the odometry, in millimeters,
+     * negative to drive backwards.
+     * @param stepsPerMillimeter_P The pointer used to return the average
+     * number of steps per millimeter of the two wheels.
+     * @param wheelSizeRatio_P The pointer used to return the fractional
+     * difference in the number of steps per millimeter, where the left wheel
+     * has (1 + ratio) times the average, and the right wheel (1 - ratio).
+     * @return (true) If the run was measured.
+     * @return (false) If the run could not be measured.
+     */
+    bool _driveStraight(float distance, float* stepsPerMillimeter_P,
+                        float* wheelSizeRatio_P);
+
+    /**
+     * @brief Spins on the spot for CALIBRATION_TURNS rotations, measuring the
+     * wall before and after.
+     *
+     * @param turnLeft Whether to spin counter-clockwise.
+     * @param wheelDifferencePerRotation_P The pointer used to return the
+     * difference in millimeters traveled by the two wheels for a full
+     * rotation.
+     * @return (true) If the spin was measured.
+     * @return (false) If the spin could not be measured.
+     */
+    bool _spin(bool turnLeft, float* wheelDifferencePerRotation_P);
+
+    /**
+     * @brief Waits for the robot to settle, then averages the distance and
+     * angle of the wall in front of it.
+     *
+     * @param distance_P The pointer used to return the distance to the wall
+     * in millimeters.
+     * @param wallAngle_P The pointer used to return the angle the robot would
+     * need to turn counter-clockwise to face the wall squarely, in degrees.
+     * @return (true) If the wall was seen for enough of the samples.
+     * @return (false) If the wall could not be measured.
+     */
+    bool _measureWall(float* distance_P, float* wallAngle_P);
+
+    /**
+     * @brief Keeps polling for a given amount of time.
+     *
+     * @param duration The time to wait in milliseconds.
+     */
+    void _wait(uint32_t duration);
+
+    Motor* _leftMotor_P;
+    Motor* _rightMotor_P;
+    Drive* _drive_P;
+    MotionTracker* _motionTracker_P;
+    FrontRange* _frontRange_P;
+
+    /**
+     * @brief The function called to poll the sensors and the drive.
+     */
+    voidFuncPtr _polls_P = nullptr;
+
+    /**
+     * @brief The results of the calibration.
+     */
+    float _leftStepsPerMillimeter;
+    float _rightStepsPerMillimeter;
+    float _wheelDifferencePerRotation;
+};
+
+#endif  // ODOMETRY_CALIBRATOR_H
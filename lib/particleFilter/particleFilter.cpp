@@ -0,0 +1,326 @@
+/**
+ * @file particleFilter.cpp
+ * @brief Definition of the ParticleFilter class, a Monte Carlo localiser that
+ * finds the pose of the robot by comparing the range sensors with the
+ * BrickList.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-12
+ * @copyright Copyright (c) 2024
+ */
+#include "particleFilter.h"
+
+#include "brick.h"
+
+// The noise added to each particle as it moves. These are larger than the
+// real error in the odometry, so that the cloud stays wide enough to cover the
+// true pose between readings.
+// The variance added to the distance driven, in millimeters squared per
+// millimeter driven.
+#define PARTICLE_DISTANCE_VARIANCE 2.0f
+// The variance added to the angle when turning, in degrees squared per degree
+// turned.
+#define PARTICLE_TURN_VARIANCE 0.2f
+// The variance added to the angle when driving, in degrees squared per
+// millimeter driven.
+#define PARTICLE_DRIFT_VARIANCE 0.005f
+
+// The likelihood given to every reading on top of the normal distribution, so
+// that a single bad reading, or a Brick missing from the BrickList, doesn't
+// wipe out the particles near the true pose.
+#define LIKELIHOOD_FLOOR 0.05f
+
+// The particles are resampled when the effective number of particles drops
+// below this fraction of the total.
+#define RESAMPLE_THRESHOLD 0.5f
+
+// The furthest the particles can be spread, in millimeters, for their
+// estimate to be used to correct the odometry.
+#define MAX_CORRECTION_DEVIATION 30
+
+/**
+ * @brief Construct a new ParticleFilter object.
+ *
+ * @param brickList_P Pointer to the BrickList, used to predict what the range
+ * sensors should read from each particle.
+ */
+ParticleFilter::ParticleFilter(BrickList* brickList_P)
+    : _brickList_P(brickList_P) {}
+
+/**
+ * @brief Spreads the particles around a pose.
+ *
+ * @param pose The pose to spread the particles around, this should be the
+ * current pose from the odometry.
+ * @param positionDeviation The standard deviation of the spread of the
+ * position, in millimeters.
+ * @param angleDeviation The standard deviation of the spread of the angle, in
+ * degrees.
+ */
+void ParticleFilter::reset(Pose pose, float positionDeviation,
+                           float angleDeviation) {
+    for (Particle& particle : this->_particles) {
+        particle.position.x =
+            pose.position.x + this->_randomNormal(positionDeviation);
+        particle.position.y =
+            pose.position.y + this->_randomNormal(positionDeviation);
+        particle.angle =
+            pose.angle + Angle::fromDegrees(this->_randomNormal(angleDeviation));
+        particle.weight = 1.0f / PARTICLE_COUNT;
+    }
+
+    this->_lastPose = pose;
+}
+
+/**
+ * @brief Moves every particle by the movement of the odometry since the last
+ * prediction, with some noise added to each.
+ *
+ * @param odometryPose The current pose from the odometry.
+ */
+void ParticleFilter::predict(Pose odometryPose) {
+    float changeInX = odometryPose.position.x - this->_lastPose.position.x;
+    float changeInY = odometryPose.position.y - this->_lastPose.position.y;
+
+    Angle changeInAngle = odometryPose.angle - this->_lastPose.angle;
+
+    this->_lastPose = odometryPose;
+
+    if ((changeInX == 0) && (changeInY == 0) &&
+        (changeInAngle.getBinary() == 0)) {
+        return;
+    }
+
+    // The movement relative to the robot, which is the same for every
+    // particle whatever its angle.
+    Angle midpointAngle = odometryPose.angle -
+                          Angle::fromBinary(changeInAngle.getBinary() / 2);
+
+    float distance = (changeInX * midpointAngle.getCosine()) +
+                     (changeInY * midpointAngle.getSine());
+    float turn = changeInAngle.getDegrees();
+
+    float distanceDeviation = sqrtf(PARTICLE_DISTANCE_VARIANCE * abs(distance));
+    float turnDeviation = sqrtf((PARTICLE_TURN_VARIANCE * abs(turn)) +
+                                (PARTICLE_DRIFT_VARIANCE * abs(distance)));
+
+    for (Particle& particle : this->_particles) {
+        float particleTurn = turn + this->_randomNormal(turnDeviation);
+        float particleDistance =
+            distance + this->_randomNormal(distanceDeviation);
+
+        Angle particleMidpoint =
+            particle.angle + Angle::fromDegrees(particleTurn / 2);
+
+        particle.position.x += particleDistance * particleMidpoint.getCosine();
+        particle.position.y += particleDistance * particleMidpoint.getSine();
+        particle.angle += Angle::fromDegrees(particleTurn);
+    }
+}
+
+/**
+ * @brief Weights every particle by how likely a range reading would be, if
+ * the robot were at that particle.
+ *
+ * @param sensorOffset The point the reading is measured from, relative to the
+ * centre of the robot, with x to the right and y forwards. As the reading is
+ * offset back to the centre of the robot, this is the sensor's sideways offset
+ * from the beam through the centre.
+ * @param sensorAngle The direction the sensor points relative to the front of
+ * the robot, counter-clockwise positive.
+ * @param measuredDistance The distance read by the sensor, as given by
+ * readFromRobotCenter(), measured along the beam from sensorOffset rather
+ * than from the sensor itself.
+ * @param deviation The standard deviation of the reading, in millimeters.
+ */
+void ParticleFilter::weigh(Position sensorOffset, Angle sensorAngle,
+                           int measuredDistance, float deviation) {
+    if (measuredDistance < 0) {
+        return;
+    }
+
+    float inverseVariance = 1 / (deviation * deviation);
+
+    for (Particle& particle : this->_particles) {
+        float cosine = particle.angle.getCosine();
+        float sine = particle.angle.getSine();
+
+        // The sensor's position in the maze, where the robot's right is
+        // (sin, -cos) and its front is (cos, sin).
+        Position sensorPosition;
+        sensorPosition.x = particle.position.x + (sensorOffset.x * sine) +
+                           (sensorOffset.y * cosine);
+        sensorPosition.y = particle.position.y - (sensorOffset.x * cosine) +
+                           (sensorOffset.y * sine);
+
+        float expectedDistance = this->_brickList_P->rayCast(
+            sensorPosition, particle.angle + sensorAngle);
+
+        float likelihood = LIKELIHOOD_FLOOR;
+
+        // A particle that can't see anything is outside of the maze, so only
+        // gets the floor.
+        if (expectedDistance >= 0) {
+            float error = measuredDistance - expectedDistance;
+            likelihood += expf(-0.5f * error * error * inverseVariance);
+        }
+
+        particle.weight *= likelihood;
+    }
+}
+
+/**
+ * @brief Normalises the weights, and resamples the particles if the effective
+ * number of particles has dropped too low.
+ *
+ * @return (true) If the particles were resampled.
+ * @return (false) If the particles were kept.
+ */
+bool ParticleFilter::resampleIfNeeded() {
+    float weightSum = 0;
+    for (Particle& particle : this->_particles) {
+        weightSum += particle.weight;
+    }
+
+    // If every particle has been ruled out, start again with equal weights.
+    if (weightSum <= 0) {
+        for (Particle& particle : this->_particles) {
+            particle.weight = 1.0f / PARTICLE_COUNT;
+        }
+        return false;
+    }
+
+    float squaredWeightSum = 0;
+    for (Particle& particle : this->_particles) {
+        particle.weight /= weightSum;
+        squaredWeightSum += particle.weight * particle.weight;
+    }
+
+    // The effective number of particles is how many equally weighted
+    // particles would give the same spread of weights.
+    float effectiveCount = 1 / squaredWeightSum;
+
+    if (effectiveCount >= (PARTICLE_COUNT * RESAMPLE_THRESHOLD)) {
+        return false;
+    }
+
+    // Low variance resampling, the particles are drawn at evenly spaced
+    // points along the cumulative weight from a single random start, so each
+    // particle is copied in proportion to its weight.
+    float step = 1.0f / PARTICLE_COUNT;
+    float target = (random(0x10000) / 65536.0f) * step;
+    float cumulativeWeight = this->_particles[0].weight;
+    int source = 0;
+
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        while ((target > cumulativeWeight) && (source < PARTICLE_COUNT - 1)) {
+            source++;
+            cumulativeWeight += this->_particles[source].weight;
+        }
+
+        this->_resampledParticles[i] = this->_particles[source];
+        this->_resampledParticles[i].weight = step;
+
+        target += step;
+    }
+
+    memcpy(this->_particles, this->_resampledParticles,
+           sizeof(this->_particles));
+
+    return true;
+}
+
+/**
+ * @brief Gets the weighted mean pose of the particles.
+ *
+ * @param positionDeviation_P The pointer used to return the standard deviation
+ * of the particles' positions, in millimeters.
+ * @return (Pose) The weighted mean pose.
+ */
+Pose ParticleFilter::getEstimate(float* positionDeviation_P) {
+    float weightSum = 0;
+    float xSum = 0;
+    float ySum = 0;
+    float cosineSum = 0;
+    float sineSum = 0;
+
+    for (Particle& particle : this->_particles) {
+        weightSum += particle.weight;
+        xSum += particle.weight * particle.position.x;
+        ySum += particle.weight * particle.position.y;
+        // The angles are averaged as vectors, so that they average correctly
+        // across the wrap at 180°.
+        cosineSum += particle.weight * particle.angle.getCosine();
+        sineSum += particle.weight * particle.angle.getSine();
+    }
+
+    Pose estimate;
+
+    if (weightSum <= 0) {
+        return this->_lastPose;
+    }
+
+    estimate.position.x = xSum / weightSum;
+    estimate.position.y = ySum / weightSum;
+    estimate.angle =
+        Angle::fromDegrees(atan2f(sineSum, cosineSum) * DEGREES_PER_RADIAN);
+
+    if (positionDeviation_P != nullptr) {
+        float varianceSum = 0;
+        for (Particle& particle : this->_particles) {
+            float dx = particle.position.x - estimate.position.x;
+            float dy = particle.position.y - estimate.position.y;
+            varianceSum += particle.weight * ((dx * dx) + (dy * dy));
+        }
+        *positionDeviation_P = sqrtf(varianceSum / weightSum);
+    }
+
+    return estimate;
+}
+
+/**
+ * @brief Gets the correction that moves the odometry onto the estimate, if the
+ * particles agree closely enough on the pose.
+ *
+ * Once the correction has been applied to the odometry, the jump doesn't
+ * count as movement on the next prediction.
+ *
+ * @param odometryPose The current pose from the odometry.
+ * @param correction_P The pointer used to return the correction.
+ * @return (true) If the particles agree, and a correction was returned.
+ * @return (false) If the particles are too spread out to be trusted.
+ */
+bool ParticleFilter::getCorrection(Pose odometryPose, Pose* correction_P) {
+    float positionDeviation;
+    Pose estimate = this->getEstimate(&positionDeviation);
+
+    if (positionDeviation > MAX_CORRECTION_DEVIATION) {
+        return false;
+    }
+
+    correction_P->position.x = estimate.position.x - odometryPose.position.x;
+    correction_P->position.y = estimate.position.y - odometryPose.position.y;
+    correction_P->angle = estimate.angle - odometryPose.angle;
+
+    this->_lastPose = estimate;
+
+    return true;
+}
+
+/**
+ * @brief Draws a random number from an approximate normal distribution.
+ *
+ * @param deviation The standard deviation of the distribution.
+ * @return (float) The random number.
+ */
+float ParticleFilter::_randomNormal(float deviation) {
+    // The sum of three uniform numbers between 0 and 1 is close enough to a
+    // normal distribution, with a mean of 1.5 and a variance of 0.25, and is
+    // much cheaper than the Box-Muller transform.
+    float sum = 0;
+    for (int i = 0; i < 3; i++) {
+        sum += random(0x10000) / 65536.0f;
+    }
+
+    return (sum - 1.5f) * 2 * deviation;
+}
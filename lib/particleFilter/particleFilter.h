@@ -0,0 +1,167 @@
+/**
+ * @file particleFilter.h
+ * @brief Declaration of the ParticleFilter class, a Monte Carlo localiser
+ * that finds the pose of the robot by comparing the range sensors with the
+ * BrickList.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-12
+ * @copyright Copyright (c) 2024
+ */
+#ifndef PARTICLE_FILTER_H
+#define PARTICLE_FILTER_H
+
+#include <Arduino.h>
+
+#include "angleAndPosition.h"
+
+// Forward declaration of the BrickList class.
+class BrickList;
+
+// The number of particles, each one is a guess at the pose of the robot.
+#define PARTICLE_COUNT 200
+
+/**
+ * @brief A single guess at the pose of the robot, and how likely it is.
+ */
+struct Particle {
+    /**
+     * @brief The position of the guess, in millimeters.
+     */
+    Position position;
+
+    /**
+     * @brief The angle of the guess.
+     */
+    Angle angle = 0;
+
+    /**
+     * @brief The likelihood of the guess, the weights of all the particles
+     * sum to 1.
+     */
+    float weight = 0;
+};
+
+/**
+ * @brief ParticleFilter class, moves a cloud of guesses at the robot's pose
+ * along with the odometry, and weights each guess by how well the range
+ * readings it would expect match the real ones.
+ *
+ * The particles are held in fixed arrays, and only resampled when too few of
+ * them carry most of the weight, so that the cloud doesn't collapse while the
+ * robot is seeing nothing new.
+ *
+ * This class doesn't touch any hardware, so can be tested on its own.
+ */
+class ParticleFilter {
+   public:
+    /**
+     * @brief Construct a new ParticleFilter object.
+     *
+     * @param brickList_P Pointer to the BrickList, used to predict what the
+     * range sensors should read from each particle.
+     */
+    ParticleFilter(BrickList* brickList_P);
+
+    /**
+     * @brief Spreads the particles around a pose.
+     *
+     * @param pose The pose to spread the particles around, this should be the
+     * current pose from the odometry.
+     * @param positionDeviation The standard deviation of the spread of the
+     * position, in millimeters.
+     * @param angleDeviation The standard deviation of the spread of the angle,
+     * in degrees.
+     */
+    void reset(Pose pose, float positionDeviation, float angleDeviation);
+
+    /**
+     * @brief Moves every particle by the movement of the odometry since the
+     * last prediction, with some noise added to each.
+     *
+     * @param odometryPose The current pose from the odometry.
+     */
+    void predict(Pose odometryPose);
+
+    /**
+     * @brief Weights every particle by how likely a range reading would be,
+     * if the robot were at that particle.
+     *
+     * @param sensorOffset The point the reading is measured from, relative to
+     * the centre of the robot, with x to the right and y forwards. As the
+     * reading is offset back to the centre of the robot, this is the sensor's
+     * sideways offset from the beam through the centre.
+     * @param sensorAngle The direction the sensor points relative to the
+     * front of the robot, counter-clockwise positive.
+     * @param measuredDistance The distance read by the sensor, as given by
+     * readFromRobotCenter(), measured along the beam from sensorOffset
+     * rather than from the sensor itself.
+     * @param deviation The standard deviation of the reading, in
+     * millimeters.
+     */
+    void weigh(Position sensorOffset, Angle sensorAngle, int measuredDistance,
+               float deviation);
+
+    /**
+     * @brief Normalises the weights, and resamples the particles if the
+     * effective number of particles has dropped too low.
+     *
+     * @return (true) If the particles were resampled.
+     * @return (false) If the particles were kept.
+     */
+    bool resampleIfNeeded();
+
+    /**
+     * @brief Gets the weighted mean pose of the particles.
+     *
+     * @param positionDeviation_P The pointer used to return the standard
+     * deviation of the particles' positions, in millimeters.
+     * @return (Pose) The weighted mean pose.
+     */
+    Pose getEstimate(float* positionDeviation_P = nullptr);
+
+    /**
+     * @brief Gets the correction that moves the odometry onto the estimate,
+     * if the particles agree closely enough on the pose.
+     *
+     * Once the correction has been applied to the odometry, the jump
+     * doesn't count as movement on the next prediction.
+     *
+     * @param odometryPose The current pose from the odometry.
+     * @param correction_P The pointer used to return the correction.
+     * @return (true) If the particles agree, and a correction was returned.
+     * @return (false) If the particles are too spread out to be trusted.
+     */
+    bool getCorrection(Pose odometryPose, Pose* correction_P);
+
+   private:
+    /**
+     * @brief Pointer to the BrickList.
+     */
+    BrickList* _brickList_P;
+
+    /**
+     * @brief The particles.
+     */
+    Particle _particles[PARTICLE_COUNT];
+
+    /**
+     * @brief Space to draw the new particles into while resampling.
+     */
+    Particle _resampledParticles[PARTICLE_COUNT];
+
+    /**
+     * @brief The pose from the odometry at the last prediction or correction.
+     */
+    Pose _lastPose;
+
+    /**
+     * @brief Draws a random number from an approximate normal distribution.
+     *
+     * @param deviation The standard deviation of the distribution.
+     * @return (float) The random number.
+     */
+    float _randomNormal(float deviation);
+};
+
+#endif  // PARTICLE_FILTER_H
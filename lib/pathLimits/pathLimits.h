@@ -0,0 +1,37 @@
+/**
+ * @file pathLimits.h
+ * @brief The limits on how fast the robot drives along a path, shared by the
+ * map's speed field, the velocity planner and the pure pursuit path tracker,
+ * so that the speeds they plan agree with each other and with the motors.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#ifndef PATH_LIMITS_H
+#define PATH_LIMITS_H
+
+#include "speedController.h"
+
+// The fraction of the fastest wheel speed that a path is driven at, leaving
+// the rest for the speed controllers to correct errors and steer with.
+#define PATH_SPEED_HEADROOM 0.85f
+
+// The fastest speed in millimeters per second to drive along a path at, about
+// 425.
+#define PATH_MAX_SPEED (PATH_SPEED_HEADROOM * MAX_WHEEL_SPEED)
+
+// The acceleration and deceleration along a path in millimeters per second
+// squared.
+#define PATH_ACCELERATION 600
+
+// The sideways acceleration allowed while driving around a curve, in
+// millimeters per second squared.
+#define PATH_LATERAL_ACCELERATION 800
+
+// The slowest speed to drive along a path at, in millimeters per second, so
+// that the robot still creeps to the end of the path rather than stalling
+// short of it.
+#define PATH_MIN_SPEED 40
+
+#endif  // PATH_LIMITS_H
@@ -0,0 +1,406 @@
+/**
+ * @file poseEstimator.cpp
+ * @brief Definition of the PoseEstimator class, an error state extended
+ * Kalman filter that corrects the pose from the motion tracker using the range
+ * sensors.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-11
+ * @copyright Copyright (c) 2024
+ */
+#include "poseEstimator.h"
+
+#include "brick.h"
+
+// The variance added to the distance driven, in millimeters squared per
+// millimeter driven.
+#define ODOMETRY_DISTANCE_VARIANCE 0.5f
+
+// The variance added to the angle when turning, in radians squared per radian
+// turned, about 2° of error per quarter turn.
+#define ODOMETRY_TURN_VARIANCE 0.0008f
+
+// The variance added to the angle when driving, in radians squared per
+// millimeter driven, about 1° of drift per meter.
+#define ODOMETRY_DRIFT_VARIANCE 0.0000003f
+
+// Readings further from the prediction than this many standard deviations
+// are rejected, given as the square so that it can be compared directly with
+// the squared innovation over its variance.
+#define GATE_SQUARED_DEVIATIONS 9.0f
+
+// Readings hitting a face at a shallower angle than this are too unreliable
+// to use, given as the cosine of the angle between the sensor and the normal
+// of the face, so 0.5 is 60°.
+#define MIN_INCIDENCE_COSINE 0.5f
+
+/**
+ * @brief Construct a new PoseEstimator object.
+ *
+ * @param brickList_P Pointer to the BrickList, used to predict what the range
+ * sensors should read.
+ */
+PoseEstimator::PoseEstimator(BrickList* brickList_P)
+    : _brickList_P(brickList_P) {
+    this->reset(Pose(), 0, 0);
+}
+
+/**
+ * @brief Resets the filter to a known pose.
+ *
+ * @param pose The current pose from the odometry.
+ * @param positionDeviation The standard deviation of the x and y position,
+ * in millimeters.
+ * @param angleDeviation The standard deviation of the angle, in degrees.
+ */
+void PoseEstimator::reset(Pose pose, float positionDeviation,
+                          float angleDeviation) {
+    for (int row = 0; row < POSE_STATE_SIZE; row++) {
+        for (int column = 0; column < POSE_STATE_SIZE; column++) {
+            this->_covariance[row][column] = 0;
+        }
+    }
+
+    float angleDeviationRadians = angleDeviation * RADIANS_PER_DEGREE;
+
+    this->_covariance[0][0] = positionDeviation * positionDeviation;
+    this->_covariance[1][1] = positionDeviation * positionDeviation;
+    this->_covariance[2][2] = angleDeviationRadians * angleDeviationRadians;
+
+    this->_lastPose = pose;
+}
+
+/**
+ * @brief Resets the uncertainty of a single value of the pose, for when only
+ * that value has been measured directly, such as when the position along one
+ * axis is snapped to a wall. The uncertainty of the other values is kept, and
+ * the value is no longer correlated with them.
+ *
+ * @param pose The current pose from the odometry, after it was snapped.
+ * @param axis The value to reset, one of POSE_AXIS_X, POSE_AXIS_Y or
+ * POSE_AXIS_ANGLE.
+ * @param deviation The standard deviation of the value, in millimeters for the
+ * position or degrees for the angle.
+ */
+void PoseEstimator::resetAxis(Pose pose, uint8_t axis, float deviation) {
+    if (axis >= POSE_STATE_SIZE) {
+        return;
+    }
+
+    if (axis == POSE_AXIS_ANGLE) {
+        deviation *= RADIANS_PER_DEGREE;
+    }
+
+    for (int index = 0; index < POSE_STATE_SIZE; index++) {
+        this->_covariance[axis][index] = 0;
+        this->_covariance[index][axis] = 0;
+    }
+
+    this->_covariance[axis][axis] = deviation * deviation;
+
+    // The snap moved the odometry, which shouldn't count as movement on the
+    // next prediction.
+    this->_lastPose = pose;
+}
+
+/**
+ * @brief Adds extra uncertainty to the pose, for when the odometry is known to
+ * be unreliable, such as after a wheel has slipped, so that the range sensors
+ * are trusted more.
+ *
+ * @param positionDeviation The standard deviation to add to the x and y
+ * position, in millimeters.
+ * @param angleDeviation The standard deviation to add to the angle, in
+ * degrees.
+ */
+void PoseEstimator::addUncertainty(float positionDeviation,
+                                   float angleDeviation) {
+    float angleDeviationRadians = angleDeviation * RADIANS_PER_DEGREE;
+
+    this->_covariance[0][0] += positionDeviation * positionDeviation;
+    this->_covariance[1][1] += positionDeviation * positionDeviation;
+    this->_covariance[2][2] += angleDeviationRadians * angleDeviationRadians;
+}
+
+/**
+ * @brief Tells the filter that the odometry has been corrected by something
+ * other than the filter, so that the jump isn't counted as movement on the
+ * next prediction. The uncertainty is left as it is.
+ *
+ * @param correctedPose The pose from the odometry after the correction.
+ */
+void PoseEstimator::acceptCorrection(Pose correctedPose) {
+    this->_lastPose = correctedPose;
+}
+
+/**
+ * @brief Grows the uncertainty of the pose by the movement since the last
+ * prediction. This should be called every time the odometry updates.
+ *
+ * @param odometryPose The current pose from the odometry.
+ */
+void PoseEstimator::predict(Pose odometryPose) {
+    float changeInX = odometryPose.position.x - this->_lastPose.position.x;
+    float changeInY = odometryPose.position.y - this->_lastPose.position.y;
+
+    Angle changeInAngle = odometryPose.angle - this->_lastPose.angle;
+
+    if ((changeInX == 0) && (changeInY == 0) &&
+        (changeInAngle.getBinary() == 0)) {
+        return;
+    }
+
+    // The robot moves along the heading half way through the step, as in the
+    // motion tracker.
+    Angle midpointAngle = this->_lastPose.angle +
+                          Angle::fromBinary(changeInAngle.getBinary() / 2);
+
+    float cosine = midpointAngle.getCosine();
+    float sine = midpointAngle.getSine();
+
+    float distance = (changeInX * cosine) + (changeInY * sine);
+    float turn = changeInAngle.getRadians();
+
+    float(&P)[POSE_STATE_SIZE][POSE_STATE_SIZE] = this->_covariance;
+
+    // An error in the angle moves the position at right angles to the
+    // direction of travel, in proportion to the distance driven. This is the
+    // Jacobian of the motion, which only differs from the identity matrix in
+    // the angle column.
+    float xPerAngle = -distance * sine;
+    float yPerAngle = distance * cosine;
+
+    // Work out P = F * P * F^T without the full matrix multiplications, as
+    // most of F is the identity.
+    // First P = F * P, adding a multiple of the angle row to the x and y rows.
+    for (int column = 0; column < POSE_STATE_SIZE; column++) {
+        P[0][column] += xPerAngle * P[2][column];
+        P[1][column] += yPerAngle * P[2][column];
+    }
+    // Then P = P * F^T, adding a multiple of the angle column to the x and y
+    // columns.
+    for (int row = 0; row < POSE_STATE_SIZE; row++) {
+        P[row][0] += xPerAngle * P[row][2];
+        P[row][1] += yPerAngle * P[row][2];
+    }
+
+    // The error in the distance driven acts along the direction of travel.
+    float distanceVariance = ODOMETRY_DISTANCE_VARIANCE * abs(distance);
+
+    P[0][0] += distanceVariance * cosine * cosine;
+    P[0][1] += distanceVariance * cosine * sine;
+    P[1][0] += distanceVariance * cosine * sine;
+    P[1][1] += distanceVariance * sine * sine;
+
+    P[2][2] += (ODOMETRY_TURN_VARIANCE * abs(turn)) +
+               (ODOMETRY_DRIFT_VARIANCE * abs(distance));
+
+    this->_lastPose = odometryPose;
+}
+
+/**
+ * @brief Corrects the pose using a range reading, if the reading can be
+ * predicted from the BrickList and agrees closely enough with the prediction.
+ *
+ * @param robotPose The current pose from the odometry.
+ * @param sensorOffset The point the reading is measured from, relative to the
+ * centre of the robot, with x to the right and y forwards. As the reading is
+ * offset back to the centre of the robot, this is the sensor's sideways offset
+ * from the beam through the centre.
+ * @param sensorAngle The direction the sensor points relative to the front of
+ * the robot, counter-clockwise positive.
+ * @param measuredDistance The distance read by the sensor, as given by
+ * readFromRobotCenter(), measured along the beam from sensorOffset rather
+ * than from the sensor itself.
+ * @param variance The variance of the reading, in millimeters squared.
+ * @param correction_P The pointer used to return the correction to apply to
+ * the pose from the odometry.
+ * @return (true) If the reading was used, and a correction returned.
+ * @return (false) If the reading was rejected.
+ */
+bool PoseEstimator::update(Pose robotPose, Position sensorOffset,
+                           Angle sensorAngle, int measuredDistance,
+                           float variance, Pose* correction_P) {
+    if (measuredDistance < 0) {
+        return false;
+    }
+
+    float H[POSE_STATE_SIZE];
+
+    float expectedDistance =
+        this->_predictRange(robotPose, sensorOffset, sensorAngle, H);
+
+    if (expectedDistance < 0) {
+        return false;
+    }
+
+    float(&P)[POSE_STATE_SIZE][POSE_STATE_SIZE] = this->_covariance;
+
+    // P * H^T, which is also the covariance between the state and the
+    // reading.
+    float PHt[POSE_STATE_SIZE];
+    for (int row = 0; row < POSE_STATE_SIZE; row++) {
+        PHt[row] = (P[row][0] * H[0]) + (P[row][1] * H[1]) + (P[row][2] * H[2]);
+    }
+
+    // The variance of the innovation.
+    float S = (H[0] * PHt[0]) + (H[1] * PHt[1]) + (H[2] * PHt[2]) + variance;
+
+    float innovation = measuredDistance - expectedDistance;
+
+    // Reject readings that are too unlikely given the uncertainty, such as
+    // a reading of a Brick that isn't in the BrickList yet.
+    if ((innovation * innovation) > (GATE_SQUARED_DEVIATIONS * S)) {
+        this->_rejectedCount++;
+        return false;
+    }
+
+    float K[POSE_STATE_SIZE];
+    for (int row = 0; row < POSE_STATE_SIZE; row++) {
+        K[row] = PHt[row] / S;
+    }
+
+    // P = (I - K * H) * P, which as P * H^T = K * S, is the same as
+    // P = P - K * K^T * S, and keeps P symmetric.
+    for (int row = 0; row < POSE_STATE_SIZE; row++) {
+        for (int column = 0; column < POSE_STATE_SIZE; column++) {
+            P[row][column] -= K[row] * K[column] * S;
+        }
+    }
+
+    Pose correction;
+    correction.position.x = K[0] * innovation;
+    correction.position.y = K[1] * innovation;
+    correction.angle =
+        Angle::fromDegrees(K[2] * innovation * DEGREES_PER_RADIAN);
+
+    // Once the correction is applied, the odometry moves by it, which
+    // shouldn't count as movement on the next prediction.
+    this->_lastPose.position.x = robotPose.position.x + correction.position.x;
+    this->_lastPose.position.y = robotPose.position.y + correction.position.y;
+    this->_lastPose.angle = robotPose.angle + correction.angle;
+
+    if (correction_P != nullptr) {
+        *correction_P = correction;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Gets the standard deviation of the position, combining x and y.
+ *
+ * @return (float) The standard deviation of the position in millimeters.
+ */
+float PoseEstimator::getPositionDeviation() {
+    return sqrtf(this->_covariance[0][0] + this->_covariance[1][1]);
+}
+
+/**
+ * @brief Gets the standard deviation of a single value of the pose.
+ *
+ * @param axis The value, one of POSE_AXIS_X, POSE_AXIS_Y or POSE_AXIS_ANGLE.
+ * @return (float) The standard deviation, in millimeters for the position or
+ * degrees for the angle.
+ */
+float PoseEstimator::getAxisDeviation(uint8_t axis) {
+    if (axis >= POSE_STATE_SIZE) {
+        return -1;
+    }
+
+    float deviation = sqrtf(this->_covariance[axis][axis]);
+
+    if (axis == POSE_AXIS_ANGLE) {
+        deviation *= DEGREES_PER_RADIAN;
+    }
+
+    return deviation;
+}
+
+/**
+ * @brief Gets the standard deviation of the angle.
+ *
+ * @return (float) The standard deviation of the angle in degrees.
+ */
+float PoseEstimator::getAngleDeviation() {
+    return sqrtf(this->_covariance[2][2]) * DEGREES_PER_RADIAN;
+}
+
+/**
+ * @brief Gets the number of readings that have been rejected by the gate for
+ * disagreeing too much with the prediction.
+ *
+ * @return (uint32_t) The number of rejected readings.
+ */
+uint32_t PoseEstimator::getRejectedCount() { return this->_rejectedCount; }
+
+/**
+ * @brief Predicts what a range sensor should read from a given pose, and how
+ * that reading changes with the pose.
+ *
+ * @param robotPose The pose of the robot.
+ * @param sensorOffset The position of the sensor relative to the centre of the
+ * robot.
+ * @param sensorAngle The direction the sensor points relative to the front of
+ * the robot.
+ * @param jacobian The array used to return the change in the reading per unit
+ * change of x, y and angle.
+ * @return (float) The expected distance from the sensor offset.
+ * @return (-1) If the reading can't be predicted.
+ */
+float PoseEstimator::_predictRange(Pose robotPose, Position sensorOffset,
+                                   Angle sensorAngle,
+                                   float jacobian[POSE_STATE_SIZE]) {
+    float robotCosine = robotPose.angle.getCosine();
+    float robotSine = robotPose.angle.getSine();
+
+    // The sensor's position in the maze, where the robot's right is
+    // (sin, -cos) and its front is (cos, sin).
+    Position sensorPosition;
+    sensorPosition.x = robotPose.position.x + (sensorOffset.x * robotSine) +
+                       (sensorOffset.y * robotCosine);
+    sensorPosition.y = robotPose.position.y - (sensorOffset.x * robotCosine) +
+                       (sensorOffset.y * robotSine);
+
+    // How the sensor's position moves as the robot turns.
+    float sensorXPerAngle =
+        (sensorOffset.x * robotCosine) - (sensorOffset.y * robotSine);
+    float sensorYPerAngle =
+        (sensorOffset.x * robotSine) + (sensorOffset.y * robotCosine);
+
+    Angle beamAngle = robotPose.angle + sensorAngle;
+
+    bool hitVerticalFace;
+    float expectedDistance =
+        this->_brickList_P->rayCast(sensorPosition, beamAngle, &hitVerticalFace);
+
+    if (expectedDistance < 0) {
+        return -1;
+    }
+
+    float beamCosine = beamAngle.getCosine();
+    float beamSine = beamAngle.getSine();
+
+    // For a vertical face at x = X, the distance is (X - sensor x) / cos, and
+    // for a horizontal face at y = Y it is (Y - sensor y) / sin. These are
+    // differentiated with respect to the x, y and angle of the robot.
+    if (hitVerticalFace) {
+        if (abs(beamCosine) < MIN_INCIDENCE_COSINE) {
+            return -1;
+        }
+        jacobian[0] = -1 / beamCosine;
+        jacobian[1] = 0;
+        jacobian[2] =
+            (-sensorXPerAngle + (expectedDistance * beamSine)) / beamCosine;
+    } else {
+        if (abs(beamSine) < MIN_INCIDENCE_COSINE) {
+            return -1;
+        }
+        jacobian[0] = 0;
+        jacobian[1] = -1 / beamSine;
+        jacobian[2] =
+            (-sensorYPerAngle - (expectedDistance * beamCosine)) / beamSine;
+    }
+
+    return expectedDistance;
+}
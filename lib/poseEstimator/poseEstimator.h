@@ -0,0 +1,203 @@
+/**
+ * @file poseEstimator.h
+ * @brief Declaration of the PoseEstimator class, an error state extended
+ * Kalman filter that corrects the pose from the motion tracker using the range
+ * sensors.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-11
+ * @copyright Copyright (c) 2024
+ */
+#ifndef POSE_ESTIMATOR_H
+#define POSE_ESTIMATOR_H
+
+#include <Arduino.h>
+
+#include "angleAndPosition.h"
+
+// Forward declaration of the BrickList class.
+class BrickList;
+
+// The number of values in the state of the filter, x, y and angle.
+#define POSE_STATE_SIZE 3
+
+// The index of each value in the state of the filter.
+#define POSE_AXIS_X 0
+#define POSE_AXIS_Y 1
+#define POSE_AXIS_ANGLE 2
+
+/**
+ * @brief PoseEstimator class, keeps track of how uncertain the pose from the
+ * odometry is, and uses each range reading that can be predicted from the
+ * BrickList to correct it.
+ *
+ * The odometry stays in charge of the pose, the filter only tracks the error
+ * in it. Each correction is handed back to be applied to the odometry, after
+ * which the error is zero again, so the filter never has to hold its own copy
+ * of the pose.
+ *
+ * The position is in millimeters and the angle is in radians, so that the
+ * covariance is in units that fit the maths.
+ *
+ * This class doesn't touch any hardware, so can be tested on its own.
+ */
+class PoseEstimator {
+   public:
+    /**
+     * @brief Construct a new PoseEstimator object.
+     *
+     * @param brickList_P Pointer to the BrickList, used to predict what the
+     * range sensors should read.
+     */
+    PoseEstimator(BrickList* brickList_P);
+
+    /**
+     * @brief Resets the filter to a known pose.
+     *
+     * @param pose The current pose from the odometry.
+     * @param positionDeviation The standard deviation of the x and y position,
+     * in millimeters.
+     * @param angleDeviation The standard deviation of the angle, in degrees.
+     */
+    void reset(Pose pose, float positionDeviation, float angleDeviation);
+
+    /**
+     * @brief Resets the uncertainty of a single value of the pose, for when
+     * only that value has been measured directly, such as when the position
+     * along one axis is snapped to a wall. The uncertainty of the other values
+     * is kept, and the value is no longer correlated with them.
+     *
+     * @param pose The current pose from the odometry, after it was snapped.
+     * @param axis The value to reset, one of POSE_AXIS_X, POSE_AXIS_Y or
+     * POSE_AXIS_ANGLE.
+     * @param deviation The standard deviation of the value, in millimeters for
+     * the position or degrees for the angle.
+     */
+    void resetAxis(Pose pose, uint8_t axis, float deviation);
+
+    /**
+     * @brief Adds extra uncertainty to the pose, for when the odometry is
+     * known to be unreliable, such as after a wheel has slipped, so that the
+     * range sensors are trusted more.
+     *
+     * @param positionDeviation The standard deviation to add to the x and y
+     * position, in millimeters.
+     * @param angleDeviation The standard deviation to add to the angle, in
+     * degrees.
+     */
+    void addUncertainty(float positionDeviation, float angleDeviation);
+
+    /**
+     * @brief Tells the filter that the odometry has been corrected by
+     * something other than the filter, so that the jump isn't counted as
+     * movement on the next prediction. The uncertainty is left as it is.
+     *
+     * @param correctedPose The pose from the odometry after the correction.
+     */
+    void acceptCorrection(Pose correctedPose);
+
+    /**
+     * @brief Grows the uncertainty of the pose by the movement since the last
+     * prediction. This should be called every time the odometry updates.
+     *
+     * @param odometryPose The current pose from the odometry.
+     */
+    void predict(Pose odometryPose);
+
+    /**
+     * @brief Corrects the pose using a range reading, if the reading can be
+     * predicted from the BrickList and agrees closely enough with the
+     * prediction.
+     *
+     * @param robotPose The current pose from the odometry.
+     * @param sensorOffset The point the reading is measured from, relative to
+     * the centre of the robot, with x to the right and y forwards. As the
+     * reading is offset back to the centre of the robot, this is the sensor's
+     * sideways offset from the beam through the centre.
+     * @param sensorAngle The direction the sensor points relative to the
+     * front of the robot, counter-clockwise positive.
+     * @param measuredDistance The distance read by the sensor, as given by
+     * readFromRobotCenter(), measured along the beam from sensorOffset
+     * rather than from the sensor itself.
+     * @param variance The variance of the reading, in millimeters squared.
+     * @param correction_P The pointer used to return the correction to apply
+     * to the pose from the odometry.
+     * @return (true) If the reading was used, and a correction returned.
+     * @return (false) If the reading was rejected.
+     */
+    bool update(Pose robotPose, Position sensorOffset, Angle sensorAngle,
+                int measuredDistance, float variance, Pose* correction_P);
+
+    /**
+     * @brief Gets the standard deviation of the position, combining x and y.
+     *
+     * @return (float) The standard deviation of the position in millimeters.
+     */
+    float getPositionDeviation();
+
+    /**
+     * @brief Gets the standard deviation of a single value of the pose.
+     *
+     * @param axis The value, one of POSE_AXIS_X, POSE_AXIS_Y or
+     * POSE_AXIS_ANGLE.
+     * @return (float) The standard deviation, in millimeters for the position
+     * or degrees for the angle.
+     */
+    float getAxisDeviation(uint8_t axis);
+
+    /**
+     * @brief Gets the standard deviation of the angle.
+     *
+     * @return (float) The standard deviation of the angle in degrees.
+     */
+    float getAngleDeviation();
+
+    /**
+     * @brief Gets the number of readings that have been rejected by the gate
+     * for disagreeing too much with the prediction.
+     *
+     * @return (uint32_t) The number of rejected readings.
+     */
+    uint32_t getRejectedCount();
+
+   private:
+    /**
+     * @brief Pointer to the BrickList.
+     */
+    BrickList* _brickList_P;
+
+    /**
+     * @brief The covariance of the error in the pose, in the order x, y,
+     * angle.
+     */
+    float _covariance[POSE_STATE_SIZE][POSE_STATE_SIZE];
+
+    /**
+     * @brief The pose from the odometry at the last prediction or correction.
+     */
+    Pose _lastPose;
+
+    /**
+     * @brief The number of readings rejected by the gate.
+     */
+    uint32_t _rejectedCount = 0;
+
+    /**
+     * @brief Predicts what a range sensor should read from a given pose, and
+     * how that reading changes with the pose.
+     *
+     * @param robotPose The pose of the robot.
+     * @param sensorOffset The position of the sensor relative to the centre of
+     * the robot.
+     * @param sensorAngle The direction the sensor points relative to the
+     * front of the robot.
+     * @param jacobian The array used to return the change in the reading per
+     * unit change of x, y and angle.
+     * @return (float) The expected distance from the sensor offset.
+     * @return (-1) If the reading can't be predicted.
+     */
+    float _predictRange(Pose robotPose, Position sensorOffset,
+                        Angle sensorAngle, float jacobian[POSE_STATE_SIZE]);
+};
+
+#endif  // POSE_ESTIMATOR_H
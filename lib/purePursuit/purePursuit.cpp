@@ -0,0 +1,249 @@
+/**
+ * @file purePursuit.cpp
+ * @brief Definition of the PurePursuit class, responsible for driving the
+ * robot continuously along a path of waypoints.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-07
+ * @copyright Copyright (c) 2024
+ */
+#include "purePursuit.h"
+
+#include "drive.h"
+#include "motionTracker.h"
+#include "pathLimits.h"
+
+// The lookahead distance is the minimum, plus a distance that grows with
+// speed, in millimeters and seconds.
+#define MIN_LOOKAHEAD_DISTANCE 60
+#define MAX_LOOKAHEAD_DISTANCE 200
+#define LOOKAHEAD_TIME 0.2f
+
+// The rotational speed in degrees per second to turn on the spot at, when the
+// path is behind the robot.
+#define PURSUIT_TURN_SPEED 90
+
+// How close the robot must be to the end of the path, in millimeters, to have
+// finished it.
+#define PATH_END_TOLERANCE 10
+
+// The largest time step in seconds that the speed will ramp up over.
+#define PURSUIT_MAX_TIME_STEP 0.05f
+
+/**
+ * @brief Construct a new PurePursuit object.
+ *
+ * @param motionTracker_P Pointer to the motion tracker, used to get the
+ * pose of the robot.
+ * @param drive_P Pointer to the drive object, used to set the speed of the
+ * robot.
+ * @param maxSpeed The fastest speed to follow the path at, in millimeters
+ * per second.
+ */
+PurePursuit::PurePursuit(MotionTracker* motionTracker_P, Drive* drive_P,
+                         int maxSpeed)
+    : _motionTracker_P(motionTracker_P),
+      _drive_P(drive_P),
+      _maxSpeed(maxSpeed) {}
+
+/**
+ * @brief Sets the path to follow, replacing any existing path.
+ *
+ * @param path The waypoints of the path, starting at the robot's current
+ * position.
+ */
+void PurePursuit::setPath(std::vector<Position> path) {
+    this->_path = path;
+    this->_speedProfile.clear();
+    this->_segmentIndex = 0;
+    this->_lastFollowTime = millis();
+}
+
+/**
+ * @brief Sets the speed to drive at each waypoint of the path, in place of the
+ * max speed. This must be called after setPath(), as setting the path clears
+ * the speed profile.
+ *
+ * @param speeds The speeds at each waypoint, in millimeters per second.
+ */
+void PurePursuit::setSpeedProfile(std::vector<float> speeds) {
+    this->_speedProfile = speeds;
+}
+
+/**
+ * @brief Clears the path, without stopping the robot.
+ */
+void PurePursuit::clear() {
+    this->_path.clear();
+    this->_speedProfile.clear();
+    this->_segmentIndex = 0;
+    this->_speed = 0;
+}
+
+/**
+ * @brief Returns whether there is a path being followed.
+ *
+ * @return (true) If there is a path to follow.
+ * @return (false) If there is no path.
+ */
+bool PurePursuit::hasPath() { return this->_path.size() >= 2; }
+
+/**
+ * @brief Updates the speed of the robot to follow the path, this should
+ * be called every loop while following the path.
+ *
+ * @return (true) If the robot has reached the end of the path.
+ * @return (false) If the robot is still following the path.
+ */
+bool PurePursuit::follow() {
+    if (!this->hasPath()) {
+        return true;
+    }
+
+    uint32_t currentTime = millis();
+    float timeStep = (currentTime - this->_lastFollowTime) / 1000.0f;
+    timeStep = min(timeStep, PURSUIT_MAX_TIME_STEP);
+    this->_lastFollowTime = currentTime;
+
+    Pose robotPose = this->_motionTracker_P->getPose();
+    Position robotPosition = robotPose.position;
+
+    size_t lastSegment = this->_path.size() - 2;
+
+    // Find the closest point on the current segment, moving onto the next
+    // segment once the robot has passed the end of the current one.
+    Position closestPoint;
+    float progress = 1;
+    while (true) {
+        Position segmentStart = this->_path[this->_segmentIndex];
+        Position segmentEnd = this->_path[this->_segmentIndex + 1];
+
+        float segmentX = segmentEnd.x - segmentStart.x;
+        float segmentY = segmentEnd.y - segmentStart.y;
+        float segmentLengthSquared = segmentX * segmentX + segmentY * segmentY;
+
+        // How far along the segment the robot is, from 0 at the start to 1 at
+        // the end.
+        progress = 1;
+        if (segmentLengthSquared > 0) {
+            progress = ((robotPosition.x - segmentStart.x) * segmentX +
+                        (robotPosition.y - segmentStart.y) * segmentY) /
+                       segmentLengthSquared;
+        }
+
+        if ((progress >= 1) && (this->_segmentIndex < lastSegment)) {
+            this->_segmentIndex++;
+            continue;
+        }
+
+        progress = constrain(progress, 0, 1);
+        closestPoint = Position(segmentStart.x + progress * segmentX,
+                                segmentStart.y + progress * segmentY);
+        break;
+    }
+
+    // The remaining length of the path, used to slow down into the end.
+    float remainingDistance =
+        closestPoint.distanceTo(this->_path[this->_segmentIndex + 1]);
+    for (size_t i = this->_segmentIndex + 1; i <= lastSegment; i++) {
+        remainingDistance += this->_path[i].distanceTo(this->_path[i + 1]);
+    }
+
+    Position endPoint = this->_path.back();
+
+    if ((robotPosition.distanceTo(endPoint) < PATH_END_TOLERANCE) ||
+        (remainingDistance < PATH_END_TOLERANCE)) {
+        this->clear();
+        return true;
+    }
+
+    // Look further ahead at speed, so that the robot starts curving earlier.
+    float lookaheadDistance =
+        constrain(MIN_LOOKAHEAD_DISTANCE + LOOKAHEAD_TIME * this->_speed,
+                  MIN_LOOKAHEAD_DISTANCE, MAX_LOOKAHEAD_DISTANCE);
+
+    Position lookaheadPoint = this->_pointAlongPath(
+        closestPoint, this->_segmentIndex, lookaheadDistance);
+
+    Angle angleToLookahead =
+        robotPosition.calculateAngleTo(lookaheadPoint) - robotPose.angle;
+
+    // If the path is behind the robot, turn on the spot to face it.
+    if (abs(angleToLookahead.getDegrees()) > 90) {
+        this->_speed = 0;
+
+        if (angleToLookahead.getDegrees() > 0) {
+            this->_drive_P->setSpeed(0, PURSUIT_TURN_SPEED);
+        } else {
+            this->_drive_P->setSpeed(0, -PURSUIT_TURN_SPEED);
+        }
+        return false;
+    }
+
+    // The curvature of the arc that passes through the robot and the
+    // lookahead point, tangent to the robot's heading.
+    float distanceToLookahead = robotPosition.distanceTo(lookaheadPoint);
+    float curvature =
+        2 * angleToLookahead.getSine() / max(distanceToLookahead, 1.0f);
+
+    // The speed is limited by how quickly the robot can accelerate, how
+    // quickly it can stop before the end of the path, and how fast it can
+    // go around the curve.
+    float speed = this->_speed + (PATH_ACCELERATION * timeStep);
+    speed = min(speed, sqrtf(2 * PATH_ACCELERATION * remainingDistance));
+
+    // With a speed profile, track the planned speed at the closest point,
+    // blending between the waypoints either side of it.
+    if (this->_speedProfile.size() == this->_path.size()) {
+        float startSpeed = this->_speedProfile[this->_segmentIndex];
+        float endSpeed = this->_speedProfile[this->_segmentIndex + 1];
+        speed = min(speed, startSpeed + progress * (endSpeed - startSpeed));
+    } else {
+        speed = min(speed, (float)this->_maxSpeed);
+    }
+
+    if (curvature != 0) {
+        speed = min(speed, sqrtf(PATH_LATERAL_ACCELERATION / abs(curvature)));
+    }
+
+    speed = max(speed, (float)PATH_MIN_SPEED);
+    this->_speed = speed;
+
+    float rotationalSpeed = speed * curvature * DEGREES_PER_RADIAN;
+
+    this->_drive_P->setSpeed(speed, rotationalSpeed);
+
+    return false;
+}
+
+/**
+ * @brief Finds the point a set distance along the path, from a point on
+ * a given segment.
+ *
+ * @param startPoint The point to start from, on the segment.
+ * @param segmentIndex The index of the segment that the start point is
+ * on.
+ * @param distance The distance along the path to travel.
+ * @return (Position) The point along the path, or the end of the path if
+ * it is closer than the given distance.
+ */
+Position PurePursuit::_pointAlongPath(Position startPoint, size_t segmentIndex,
+                                      float distance) {
+    Position point = startPoint;
+
+    for (size_t i = segmentIndex + 1; i < this->_path.size(); i++) {
+        Position nextPoint = this->_path[i];
+        float segmentLength = point.distanceTo(nextPoint);
+
+        if (segmentLength >= distance) {
+            float fraction = distance / segmentLength;
+            return Position(point.x + fraction * (nextPoint.x - point.x),
+                            point.y + fraction * (nextPoint.y - point.y));
+        }
+
+        distance -= segmentLength;
+        point = nextPoint;
+    }
+
+    return this->_path.back();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file purePursuit.h
+ * @brief Declaration of the PurePursuit class, responsible for driving the
+ * robot continuously along a path of waypoints.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-07
+ * @copyright Copyright (c) 2024
+ */
+#ifndef PURE_PURSUIT_H
+#define PURE_PURSUIT_H
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "angleAndPosition.h"
+
+// Forward declaration of the MotionTracker and Drive classes.
+class MotionTracker;
+class Drive;
+
+/**
+ * @brief PurePursuit class, a path tracker that steers the robot towards a
+ * point a set distance ahead of it along the path, so that corners are driven
+ * as arcs rather than stopping and turning on the spot.
+ */
+class PurePursuit {
+   public:
+    /**
+     * @brief Construct a new PurePursuit object.
+     *
+     * @param motionTracker_P Pointer to the motion tracker, used to get the
+     * pose of the robot.
+     * @param drive_P Pointer to the drive object, used to set the speed of the
+     * robot.
+     * @param maxSpeed The fastest speed to follow the path at, in millimeters
+     * per second.
+     */
+    PurePursuit(MotionTracker* motionTracker_P, Drive* drive_P, int maxSpeed);
+
+    /**
+     * @brief Sets the path to follow, replacing any existing path.
+     *
+     * @param path The waypoints of the path, starting at the robot's current
+     * position.
+     */
+    void setPath(std::vector<Position> path);
+
+    /**
+     * @brief Sets the speed to drive at each waypoint of the path, in place
+     * of the max speed. This must be called after setPath(), as setting the
+     * path clears the speed profile.
+     *
+     * @param speeds The speeds at each waypoint, in millimeters per second.
+     */
+    void setSpeedProfile(std::vector<float> speeds);
+
+    /**
+     * @brief Clears the path, without stopping the robot.
+     */
+    void clear();
+
+    /**
+     * @brief Returns whether there is a path being followed.
+     *
+     * @return (true) If there is a path to follow.
+     * @return (false) If there is no path.
+     */
+    bool hasPath();
+
+    /**
+     * @brief Updates the speed of the robot to follow the path, this should
+     * be called every loop while following the path.
+     *
+     * @return (true) If the robot has reached the end of the path.
+     * @return (false) If the robot is still following the path.
+     */
+    bool follow();
+
+   private:
+    /**
+     * @brief Finds the point a set distance along the path, from a point on
+     * a given segment.
+     *
+     * @param startPoint The point to start from, on the segment.
+     * @param segmentIndex The index of the segment that the start point is
+     * on.
+     * @param distance The distance along the path to travel.
+     * @return (Position) The point along the path, or the end of the path if
+     * it is closer than the given distance.
+     */
+    Position _pointAlongPath(Position startPoint, size_t segmentIndex,
+                             float distance);
+
+    /**
+     * @brief Pointer to the motion tracker.
+     */
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief Pointer to the drive object.
+     */
+    Drive* _drive_P;
+
+    /**
+     * @brief The fastest speed to follow the path at, in millimeters per
+     * second.
+     */
+    int _maxSpeed;
+
+    /**
+     * @brief The waypoints of the path being followed.
+     */
+    std::vector<Position> _path;
+
+    /**
+     * @brief The planned speed at each waypoint of the path, in millimeters
+     * per second, empty if the path is followed at the max speed.
+     */
+    std::vector<float> _speedProfile;
+
+    /**
+     * @brief The index of the segment of the path that the robot is on, where
+     * segment i runs from waypoint i to waypoint i + 1.
+     */
+    size_t _segmentIndex = 0;
+
+    /**
+     * @brief The last speed the robot was set to, in millimeters per second.
+     */
+    float _speed = 0;
+
+    /**
+     * @brief The time of the last update in milliseconds.
+     */
+    uint32_t _lastFollowTime = 0;
+};
+
+#endif  // PURE_PURSUIT_H
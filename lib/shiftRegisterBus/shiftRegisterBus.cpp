@@ -0,0 +1,105 @@
+/**
+ * @file shiftRegisterBus.cpp
+ * @brief Definitions of the ShiftRegisterBus class, responsible for reading
+ * the shift registers of the bumper and the NES controller, which share a load
+ * and a clock pin.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-04
+ * @copyright Copyright (c) 2024
+ */
+
+#include "shiftRegisterBus.h"
+
+// The number of bits held in each shift register.
+#define SHIFT_REGISTER_BIT_COUNT 8
+
+/**
+ * @brief Construct a new ShiftRegisterBus object, then sets the data pins to
+ * input, and the load and clock pin to output.
+ *
+ * @param bumperDataPin The pin connected to the data pin on the bumper's
+ * shift register.
+ * @param nesDataPin The pin connected to the data pin on the NES controller's
+ * shift register.
+ * @param loadPin The pin connected to the load pin on both shift registers.
+ * @param clockPin The pin connected to the clock pin on both shift registers.
+ */
+ShiftRegisterBus::ShiftRegisterBus(uint8_t bumperDataPin, uint8_t nesDataPin,
+                                   uint8_t loadPin, uint8_t clockPin)
+    : _bumperDataPin(bumperDataPin),
+      _nesDataPin(nesDataPin),
+      _loadPin(loadPin),
+      _clockPin(clockPin) {
+    pinMode(this->_bumperDataPin, INPUT);
+    pinMode(this->_nesDataPin, INPUT);
+    pinMode(this->_loadPin, OUTPUT);
+    pinMode(this->_clockPin, OUTPUT);
+}
+
+/**
+ * @brief Latches both shift registers and reads their contents into the
+ * snapshot. This should be called once per loop.
+ */
+void ShiftRegisterBus::poll() {
+    uint8_t bumperData = 0;
+    uint8_t nesData = 0;
+
+    // Pulse the load pin to load the button states into both shift registers.
+    digitalWrite(this->_loadPin, LOW);
+    delayMicroseconds(1);
+    digitalWrite(this->_loadPin, HIGH);
+    delayMicroseconds(1);
+    digitalWrite(this->_loadPin, LOW);
+
+    // For each bit,
+    for (int i = 0; i < SHIFT_REGISTER_BIT_COUNT; i++) {
+        // Load the bumper's bit into the lsb, after shifting the received data
+        // up by one.
+        bumperData <<= 1;
+        bumperData |= digitalRead(this->_bumperDataPin);
+
+        // The NES controller sends its buttons lsb first, with a low bit for
+        // a pressed button.
+        if (digitalRead(this->_nesDataPin) == LOW) {
+            nesData |= (1 << i);
+        }
+
+        // Pulse the clock pin to shift the data inside both shift registers.
+        digitalWrite(this->_clockPin, LOW);
+        delayMicroseconds(1);
+        digitalWrite(this->_clockPin, HIGH);
+        delayMicroseconds(1);
+    }
+
+    this->_bumperData = bumperData;
+    this->_nesData = nesData;
+    this->_snapshotTime = millis();
+}
+
+/**
+ * @brief Gets the raw contents of the bumper's shift register, from the most
+ * recent snapshot.
+ *
+ * @return (uint8_t) The raw data read from the bumper's shift register, where
+ * the first bit clocked out is the msb.
+ */
+uint8_t ShiftRegisterBus::getBumperData() { return this->_bumperData; }
+
+/**
+ * @brief Gets the contents of the NES controller's shift register, from the
+ * most recent snapshot.
+ *
+ * @return (uint8_t) The data read from the NES controller's shift register,
+ * where the first bit clocked out is the lsb, and a set bit indicates a
+ * pressed button.
+ */
+uint8_t ShiftRegisterBus::getNESData() { return this->_nesData; }
+
+/**
+ * @brief Gets the time at which the most recent snapshot was taken.
+ *
+ * @return (uint32_t) The time in milliseconds that the shift registers were
+ * last read.
+ */
+uint32_t ShiftRegisterBus::getSnapshotTime() { return this->_snapshotTime; }
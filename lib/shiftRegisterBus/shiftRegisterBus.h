@@ -0,0 +1,115 @@
+/**
+ * @file shiftRegisterBus.h
+ * @brief Declaration of the ShiftRegisterBus class, responsible for reading
+ * the shift registers of the bumper and the NES controller, which share a load
+ * and a clock pin.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-04
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef SHIFT_REGISTER_BUS_H
+#define SHIFT_REGISTER_BUS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief The ShiftRegisterBus class, responsible for reading the shift
+ * registers of the bumper and the NES controller.
+ *
+ * As both shift registers share a load and a clock pin, they are latched
+ * together and clocked out in the same pass, and the result is kept as a
+ * snapshot until the next poll.
+ */
+class ShiftRegisterBus {
+   public:
+    /**
+     * @brief Construct a new ShiftRegisterBus object, then sets the data pins
+     * to input, and the load and clock pin to output.
+     *
+     * @param bumperDataPin The pin connected to the data pin on the bumper's
+     * shift register.
+     * @param nesDataPin The pin connected to the data pin on the NES
+     * controller's shift register.
+     * @param loadPin The pin connected to the load pin on both shift
+     * registers.
+     * @param clockPin The pin connected to the clock pin on both shift
+     * registers.
+     */
+    ShiftRegisterBus(uint8_t bumperDataPin, uint8_t nesDataPin,
+                     uint8_t loadPin, uint8_t clockPin);
+
+    /**
+     * @brief Latches both shift registers and reads their contents into the
+     * snapshot. This should be called once per loop.
+     */
+    void poll();
+
+    /**
+     * @brief Gets the raw contents of the bumper's shift register, from the
+     * most recent snapshot.
+     *
+     * @return (uint8_t) The raw data read from the bumper's shift register,
+     * where the first bit clocked out is the msb.
+     */
+    uint8_t getBumperData();
+
+    /**
+     * @brief Gets the contents of the NES controller's shift register, from
+     * the most recent snapshot.
+     *
+     * @return (uint8_t) The data read from the NES controller's shift
+     * register, where the first bit clocked out is the lsb, and a set bit
+     * indicates a pressed button.
+     */
+    uint8_t getNESData();
+
+    /**
+     * @brief Gets the time at which the most recent snapshot was taken.
+     *
+     * @return (uint32_t) The time in milliseconds that the shift registers
+     * were last read.
+     */
+    uint32_t getSnapshotTime();
+
+   private:
+    /**
+     * @brief The pin connected to the data pin on the bumper's shift register.
+     */
+    uint8_t _bumperDataPin;
+
+    /**
+     * @brief The pin connected to the data pin on the NES controller's shift
+     * register.
+     */
+    uint8_t _nesDataPin;
+
+    /**
+     * @brief The pin connected to the load pin on both shift registers.
+     */
+    uint8_t _loadPin;
+
+    /**
+     * @brief The pin connected to the clock pin on both shift registers.
+     */
+    uint8_t _clockPin;
+
+    /**
+     * @brief The contents of the bumper's shift register at the last poll.
+     */
+    uint8_t _bumperData = 0;
+
+    /**
+     * @brief The contents of the NES controller's shift register at the last
+     * poll.
+     */
+    uint8_t _nesData = 0;
+
+    /**
+     * @brief The time in milliseconds at which the last poll took place.
+     */
+    uint32_t _snapshotTime = 0;
+};
+
+#endif  // SHIFT_REGISTER_BUS_H
@@ -0,0 +1,146 @@
+/**
+ * @file speedController.cpp
+ * @brief Definition of the SpeedController class, responsible for driving a
+ * single wheel at a set speed, using the speed measured by its encoder.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-06
+ * @copyright Copyright (c) 2024
+ */
+#include "speedController.h"
+
+#include "motor.h"
+
+// The period in milliseconds between updates of the controller.
+#define SPEED_CONTROL_PERIOD 10
+
+// The largest time step in seconds that the controller will integrate over,
+// so that a long gap between polls doesn't cause a jump in the output.
+#define MAX_TIME_STEP 0.05f
+
+// The gains of the controller, in percent of power per millimeter per second
+// of error, and per millimeter of accumulated error.
+#define SPEED_PROPORTIONAL_GAIN 0.08f
+#define SPEED_INTEGRAL_GAIN 0.6f
+
+// The fastest that the wheel is allowed to change speed, in millimeters per
+// second squared.
+#define MAX_WHEEL_ACCELERATION 1000
+
+/**
+ * @brief Construct a new SpeedController object.
+ *
+ * @param motor_P Pointer to the motor to control.
+ */
+SpeedController::SpeedController(Motor* motor_P)
+    : _motor_P(motor_P), _pollSchedule(SPEED_CONTROL_PERIOD) {}
+
+/**
+ * @brief Sets the speed for the wheel to be driven at. The speed the
+ * controller aims for ramps towards this at a limited acceleration.
+ *
+ * @param targetSpeed The target speed in millimeters per second, positive
+ * when driving forwards.
+ */
+void SpeedController::setTargetSpeed(float targetSpeed) {
+    this->_targetSpeed = targetSpeed;
+}
+
+/**
+ * @brief Gets the speed that the wheel is set to be driven at.
+ *
+ * @return (float) The target speed in millimeters per second.
+ */
+float SpeedController::getTargetSpeed() { return this->_targetSpeed; }
+
+/**
+ * @brief Gets the speed that the controller is currently aiming for, the
+ * target speed after the acceleration limit has been applied.
+ *
+ * @return (float) The ramped speed in millimeters per second.
+ */
+float SpeedController::getRampedSpeed() { return this->_rampedSpeed; }
+
+/**
+ * @brief Updates the power of the motor, at a fixed rate.
+ */
+void SpeedController::poll() {
+    if (!this->_pollSchedule.isReadyToRun()) {
+        return;
+    }
+
+    uint32_t currentTime = micros();
+    float timeStep = (currentTime - this->_lastPollTime) / 1000000.0f;
+    this->_lastPollTime = currentTime;
+
+    timeStep = min(timeStep, MAX_TIME_STEP);
+
+    // Limit how quickly the speed being aimed for can change, so that the
+    // wheels don't slip when starting and stopping.
+    float maxSpeedChange = MAX_WHEEL_ACCELERATION * timeStep;
+    this->_rampedSpeed += constrain(this->_targetSpeed - this->_rampedSpeed,
+                                    -maxSpeedChange, maxSpeedChange);
+
+    // Once the wheel has been ramped down to a stop, let the motor rest rather
+    // than holding it in place.
+    if ((this->_targetSpeed == 0) && (this->_rampedSpeed == 0)) {
+        this->_integral = 0;
+        this->_motor_P->stop();
+        return;
+    }
+
+    float error = this->_rampedSpeed - this->_motor_P->getVelocity();
+
+    float baseOutput = this->_feedforward(this->_rampedSpeed) +
+                       (SPEED_PROPORTIONAL_GAIN * error);
+
+    float newIntegral =
+        this->_integral + (SPEED_INTEGRAL_GAIN * error * timeStep);
+
+    float output = baseOutput + newIntegral;
+
+    // Only keep integrating while the motor isn't saturated, or if the error
+    // would pull it back out of saturation, so that the integral doesn't wind
+    // up while the motor can't go any faster.
+    bool saturatedHigh = (output > MAX_POWER) && (error > 0);
+    bool saturatedLow = (output < -MAX_POWER) && (error < 0);
+
+    if (!(saturatedHigh || saturatedLow)) {
+        this->_integral = newIntegral;
+    }
+
+    output = constrain(baseOutput + this->_integral, -MAX_POWER, MAX_POWER);
+
+    this->_motor_P->setVelocity(round(output));
+}
+
+/**
+ * @brief Clears the state of the controller, so that it starts afresh
+ * from a standstill.
+ */
+void SpeedController::reset() {
+    this->_targetSpeed = 0;
+    this->_rampedSpeed = 0;
+    this->_integral = 0;
+    this->_lastPollTime = micros();
+}
+
+/**
+ * @brief Calculates the power that the motor would need to hold a given
+ * speed on a flat surface, from the approximate response of the motor.
+ *
+ * @param speed The speed in millimeters per second.
+ * @return (float) The power as a bipolar percentage.
+ */
+float SpeedController::_feedforward(float speed) {
+    if (speed == 0) {
+        return 0;
+    }
+
+    // The static power is always applied in the direction of travel, which
+    // also keeps the output above the motor's dead zone.
+    float staticPower =
+        (speed > 0) ? FEEDFORWARD_STATIC_POWER : -FEEDFORWARD_STATIC_POWER;
+
+    return staticPower + (FEEDFORWARD_POWER_PER_SPEED * speed);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file speedController.h
+ * @brief Declaration of the SpeedController class, responsible for driving a
+ * single wheel at a set speed, using the speed measured by its encoder.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-06
+ * @copyright Copyright (c) 2024
+ */
+#ifndef SPEED_CONTROLLER_H
+#define SPEED_CONTROLLER_H
+
+#include <Arduino.h>
+
+#include "schedule.h"
+
+// The approximate response of the motors, the power needed to overcome
+// friction, and the extra power needed per millimeter per second.
+#define FEEDFORWARD_STATIC_POWER 10
+#define FEEDFORWARD_POWER_PER_SPEED 0.18f
+
+// The limit of the motor's power as a bipolar percentage.
+#define MAX_POWER 100
+
+// The fastest speed in millimeters per second that a wheel can be held at,
+// where the feedforward alone reaches full power, about 500.
+#define MAX_WHEEL_SPEED \
+    ((MAX_POWER - FEEDFORWARD_STATIC_POWER) / FEEDFORWARD_POWER_PER_SPEED)
+
+// Forward declaration of the Motor class.
+class Motor;
+
+/**
+ * @brief SpeedController class, a PI controller with feedforward that sets
+ * the power of a motor to hold its wheel at a target speed.
+ */
+class SpeedController {
+   public:
+    /**
+     * @brief Construct a new SpeedController object.
+     *
+     * @param motor_P Pointer to the motor to control.
+     */
+    SpeedController(Motor* motor_P);
+
+    /**
+     * @brief Sets the speed for the wheel to be driven at. The speed the
+     * controller aims for ramps towards this at a limited acceleration.
+     *
+     * @param targetSpeed The target speed in millimeters per second, positive
+     * when driving forwards.
+     */
+    void setTargetSpeed(float targetSpeed);
+
+    /**
+     * @brief Gets the speed that the wheel is set to be driven at.
+     *
+     * @return (float) The target speed in millimeters per second.
+     */
+    float getTargetSpeed();
+
+    /**
+     * @brief Gets the speed that the controller is currently aiming for, the
+     * target speed after the acceleration limit has been applied.
+     *
+     * @return (float) The ramped speed in millimeters per second.
+     */
+    float getRampedSpeed();
+
+    /**
+     * @brief Updates the power of the motor, at a fixed rate.
+     */
+    void poll();
+
+    /**
+     * @brief Clears the state of the controller, so that it starts afresh
+     * from a standstill.
+     */
+    void reset();
+
+   private:
+    /**
+     * @brief Calculates the power that the motor would need to hold a given
+     * speed on a flat surface, from the approximate response of the motor.
+     *
+     * @param speed The speed in millimeters per second.
+     * @return (float) The power as a bipolar percentage.
+     */
+    float _feedforward(float speed);
+
+    /**
+     * @brief Pointer to the motor to control.
+     */
+    Motor* _motor_P;
+
+    /**
+     * @brief The speed for the wheel to be driven at in millimeters per
+     * second.
+     */
+    float _targetSpeed = 0;
+
+    /**
+     * @brief The speed that the controller is currently aiming for, which
+     * ramps towards the target speed at a limited acceleration.
+     */
+    float _rampedSpeed = 0;
+
+    /**
+     * @brief The accumulated integral term, as a bipolar percentage of the
+     * motor's power.
+     */
+    float _integral = 0;
+
+    /**
+     * @brief The time in microseconds of the last update.
+     */
+    uint32_t _lastPollTime = 0;
+
+    /**
+     * @brief The schedule that sets the rate of the controller.
+     */
+    PassiveSchedule _pollSchedule;
+};
+
+#endif  // SPEED_CONTROLLER_H
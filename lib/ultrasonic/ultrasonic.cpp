@@ -130,6 +130,27 @@ int Ultrasonic::readFromRobotCenter() {
     return totalDistance;
 }
 
+/**
+ * @brief Gets the age of the most recent reading from the sensor.
+ *
+ * @return (uint32_t) The time in milliseconds since the echo pin last fell,
+ * completing a reading.
+ */
+uint32_t Ultrasonic::getAge() {
+    return (micros() - this->_echoPinDownTimeMicros) / 1000;
+}
+
+/**
+ * @brief Gets the time of the most recent reading from the sensor, which only
+ * changes when a new reading is taken.
+ *
+ * @return (uint32_t) The time in milliseconds that the echo pin last fell,
+ * completing a reading.
+ */
+uint32_t Ultrasonic::getReadingTime() {
+    return this->_echoPinDownTimeMicros / 1000;
+}
+
 /**
  * @brief The interrupt service routine that is called the echo pin changes
  * state.
@@ -99,6 +99,23 @@ class Ultrasonic {
      */
     int readFromRobotCenter();
 
+    /**
+     * @brief Gets the age of the most recent reading from the sensor.
+     *
+     * @return (uint32_t) The time in milliseconds since the echo pin last
+     * fell, completing a reading.
+     */
+    uint32_t getAge();
+
+    /**
+     * @brief Gets the time of the most recent reading from the sensor, which
+     * only changes when a new reading is taken.
+     *
+     * @return (uint32_t) The time in milliseconds that the echo pin last
+     * fell, completing a reading.
+     */
+    uint32_t getReadingTime();
+
     /**
      * @brief The interrupt service routine that is called the echo pin
      * changes state.
@@ -0,0 +1,171 @@
+/**
+ * @file velocityPlanner.cpp
+ * @brief Definition of the VelocityPlanner class, responsible for planning
+ * the fastest speed to drive at along each point of a path.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-17
+ * @copyright Copyright (c) 2024
+ */
+#include "velocityPlanner.h"
+
+#include "pathLimits.h"
+
+// The number of waypoints either side of a waypoint used to measure the
+// curvature, so that the steps between orthogonal and diagonal directions in
+// a path taken from the map average out.
+#define CURVATURE_WINDOW 3
+
+/**
+ * @brief Construct a new VelocityPlanner object.
+ *
+ * @param maxSpeed The fastest speed to plan, in millimeters per second.
+ */
+VelocityPlanner::VelocityPlanner(int maxSpeed) : _maxSpeed(maxSpeed) {}
+
+/**
+ * @brief Plans the speed profile along a path, replacing any previous plan.
+ *
+ * @param path The waypoints of the path, the robot starts stopped at the first
+ * and stops at the last.
+ * @param speedLimits The fastest speed in millimeters per second to drive at
+ * each waypoint, or -1 for no limit. If it is empty, only the maximum speed is
+ * used.
+ * @return (float) The time in seconds to drive the path.
+ */
+float VelocityPlanner::plan(std::vector<Position> path,
+                            std::vector<int> speedLimits) {
+    size_t pointCount = path.size();
+
+    this->_speeds.assign(pointCount, this->_maxSpeed);
+    this->_times.assign(pointCount, 0);
+
+    if (pointCount < 2) {
+        return 0;
+    }
+
+    // Limit the speed at each waypoint by how sharply the path curves there,
+    // using v^2 = a * r.
+    for (size_t i = 0; i < pointCount; i++) {
+        float curvature = this->_curvatureAt(path, i);
+
+        if (curvature > 0) {
+            float curveSpeed = sqrtf(PATH_LATERAL_ACCELERATION / curvature);
+            this->_speeds[i] = min(this->_speeds[i], curveSpeed);
+        }
+
+        if ((i < speedLimits.size()) && (speedLimits[i] != -1)) {
+            this->_speeds[i] = min(this->_speeds[i], (float)speedLimits[i]);
+        }
+    }
+
+    // The robot starts and ends the path stopped.
+    this->_speeds.front() = 0;
+    this->_speeds.back() = 0;
+
+    // Forwards pass, each speed can be no more than the speed the robot can
+    // accelerate up to from the waypoint before, using v^2 = u^2 + 2as.
+    for (size_t i = 1; i < pointCount; i++) {
+        float segmentLength = path[i - 1].distanceTo(path[i]);
+        float previousSpeed = this->_speeds[i - 1];
+
+        float reachableSpeed =
+            sqrtf(previousSpeed * previousSpeed +
+                  2 * PATH_ACCELERATION * segmentLength);
+
+        this->_speeds[i] = min(this->_speeds[i], reachableSpeed);
+    }
+
+    // Backwards pass, each speed can be no more than the speed the robot can
+    // brake down from to the speed of the waypoint after.
+    for (size_t i = pointCount - 1; i > 0; i--) {
+        float segmentLength = path[i - 1].distanceTo(path[i]);
+        float nextSpeed = this->_speeds[i];
+
+        float stoppableSpeed = sqrtf(nextSpeed * nextSpeed +
+                                     2 * PATH_ACCELERATION * segmentLength);
+
+        this->_speeds[i - 1] = min(this->_speeds[i - 1], stoppableSpeed);
+    }
+
+    // With a constant acceleration between waypoints, each segment is driven
+    // at the average of the speeds at either end of it.
+    for (size_t i = 1; i < pointCount; i++) {
+        float segmentLength = path[i - 1].distanceTo(path[i]);
+        float averageSpeed = (this->_speeds[i - 1] + this->_speeds[i]) / 2;
+        // Where both ends are stopped, the path tracker still creeps along at
+        // its slowest speed.
+        averageSpeed = max(averageSpeed, (float)PATH_MIN_SPEED);
+
+        this->_times[i] = this->_times[i - 1] + segmentLength / averageSpeed;
+    }
+
+    return this->_times.back();
+}
+
+/**
+ * @brief Gets the planned speed at each waypoint.
+ *
+ * @return (std::vector<float>) The speeds in millimeters per second.
+ */
+std::vector<float> VelocityPlanner::getSpeeds() { return this->_speeds; }
+
+/**
+ * @brief Gets the planned time to reach each waypoint from the start.
+ *
+ * @return (std::vector<float>) The times in seconds.
+ */
+std::vector<float> VelocityPlanner::getTimes() { return this->_times; }
+
+/**
+ * @brief Gets the planned time to drive the whole path.
+ *
+ * @return (float) The time in seconds, 0 if there is no plan.
+ */
+float VelocityPlanner::getTotalTime() {
+    if (this->_times.empty()) {
+        return 0;
+    }
+    return this->_times.back();
+}
+
+/**
+ * @brief Finds how sharply the path curves at a waypoint, from the circle
+ * through it and the waypoints CURVATURE_WINDOW either side of it.
+ *
+ * @param path The waypoints of the path.
+ * @param index The index of the waypoint.
+ * @return (float) The curvature in 1 / millimeters, 0 if the path is
+ * straight.
+ */
+float VelocityPlanner::_curvatureAt(std::vector<Position>& path,
+                                    size_t index) {
+    size_t lastIndex = path.size() - 1;
+
+    // Near the ends of the path, use as many waypoints as there are.
+    size_t window = min(index, lastIndex - index);
+    window = min(window, (size_t)CURVATURE_WINDOW);
+
+    if (window == 0) {
+        return 0;
+    }
+
+    Position before = path[index - window];
+    Position middle = path[index];
+    Position after = path[index + window];
+
+    float sideA = before.distanceTo(middle);
+    float sideB = middle.distanceTo(after);
+    float sideC = before.distanceTo(after);
+
+    if ((sideA == 0) || (sideB == 0) || (sideC == 0)) {
+        return 0;
+    }
+
+    // The curvature of the circle through three points is 4 times the area of
+    // the triangle they make, over the product of its sides.
+    float crossProduct = (middle.x - before.x) * (after.y - before.y) -
+                         (middle.y - before.y) * (after.x - before.x);
+
+    return 2 * abs(crossProduct) / (sideA * sideB * sideC);
+}
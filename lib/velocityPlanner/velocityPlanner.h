@@ -0,0 +1,101 @@
+/**
+ * @file velocityPlanner.h
+ * @brief Declaration of the VelocityPlanner class, responsible for planning
+ * the fastest speed to drive at along each point of a path.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-17
+ * @copyright Copyright (c) 2024
+ */
+#ifndef VELOCITY_PLANNER_H
+#define VELOCITY_PLANNER_H
+
+#include <Arduino.h>
+
+#include <vector>
+
+#include "angleAndPosition.h"
+
+/**
+ * @brief VelocityPlanner class, plans a minimum time speed profile along a
+ * path of waypoints, starting and ending at a stop.
+ *
+ * Each waypoint is first given the fastest speed allowed by how sharply the
+ * path curves there, and by any speed limit given for it. A forwards pass
+ * then limits each speed to what the robot can accelerate up to from the
+ * waypoint before, and a backwards pass to what it can brake down from to
+ * the waypoint after. The time to reach each waypoint follows from the
+ * speeds, assuming a constant acceleration between waypoints.
+ */
+class VelocityPlanner {
+   public:
+    /**
+     * @brief Construct a new VelocityPlanner object.
+     *
+     * @param maxSpeed The fastest speed to plan, in millimeters per second.
+     */
+    VelocityPlanner(int maxSpeed);
+
+    /**
+     * @brief Plans the speed profile along a path, replacing any previous
+     * plan.
+     *
+     * @param path The waypoints of the path, the robot starts stopped at the
+     * first and stops at the last.
+     * @param speedLimits The fastest speed in millimeters per second to drive
+     * at each waypoint, or -1 for no limit. If it is empty, only the maximum
+     * speed is used.
+     * @return (float) The time in seconds to drive the path.
+     */
+    float plan(std::vector<Position> path, std::vector<int> speedLimits);
+
+    /**
+     * @brief Gets the planned speed at each waypoint.
+     *
+     * @return (std::vector<float>) The speeds in millimeters per second.
+     */
+    std::vector<float> getSpeeds();
+
+    /**
+     * @brief Gets the planned time to reach each waypoint from the start.
+     *
+     * @return (std::vector<float>) The times in seconds.
+     */
+    std::vector<float> getTimes();
+
+    /**
+     * @brief Gets the planned time to drive the whole path.
+     *
+     * @return (float) The time in seconds, 0 if there is no plan.
+     */
+    float getTotalTime();
+
+   private:
+    /**
+     * @brief Finds how sharply the path curves at a waypoint, from the circle
+     * through it and the waypoints CURVATURE_WINDOW either side of it.
+     *
+     * @param path The waypoints of the path.
+     * @param index The index of the waypoint.
+     * @return (float) The curvature in 1 / millimeters, 0 if the path is
+     * straight.
+     */
+    float _curvatureAt(std::vector<Position>& path, size_t index);
+
+    /**
+     * @brief The fastest speed to plan, in millimeters per second.
+     */
+    int _maxSpeed;
+
+    /**
+     * @brief The planned speed at each waypoint, in millimeters per second.
+     */
+    std::vector<float> _speeds;
+
+    /**
+     * @brief The planned time to reach each waypoint, in seconds.
+     */
+    std::vector<float> _times;
+};
+
+#endif  // VELOCITY_PLANNER_H
@@ -0,0 +1,157 @@
+/**
+ * @file wallFollower.cpp
+ * @brief Definition of the WallFollower class, responsible for steering the
+ * robot to hold a set distance from the wall on its left.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-09
+ * @copyright Copyright (c) 2024
+ */
+#include "wallFollower.h"
+
+#include "angleAndPosition.h"
+#include "drive.h"
+#include "infrared.h"
+#include "motionTracker.h"
+
+// The gains of the controller, in degrees per second of rotation per
+// millimeter of distance error, and per millimeter per second of rate.
+#define WALL_PROPORTIONAL_GAIN 0.6f
+#define WALL_DERIVATIVE_GAIN 0.5f
+
+// How much of the rate of change is taken from the infrared sensor, the rest
+// is taken from the heading of the robot relative to the wall.
+#define INFRARED_RATE_WEIGHT 0.3f
+
+// The furthest the wall can be in millimeters before it is treated as a gap.
+#define MAX_WALL_DISTANCE 250
+
+// A jump in distance between readings bigger than this, in millimeters, is
+// treated as the edge of a gap rather than the robot moving.
+#define MAX_DISTANCE_JUMP 40
+
+// The largest angle in degrees that the robot will turn away from parallel to
+// the wall, so that it never drives straight into it.
+#define MAX_WALL_ANGLE 20
+
+// The fastest the controller will turn the robot in degrees per second.
+#define MAX_WALL_TURN_SPEED 90
+
+/**
+ * @brief Construct a new WallFollower object.
+ *
+ * @param leftInfrared_P Pointer to the left infrared sensor.
+ * @param motionTracker_P Pointer to the motion tracker, used to get the
+ * heading of the robot relative to the wall.
+ * @param targetDistance The distance in millimeters to hold between the
+ * centre of the robot and the wall.
+ * @param speed The speed in millimeters per second that the robot drives
+ * at while following the wall.
+ */
+WallFollower::WallFollower(Infrared* leftInfrared_P,
+                           MotionTracker* motionTracker_P, int targetDistance,
+                           int speed)
+    : _leftInfrared_P(leftInfrared_P),
+      _motionTracker_P(motionTracker_P),
+      _targetDistance(targetDistance),
+      _speed(speed) {}
+
+/**
+ * @brief Calculates the rotational speed needed to hold the robot at the
+ * target distance from the wall.
+ *
+ * If the wall can't be seen, such as across the gap at a corner, this
+ * falls back to only holding the robot parallel to the closest right
+ * angle.
+ *
+ * @return (int) The rotational speed in degrees per second, positive
+ * to turn counter-clockwise towards the wall.
+ */
+int WallFollower::getRotationalSpeed() {
+    Angle robotAngle = this->_motionTracker_P->getAngle();
+
+    // How far the robot is turned counter-clockwise from parallel to the
+    // wall, towards it.
+    float angleToWall = -robotAngle.OrthogonalOffset().getDegrees();
+
+    // The rotational speed to straighten up with the wall, used when the wall
+    // can't be seen.
+    int headingCorrection = -angleToWall * HEADING_CORRECTION_GAIN;
+
+    // Only work out the rate from the infrared sensor when it has a new
+    // reading.
+    uint32_t readingAge = this->_leftInfrared_P->getAge();
+    bool newReading = readingAge < this->_lastReadingAge;
+    this->_lastReadingAge = readingAge;
+
+    int distance = this->_leftInfrared_P->readFromRobotCenter();
+
+    bool wallVisible = (distance != -1) && (distance < MAX_WALL_DISTANCE);
+
+    if (!wallVisible) {
+        this->reset();
+        return headingCorrection;
+    }
+
+    if (newReading) {
+        uint32_t currentTime = millis();
+
+        if (this->_lastDistance != -1) {
+            int distanceChange = distance - this->_lastDistance;
+
+            // A sudden jump means that the sensor has moved onto a different
+            // wall, so there is no useful rate, and the new wall is followed
+            // from here on.
+            if (abs(distanceChange) > MAX_DISTANCE_JUMP) {
+                this->_infraredRate = 0;
+            } else {
+                float timeChange =
+                    (currentTime - this->_lastDistanceTime) / 1000.0f;
+
+                if (timeChange > 0) {
+                    this->_infraredRate = distanceChange / timeChange;
+                }
+            }
+        }
+
+        this->_lastDistance = distance;
+        this->_lastDistanceTime = currentTime;
+    }
+
+    // Driving at an angle towards the wall closes the distance at
+    // speed * sin(angle), which is much less noisy than differentiating the
+    // infrared readings.
+    float headingRate = -this->_speed * sinf(angleToWall * RADIANS_PER_DEGREE);
+
+    float rate = (INFRARED_RATE_WEIGHT * this->_infraredRate) +
+                 ((1 - INFRARED_RATE_WEIGHT) * headingRate);
+
+    // A positive error means that the robot is too far from the wall, and
+    // needs to turn towards it.
+    int error = distance - this->_targetDistance;
+
+    float rotationalSpeed =
+        (WALL_PROPORTIONAL_GAIN * error) + (WALL_DERIVATIVE_GAIN * rate);
+
+    // Don't turn any further once the robot is at the largest angle to the
+    // wall.
+    if ((angleToWall >= MAX_WALL_ANGLE) && (rotationalSpeed > 0)) {
+        rotationalSpeed = 0;
+    } else if ((angleToWall <= -MAX_WALL_ANGLE) && (rotationalSpeed < 0)) {
+        rotationalSpeed = 0;
+    }
+
+    rotationalSpeed =
+        constrain(rotationalSpeed, -MAX_WALL_TURN_SPEED, MAX_WALL_TURN_SPEED);
+
+    return round(rotationalSpeed);
+}
+
+/**
+ * @brief Clears the history of the controller, this should be called
+ * whenever the robot starts following a new wall.
+ */
+void WallFollower::reset() {
+    this->_lastDistance = -1;
+    this->_infraredRate = 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file wallFollower.h
+ * @brief Declaration of the WallFollower class, responsible for steering the
+ * robot to hold a set distance from the wall on its left.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-09
+ * @copyright Copyright (c) 2024
+ */
+#ifndef WALL_FOLLOWER_H
+#define WALL_FOLLOWER_H
+
+#include <Arduino.h>
+
+// Forward declaration of the Infrared and MotionTracker classes.
+class Infrared;
+class MotionTracker;
+
+/**
+ * @brief WallFollower class, a PD controller on the distance to the left
+ * wall, where the rate of change of the distance is fused from the infrared
+ * sensor and the robot's heading relative to the wall.
+ */
+class WallFollower {
+   public:
+    /**
+     * @brief Construct a new WallFollower object.
+     *
+     * @param leftInfrared_P Pointer to the left infrared sensor.
+     * @param motionTracker_P Pointer to the motion tracker, used to get the
+     * heading of the robot relative to the wall.
+     * @param targetDistance The distance in millimeters to hold between the
+     * centre of the robot and the wall.
+     * @param speed The speed in millimeters per second that the robot drives
+     * at while following the wall.
+     */
+    WallFollower(Infrared* leftInfrared_P, MotionTracker* motionTracker_P,
+                 int targetDistance, int speed);
+
+    /**
+     * @brief Calculates the rotational speed needed to hold the robot at the
+     * target distance from the wall.
+     *
+     * If the wall can't be seen, such as across the gap at a corner, this
+     * falls back to only holding the robot parallel to the closest right
+     * angle.
+     *
+     * @return (int) The rotational speed in degrees per second, positive
+     * to turn counter-clockwise towards the wall.
+     */
+    int getRotationalSpeed();
+
+    /**
+     * @brief Clears the history of the controller, this should be called
+     * whenever the robot starts following a new wall.
+     */
+    void reset();
+
+   private:
+    /**
+     * @brief Pointer to the left infrared sensor.
+     */
+    Infrared* _leftInfrared_P;
+
+    /**
+     * @brief Pointer to the motion tracker.
+     */
+    MotionTracker* _motionTracker_P;
+
+    /**
+     * @brief The distance in millimeters to hold from the wall.
+     */
+    int _targetDistance;
+
+    /**
+     * @brief The speed in millimeters per second that the robot drives at.
+     */
+    int _speed;
+
+    /**
+     * @brief The last valid distance read from the wall, or -1 if the wall
+     * hasn't been seen since the last reset.
+     */
+    int _lastDistance = -1;
+
+    /**
+     * @brief The time in milliseconds of the last valid distance.
+     */
+    uint32_t _lastDistanceTime = 0;
+
+    /**
+     * @brief The age of the infrared reading at the last call, used to tell
+     * when there is a new reading.
+     */
+    uint32_t _lastReadingAge = UINT32_MAX;
+
+    /**
+     * @brief The last rate of change in the distance to the wall measured by
+     * the infrared sensor, in millimeters per second.
+     */
+    float _infraredRate = 0;
+};
+
+#endif  // WALL_FOLLOWER_H
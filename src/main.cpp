@@ -26,27 +26,40 @@
 
 // https://www.arduino.cc/reference/en/
 #include <Arduino.h>
-#include <NESControllerInterface.h>
 
 #include "angleAndPosition.h"
 #include "binary.h"
 #include "bluetoothLowEnergy.h"
+#include "brakingGovernor.h"
 #include "brick.h"
 #include "bumper.h"
+#include "driftObserver.h"
 #include "drive.h"
+#include "dynamicWindow.h"
 #include "errorIndicator.h"
+#include "frontRange.h"
 #include "history.h"
 #include "infrared.h"
 #include "infrared_Test.h"
+#include "lsm9ds1Imu.h"
 #include "map.h"
 #include "mazeConstants.h"
+#include "motionMonitor.h"
 #include "motionTracker.h"
 #include "motor.h"
 #include "navigator.h"
+#include "nesController.h"
+#include "odometryCalibrator.h"
+#include "particleFilter.h"
+#include "pathLimits.h"
 #include "pixels.h"
+#include "poseEstimator.h"
 #include "schedule.h"
+#include "shiftRegisterBus.h"
 #include "systemInfo.h"
 #include "ultrasonic.h"
+#include "velocityPlanner.h"
+#include "wallFollower.h"
 
 // ███████╗██╗      █████╗  ██████╗ ███████╗
 // ██╔════╝██║     ██╔══██╗██╔════╝ ██╔════╝
@@ -70,9 +83,25 @@
 // connection before starting.
 #define WAIT_UPON_START false
 
+// If true, the robot will calibrate its odometry before starting, and print the
+// results. The robot must start square on to a wall about 150mm in front of
+// it, with at least 400mm of space behind it.
+#define RUN_CALIBRATION false
+
 // If true, the robot will continue to lap the maze until the user stops it.
 #define DEMO_MODE true
 
+// If true, the robot will follow a trajectory planned along the solved maze
+// with the navigator. Without a trajectory, either because this is false or
+// because no path could be extracted from where the robot is, it falls back
+// to the driving chosen below.
+#define FOLLOW_TRAJECTORY true
+
+// If true, the robot will use the dynamic window planner to follow the maze
+// when it has no trajectory, rather than driving in the direction of the map
+// cell it is on.
+#define USE_DYNAMIC_WINDOW true
+
 //   ██████╗ ██████╗      ██╗███████╗ ██████╗████████╗███████╗
 //  ██╔═══██╗██╔══██╗     ██║██╔════╝██╔════╝╚══██╔══╝██╔════╝
 //  ██║   ██║██████╔╝     ██║█████╗  ██║        ██║   ███████╗
@@ -88,7 +117,7 @@ Motor rightMotor(RIGHT_MOTOR_DIRECTION_PIN, RIGHT_MOTOR_SPEED_PIN,
                  RIGHT_MOTOR_ENCODER_A_PIN, RIGHT_MOTOR_ENCODER_B_PIN,
                  RIGHT_MOTOR_ROTATION_INVERTED);
 
-Drive drive(&leftMotor, &rightMotor, DEFAULT_DRIVE_SPEED);
+Drive drive(&leftMotor, &rightMotor, DEFAULT_DRIVE_SPEED, DEFAULT_TURN_SPEED);
 
 Pixels pixels(PIXELS_DATA_PIN, LED_COUNT, LED_ROTATION_OFFSET);
 Ultrasonic ultrasonic(ULTRASONIC_TRIGGER, ULTRASONIC_ECHO,
@@ -103,22 +132,58 @@ Infrared frontRightInfrared(FRONT_RIGHT_INFRARED_INDEX,
                             FRONT_RIGHT_INFRARED_FORWARD_DISTANCE);
 Infrared rightInfrared(RIGHT_INFRARED_INDEX, RIGHT_INFRARED_FORWARD_DISTANCE);
 
-Bumper bumper(BUMPER_SHIFT_REG_DATA, COMMON_SHIFT_REG_LOAD,
-              COMMON_SHIFT_REG_CLOCK, BUMPER_BIT_OFFSET);
+ShiftRegisterBus shiftRegisterBus(BUMPER_SHIFT_REG_DATA, NES_SHIFT_REG_DATA,
+                                  COMMON_SHIFT_REG_LOAD,
+                                  COMMON_SHIFT_REG_CLOCK);
+
+Bumper bumper(&shiftRegisterBus, BUMPER_BIT_OFFSET);
+
+NESController nes(&shiftRegisterBus);
 
 BluetoothLowEnergy bluetoothLowEnergy(MAIN_SERVICE_UUID, ROBOT_POSE_UUID,
                                       BRICK_UUID);
 
-MotionTracker motionTracker(&leftMotor, &rightMotor, INITIAL_ANGLE);
+Lsm9ds1Imu imu(IMU_YAW_INVERTED);
+
+MotionTracker motionTracker(&leftMotor, &rightMotor, INITIAL_ANGLE,
+                            MOTION_TRACKER_POLL_RATE, &imu);
+
+Navigator navigator(&motionTracker, &drive, DEFAULT_DRIVE_SPEED,
+                    DEFAULT_TURN_SPEED);
 
-Navigator navigator(&motionTracker, &drive);
+FrontRange frontRange(&ultrasonic, &frontLeftInfrared, &frontRightInfrared,
+                      &motionTracker, FRONT_INFRARED_SEPARATION);
+
+BrakingGovernor brakingGovernor(&frontRange, &drive, &leftMotor, &rightMotor,
+                                WALL_STOP_DISTANCE);
+
+WallFollower wallFollower(&leftInfrared, &motionTracker, WALL_FOLLOW_DISTANCE,
+                          DEFAULT_DRIVE_SPEED);
 
 BrickList brickList;
 
+DriftObserver driftObserver(&motionTracker, &frontRange, &brickList);
+
+OdometryCalibrator odometryCalibrator(&leftMotor, &rightMotor, &drive,
+                                      &motionTracker, &frontRange);
+
+MotionMonitor motionMonitor(&drive, &leftMotor, &rightMotor, &frontLeftInfrared,
+                            &frontRightInfrared, &motionTracker);
+
+PoseEstimator poseEstimator(&brickList);
+
+// Once the BrickList is complete, the particle filter takes over from the pose
+// estimator, as it can recover from the larger errors that build up when
+// driving through the maze without stopping at walls.
+ParticleFilter particleFilter(&brickList);
+bool localisingWithParticles_G = false;
+
 Map gridMap;
 
-NESControllerInterface nes(NES_SHIFT_REG_DATA, COMMON_SHIFT_REG_LOAD,
-                           COMMON_SHIFT_REG_CLOCK);
+DynamicWindow dynamicWindow(&motionTracker, &drive, &gridMap,
+                            DEFAULT_DRIVE_SPEED, DEFAULT_TURN_SPEED);
+
+VelocityPlanner velocityPlanner(PATH_MAX_SPEED);
 
 /**
  * @brief A test loop to run instead of loop() if the RUN_TEST_LOOP define is
@@ -126,6 +191,11 @@ NESControllerInterface nes(NES_SHIFT_REG_DATA, COMMON_SHIFT_REG_LOAD,
  */
 void testLoop();
 
+/**
+ * @brief Polls the various classes that need to be polled.
+ */
+void polls();
+
 /**
  * @brief Am instance of the PassiveSchedule class, that can trigger a function
  * once per second.
@@ -255,16 +325,33 @@ void setup() {
 
     pixels.setup();
 
+    // The gyroscope is fused with the wheels for the heading, without it the
+    // motion tracker falls back to the wheels alone.
+    if (!imu.setup()) {
+        Serial.println("IMU not found, using odometry for heading");
+    }
+
     leftInfrared.setup();
     rightInfrared.setup();
     frontLeftInfrared.setup();
     frontRightInfrared.setup();
 
+    // The side sensors look across the maze, so switch to long range when
+    // there is nothing close by. The front sensors are used for aligning with
+    // walls, so stay in the more precise short range.
+    leftInfrared.setRange(AutoRange);
+    rightInfrared.setRange(AutoRange);
+    frontLeftInfrared.setRange(ShortRange);
+    frontRightInfrared.setRange(ShortRange);
+
     ultrasonic.setup([]() { ultrasonic.isr(); });
 
     // Initialise the bluetooth connection.
     bluetoothLowEnergy.setup(BLE_DEVICE_NAME, BLE_MAC_ADDRESS);
 
+    // The robot starts in a known place, so begin fairly certain of its pose.
+    poseEstimator.reset(motionTracker.getPose(), 10, 1);
+
 #if RUN_TEST_LOOP
     while (true) {
         testLoop();
@@ -285,24 +372,265 @@ void setup() {
 
 #if WAIT_UPON_START
     while (!(bluetoothLowEnergy.isConnected() || (bool)bumper.read())) {
+        shiftRegisterBus.poll();
         bluetoothLowEnergy.poll();
     }
 #endif  // WAIT_UPON_START
+
+#if RUN_CALIBRATION
+    if (odometryCalibrator.run(polls)) {
+        float leftStepsPerMillimeter =
+            odometryCalibrator.getLeftStepsPerMillimeter();
+        float rightStepsPerMillimeter =
+            odometryCalibrator.getRightStepsPerMillimeter();
+        float wheelDifferencePerRotation =
+            odometryCalibrator.getWheelDifferencePerRotation();
+
+        motionTracker.setOdometryCalibration(leftStepsPerMillimeter,
+                                             rightStepsPerMillimeter,
+                                             wheelDifferencePerRotation);
+        drive.setWheelDifferencePerRotation(wheelDifferencePerRotation);
+
+        Serial.print("Left steps per mm: ");
+        Serial.println(leftStepsPerMillimeter, 4);
+        Serial.print("Right steps per mm: ");
+        Serial.println(rightStepsPerMillimeter, 4);
+        Serial.print("Wheel difference per rotation: ");
+        Serial.println(wheelDifferencePerRotation, 2);
+    } else {
+        Serial.println("Odometry calibration failed, using the defaults");
+    }
+#endif  // RUN_CALIBRATION
+}
+
+/**
+ * @brief An infrared sensor used to correct the pose, with its position across
+ * the robot and the direction that it points.
+ *
+ * The readings are taken from the centre of the robot, so each sensor is
+ * placed on the robot's centre line, only offset to the side.
+ */
+struct RangeSensor {
+    Infrared* infrared_P;
+    Position offset;
+    Angle angle;
+    uint32_t lastAge;
+    uint32_t lastWeighedTime;
+};
+
+RangeSensor rangeSensors[] = {
+    {&frontLeftInfrared, Position(-FRONT_INFRARED_SEPARATION / 2, 0), 0,
+     UINT32_MAX, 0},
+    {&frontRightInfrared, Position(FRONT_INFRARED_SEPARATION / 2, 0), 0,
+     UINT32_MAX, 0},
+    {&leftInfrared, Position(0, 0), 90, UINT32_MAX, 0},
+    {&rightInfrared, Position(0, 0), -90, UINT32_MAX, 0},
+};
+
+// The number of infrared sensors used to correct the pose.
+#define RANGE_SENSOR_COUNT 4
+
+// The standard deviation of the ultrasonic sensor, in millimeters.
+#define ULTRASONIC_DEVIATION 15
+
+// The standard deviation of the position along each axis measured by a loop
+// closure, in millimeters, which is about how well the Brick that was seen
+// again was placed.
+#define LOOP_CLOSURE_DEVIATION 20
+
+/**
+ * @brief Calculates the standard deviation of an infrared reading, as the
+ * noise of the sensor increases with distance.
+ *
+ * @param distance The distance read by the sensor.
+ * @return (float) The standard deviation of the reading in millimeters.
+ */
+float infraredDeviation(int distance) {
+    // The standard deviation at point blank, and how much it grows per
+    // millimeter of distance.
+    const float baseDeviation = 3;
+    const float deviationPerMillimeter = 0.02;
+
+    return baseDeviation + (deviationPerMillimeter * distance);
+}
+
+/**
+ * @brief Feeds the odometry and any new range readings into the pose
+ * estimator, and applies its corrections to the motion tracker.
+ */
+void updatePoseEstimate() {
+    poseEstimator.predict(motionTracker.getPose());
+
+    Pose correction;
+
+    // A sensor has taken a new reading if its age has dropped since the last
+    // update.
+    for (RangeSensor& sensor : rangeSensors) {
+        uint32_t age = sensor.infrared_P->getAge();
+        bool isNewReading = age < sensor.lastAge;
+        sensor.lastAge = age;
+
+        if (!isNewReading) {
+            continue;
+        }
+
+        int distance = sensor.infrared_P->readFromRobotCenter();
+        float deviation = infraredDeviation(distance);
+
+        if (poseEstimator.update(motionTracker.getPose(), sensor.offset,
+                                 sensor.angle, distance, deviation * deviation,
+                                 &correction)) {
+            motionTracker.applyPositionCorrection(correction.position);
+            motionTracker.applyAngleCorrection(correction.angle);
+        }
+    }
+
+    static uint32_t lastUltrasonicAge = UINT32_MAX;
+
+    uint32_t ultrasonicAge = ultrasonic.getAge();
+    if (ultrasonicAge < lastUltrasonicAge) {
+        int distance = ultrasonic.readFromRobotCenter();
+        float variance = ULTRASONIC_DEVIATION * ULTRASONIC_DEVIATION;
+
+        if (poseEstimator.update(motionTracker.getPose(), Position(0, 0), 0,
+                                 distance, variance, &correction)) {
+            motionTracker.applyPositionCorrection(correction.position);
+            motionTracker.applyAngleCorrection(correction.angle);
+        }
+    }
+    lastUltrasonicAge = ultrasonicAge;
+}
+
+/**
+ * @brief Moves the particle filter along with the odometry, weighs it with the
+ * range sensors, and applies its corrections to the motion tracker.
+ *
+ * The particles are only weighed by one sensor per update, so that the ray
+ * casts for every particle are spread over several loops instead of blocking
+ * a single one.
+ */
+void updateParticleFilter() {
+    // Readings older than this, in milliseconds, are not used.
+    const uint32_t maxReadingAge = 100;
+
+    static PassiveSchedule particleSchedule(20);
+
+    if (!particleSchedule.isReadyToRun()) {
+        return;
+    }
+
+    particleFilter.predict(motionTracker.getPose());
+
+    // The infrared sensors take turns with the ultrasonic sensor, which is
+    // last in the rotation.
+    static int sensorIndex = 0;
+
+    // Each reading is only weighed once, as weighing the same reading again
+    // counts it as fresh evidence, and makes the particles overconfident
+    // whenever the robot is standing still.
+    static uint32_t lastWeighedUltrasonicTime = 0;
+
+    if (sensorIndex < RANGE_SENSOR_COUNT) {
+        RangeSensor& sensor = rangeSensors[sensorIndex];
+
+        uint32_t readingTime = sensor.infrared_P->getReadingTime();
+        bool isNewReading = readingTime != sensor.lastWeighedTime;
+
+        if (isNewReading && (sensor.infrared_P->getAge() < maxReadingAge)) {
+            int distance = sensor.infrared_P->readFromRobotCenter();
+
+            particleFilter.weigh(sensor.offset, sensor.angle, distance,
+                                 infraredDeviation(distance));
+
+            sensor.lastWeighedTime = readingTime;
+        }
+    } else {
+        uint32_t readingTime = ultrasonic.getReadingTime();
+        bool isNewReading = readingTime != lastWeighedUltrasonicTime;
+
+        if (isNewReading && (ultrasonic.getAge() < maxReadingAge)) {
+            particleFilter.weigh(Position(0, 0), 0,
+                                 ultrasonic.readFromRobotCenter(),
+                                 ULTRASONIC_DEVIATION);
+
+            lastWeighedUltrasonicTime = readingTime;
+        }
+    }
+
+    sensorIndex = (sensorIndex + 1) % (RANGE_SENSOR_COUNT + 1);
+
+    particleFilter.resampleIfNeeded();
+
+    Pose correction;
+    if (particleFilter.getCorrection(motionTracker.getPose(), &correction)) {
+        motionTracker.applyPositionCorrection(correction.position);
+        motionTracker.applyAngleCorrection(correction.angle);
+    }
+}
+
+/**
+ * @brief Starts localising with the particle filter instead of the pose
+ * estimator, spreading the particles by how uncertain the pose currently is.
+ */
+void startParticleFilter() {
+    // The particles are spread at least this far, in millimeters and degrees,
+    // so that they cover the true pose even if the estimator is overconfident.
+    const float minPositionDeviation = 20;
+    const float minAngleDeviation = 2;
+
+    particleFilter.reset(
+        motionTracker.getPose(),
+        max(poseEstimator.getPositionDeviation(), minPositionDeviation),
+        max(poseEstimator.getAngleDeviation(), minAngleDeviation));
+
+    localisingWithParticles_G = true;
 }
 
 /**
  * @brief Polls the various classes that need to be polled.
  */
 void polls() {
-    frontLeftInfrared.poll();
-    frontRightInfrared.poll();
-    leftInfrared.poll();
-    rightInfrared.poll();
+    // The infrared sensors are given the distance traveled, so that corners
+    // can be placed along the robot's path.
+    int distanceTraveled = motionTracker.getDistanceTraveled();
+
+    frontLeftInfrared.poll(distanceTraveled);
+    frontRightInfrared.poll(distanceTraveled);
+    leftInfrared.poll(distanceTraveled);
+    rightInfrared.poll(distanceTraveled);
 
     ultrasonic.poll();
 
+    // Latch the bumper and the NES controller together, once per loop.
+    shiftRegisterBus.poll();
+
     motionTracker.poll();
 
+    // Correct the odometry with any new range readings.
+    if (localisingWithParticles_G) {
+        updateParticleFilter();
+    } else {
+        updatePoseEstimate();
+    }
+
+    // The speed controllers run after the encoders have been read.
+    drive.poll();
+
+    // The front range is polled after the sensors, so it can pick up any new
+    // readings straight away.
+    frontRange.poll();
+
+    // Correct the heading from the wall in front, now that the front range
+    // has the latest readings. The estimator is told about the correction, so
+    // that it isn't mistaken for the robot turning.
+    if (driftObserver.poll()) {
+        poseEstimator.acceptCorrection(motionTracker.getPose());
+    }
+
+    // Limit the speed so that the robot can always stop before the wall in
+    // front of it.
+    brakingGovernor.poll();
+
     bluetoothLowEnergy.poll();
 }
 
@@ -358,6 +686,14 @@ void celebrating_S();
 
 voidFuncPtr nextState_GP = followingLeftWall_S;
 
+// The state that ran on the last loop, or nullptr if the navigator ran
+// instead, used to tell when a state has just been entered.
+voidFuncPtr lastState_GP = nullptr;
+
+// Whether the state running this loop wasn't running on the last loop, so
+// that states can start their timers afresh each time they are entered.
+bool stateJustEntered_G = true;
+
 enum Objective {
     NoObjective,
     MapOuterWall,
@@ -400,10 +736,6 @@ void followingLeftWall_S() {
     static Position rightStatingCorner;
     static Position rightEndingCorner;
 
-    // The typical distance the robot has moved before it noticed a corner has
-    // appeared.
-    const int startingCornerDropOff = 40;
-
     // If the current objective it to map the outer wall, check if enough laps
     // of the map have been done, and if so move onto the next objective
     if (currentObjective_G == MapOuterWall) {
@@ -492,24 +824,32 @@ void followingLeftWall_S() {
             innerTraveledFarEnough) {
             // move onto the next state,
             currentObjective_G = DriveToStart;
+            // The maze has been mapped, so localise against it from here on.
+            startParticleFilter();
             // and drive to the start.
             UseMazeToGoTo({200, 200});
             return;
         }
     }
 
-    // Get the difference between the angle the robot is driving, and the
-    // closest right angle.
-    int orthogonalOffset = robotAngle.OrthogonalOffset();
-    // Use this angle difference to calibrate the forwards function.
-    drive.forwards(orthogonalOffset);
+    // Steer to hold the robot a set distance from the left wall, falling back
+    // to just straightening up with the closest right angle across gaps.
+    drive.forwards(wallFollower.getRotationalSpeed());
 
-    // Read in the front distance from the Ultrasonic sensor.
-    int frontUSDistance = ultrasonic.readFromRobotCenter();
+    // Read in the front distance, fused from the ultrasonic and front infrared
+    // sensors.
+    int frontDistance = frontRange.read();
 
     const int orthogonalTolerance = 5;
 
-    if (robotAngle.isOrthogonal(orthogonalTolerance)) {
+    // Bricks are only placed while the position is known well enough, as a
+    // Brick placed from a bad position would stay in the wrong place.
+    const float maxMappingDeviation = 40;
+
+    bool poseIsCertain =
+        poseEstimator.getPositionDeviation() < maxMappingDeviation;
+
+    if (poseIsCertain && robotAngle.isOrthogonal(orthogonalTolerance)) {
         Angle roundedRobotAngle = robotAngle.closestRightAngle();
 
         static PassiveSchedule compareBrickScheduler(10);
@@ -523,10 +863,10 @@ void followingLeftWall_S() {
             // Alternate between the front and the left sensor.
             usingFrontSensor = !usingFrontSensor;
 
-            if ((usingFrontSensor) && (frontUSDistance > 120)) {
+            if ((usingFrontSensor) && (frontDistance > 120)) {
                 Angle frontSensorAngle = roundedRobotAngle;
                 brickList.handleBrickFromSensorAndMap(
-                    robotPosition, frontSensorAngle, frontUSDistance,
+                    robotPosition, frontSensorAngle, frontDistance,
                     orthogonalTolerance, &gridMap);
             }
 
@@ -539,49 +879,82 @@ void followingLeftWall_S() {
         }
     }
 
-    if (leftInfrared.seenStartingCorner(150, 50)) {
-        float distanceToWall = leftInfrared.readFromRobotCenter(false);
+    // The distance from the robot's centre to the wall, and how far the robot
+    // has traveled since passing the corner.
+    int distanceToWall;
+    int distanceSinceCorner;
 
-        leftStatingCorner = Position(-distanceToWall, -startingCornerDropOff);
+    if (leftInfrared.seenStartingCorner(150, 50, &distanceToWall,
+                                        &distanceSinceCorner)) {
+        leftStatingCorner = Position(-distanceToWall, -distanceSinceCorner);
         leftStatingCorner.transformByPose(robotPose);
 
-        brickList.handleBrickFromWallPosition(leftStatingCorner);
+        if (poseIsCertain) {
+            brickList.handleBrickFromWallPosition(leftStatingCorner);
+        }
     };
 
-    if (leftInfrared.seenEndingCorner(150, 50)) {
-        float distanceToWall = leftInfrared.readFromRobotCenter(true);
-
-        leftEndingCorner = Position(-distanceToWall, 0);
+    if (leftInfrared.seenEndingCorner(150, 50, &distanceToWall,
+                                      &distanceSinceCorner)) {
+        leftEndingCorner = Position(-distanceToWall, -distanceSinceCorner);
         leftEndingCorner.transformByPose(robotPose);
 
-        brickList.handleBrickFromLine(robotPosition, leftStatingCorner,
-                                      leftEndingCorner);
+        if (poseIsCertain) {
+            brickList.handleBrickFromLine(robotPosition, leftStatingCorner,
+                                          leftEndingCorner);
+        }
 
         drive.stop();
         sendDataOverBLE();
 
-        // Drive 150 mm then turn left
-        navigator.turnLeft(150);
+        // Drive until 150 mm past the corner then turn left.
+        navigator.turnLeft(max(150 - distanceSinceCorner, 0));
     }
 
-    if (rightInfrared.seenStartingCorner(150, 50)) {
-        float distanceToWall = rightInfrared.readFromRobotCenter(false);
-        rightStatingCorner = Position(distanceToWall, 0);
+    if (rightInfrared.seenStartingCorner(150, 50, &distanceToWall,
+                                         &distanceSinceCorner)) {
+        rightStatingCorner = Position(distanceToWall, -distanceSinceCorner);
         rightStatingCorner.transformByPose(robotPose);
     }
 
-    if (rightInfrared.seenEndingCorner(150, 50)) {
-        float distanceToWall = rightInfrared.readFromRobotCenter(true);
-
-        rightEndingCorner = Position(distanceToWall, -startingCornerDropOff);
+    if (rightInfrared.seenEndingCorner(150, 50, &distanceToWall,
+                                       &distanceSinceCorner)) {
+        rightEndingCorner = Position(distanceToWall, -distanceSinceCorner);
         rightEndingCorner.transformByPose(robotPose);
 
-        brickList.handleBrickFromLine(robotPosition, rightStatingCorner,
-                                      rightEndingCorner);
+        if (poseIsCertain) {
+            brickList.handleBrickFromLine(robotPosition, rightStatingCorner,
+                                          rightEndingCorner);
+        }
+    }
+
+    // Seeing a Brick that is already in the list again closes the loop, and
+    // gives how far the position has drifted since it was placed.
+    // The position along each measured axis is then as certain as the Brick
+    // it was measured from, so the estimator resets those axes, rather than
+    // treating the jump as movement.
+    Position loopClosureOffset;
+    bool xObserved;
+    bool yObserved;
+    if (brickList.getLoopClosure(&loopClosureOffset, &xObserved,
+                                 &yObserved)) {
+        motionTracker.applyPositionCorrection(loopClosureOffset);
+
+        Pose closedPose = motionTracker.getPose();
+        poseEstimator.acceptCorrection(closedPose);
+
+        if (xObserved) {
+            poseEstimator.resetAxis(closedPose, POSE_AXIS_X,
+                                    LOOP_CLOSURE_DEVIATION);
+        }
+        if (yObserved) {
+            poseEstimator.resetAxis(closedPose, POSE_AXIS_Y,
+                                    LOOP_CLOSURE_DEVIATION);
+        }
     }
 
     // If a wall is there.
-    if (frontUSDistance < 185 && frontUSDistance != -1) {
+    if (frontDistance < WALL_STOP_DISTANCE && frontDistance != -1) {
         nextState_GP = aligningWithWall_S;
 
         drive.stop();
@@ -590,13 +963,36 @@ void followingLeftWall_S() {
 }
 
 void aligningWithWall_S() {
-    int FLDist = frontLeftInfrared.readSafe();
-    int FRDist = frontRightInfrared.readSafe();
-
-    bool cantSeeLeft = (FLDist <= -1 || FLDist > 200);
-    bool cantSeeRight = (FRDist <= -1 || FRDist > 200);
-
-    if (cantSeeLeft || cantSeeRight) {
+    // The gain in degrees per second of rotation per degree off the wall.
+    const float alignmentGain = 4;
+    // The slowest and fastest the robot rotates while aligning, in degrees
+    // per second.
+    const float minAlignmentSpeed = 10;
+    const float maxAlignmentSpeed = DEFAULT_TURN_SPEED;
+    // The smallest difference in millimeters between the front infrared
+    // readings that stands out from their noise.
+    const float infraredResolution = 2;
+    // How close to square with the wall counts as aligned, in degrees. This
+    // is the angle that the resolution makes across the gap between the
+    // sensors, about 2.3 degrees, as any tighter and the robot dithers on the
+    // noise until it times out.
+    const float alignmentTolerance =
+        atan2f(infraredResolution, FRONT_INFRARED_SEPARATION) *
+        DEGREES_PER_RADIAN;
+    // The longest that aligning is allowed to take, in milliseconds.
+    const uint32_t alignmentTimeout = 1500;
+    // The standard deviation of the angle and of the position along each
+    // axis snapped to a wall, in degrees and millimeters.
+    const float snappedAngleDeviation = 1;
+    const float snappedPositionDeviation = 10;
+
+    static uint32_t alignmentStartTime;
+    static int oscillationCount;
+    static bool lastTurnWasLeft;
+
+    float wallAngle;
+
+    if (!frontRange.readWallAngle(&wallAngle)) {
         Serial.println("Cant read front sensor while aligning");
 
         navigator.turnRight();
@@ -604,14 +1000,45 @@ void aligningWithWall_S() {
         return;
     }
 
-    if (FLDist < FRDist) {
-        drive.turnLeft();
-    } else if (FLDist > FRDist) {
-        drive.turnRight();
+    // Start timing afresh each time the state is entered, including after the
+    // navigator has taken over to back off from a bumper hit.
+    if (stateJustEntered_G) {
+        alignmentStartTime = millis();
+        oscillationCount = 0;
+        lastTurnWasLeft = wallAngle > 0;
+    }
+
+    uint32_t alignmentDuration = millis() - alignmentStartTime;
+
+    bool isAligned = abs(wallAngle) <= alignmentTolerance;
+    bool timedOut = alignmentDuration > alignmentTimeout;
+
+    if (!(isAligned || timedOut)) {
+        // Count each time the robot overshoots and has to turn back.
+        bool turningLeft = wallAngle > 0;
+        if (turningLeft != lastTurnWasLeft) {
+            oscillationCount++;
+        }
+        lastTurnWasLeft = turningLeft;
+
+        // Rotate in proportion to the angle off the wall, so the robot slows
+        // down as it squares up rather than overshooting.
+        float rotationalSpeed =
+            constrain(abs(wallAngle) * alignmentGain, minAlignmentSpeed,
+                      maxAlignmentSpeed);
+
+        drive.setSpeed(0, turningLeft ? rotationalSpeed : -rotationalSpeed);
     } else {  // is aligned
         drive.stop();
 
-        int frontDistance = ultrasonic.readFromRobotCenter();
+        Serial.print("Aligned in ");
+        Serial.print(alignmentDuration);
+        Serial.print("ms with ");
+        Serial.print(oscillationCount);
+        Serial.print(" oscillations");
+        Serial.println(timedOut ? " (timed out)" : "");
+
+        int frontDistance = frontRange.read();
 
         int leftDistance = leftInfrared.readFromRobotCenter();
 
@@ -619,6 +1046,31 @@ void aligningWithWall_S() {
         int wallsRecelebratedAgainst =
             motionTracker.recalibratePosition(frontDistance, leftDistance);
 
+        // The recalibration always snaps the angle to the wall, and snaps
+        // the position along each axis that a wall was measured on, the
+        // front wall first and then the left wall if in a corner. Only
+        // those values become certain, the rest keep their uncertainty.
+        Pose snappedPose = motionTracker.getPose();
+
+        poseEstimator.resetAxis(snappedPose, POSE_AXIS_ANGLE,
+                                snappedAngleDeviation);
+
+        Angle snappedAngle = snappedPose.angle;
+        bool facingAlongY =
+            snappedAngle.isPointingUp() || snappedAngle.isPointingDown();
+
+        uint8_t frontAxis = facingAlongY ? POSE_AXIS_Y : POSE_AXIS_X;
+        uint8_t leftAxis = facingAlongY ? POSE_AXIS_X : POSE_AXIS_Y;
+
+        if (wallsRecelebratedAgainst >= 1) {
+            poseEstimator.resetAxis(snappedPose, frontAxis,
+                                    snappedPositionDeviation);
+        }
+        if (wallsRecelebratedAgainst == 2) {
+            poseEstimator.resetAxis(snappedPose, leftAxis,
+                                    snappedPositionDeviation);
+        }
+
         if (wallsRecelebratedAgainst == 1) {
             // If against a wall, flash the Pixels red to indicate.
             pixels.setAll(Colour("Red"), true);
@@ -638,30 +1090,100 @@ void aligningWithWall_S() {
     }
 }
 
+/**
+ * @brief Plans the fastest trajectory along the solved map from the robot to
+ * the goal, and if FOLLOW_TRAJECTORY is set, gives it to the navigator to
+ * follow.
+ *
+ * @return (float) The estimated time in seconds to reach the goal, or -1 if
+ * there is no path to the goal.
+ */
+float planTrajectory() {
+    std::vector<Position> path;
+
+    if (!gridMap.extractPath(motionTracker.getPosition(), &path)) {
+        return -1;
+    }
+
+    // Keep to the speeds the map says are safe, on top of the limits of the
+    // planner.
+    std::vector<int> speedLimits;
+    for (Position waypoint : path) {
+        speedLimits.push_back(gridMap.getSafeSpeed(waypoint));
+    }
+
+    float travelTime = velocityPlanner.plan(path, speedLimits);
+
+#if FOLLOW_TRAJECTORY
+    navigator.followTrajectory(path, velocityPlanner.getSpeeds());
+#endif  // FOLLOW_TRAJECTORY
+
+    return travelTime;
+}
+
 void UseMazeToGoTo(Position positionToGoTo) {
     drive.stop();
+    dynamicWindow.reset();
     pixels.setAll(Colour("Pink"), true);
 
     gridMap.solve(brickList, positionToGoTo);
 
+    // Report the planned time to the goal after each solve, so that changes
+    // to the planner can be compared.
+    float lapTime = planTrajectory();
+    if (lapTime == -1) {
+        Serial.println("No path to the goal to plan along");
+    } else {
+        Serial.print("Estimated lap time: ");
+        Serial.print(lapTime, 2);
+        Serial.println("s");
+    }
+
     nextState_GP = followingMaze_S;
 }
 
 void followingMaze_S() {
+    Position robotPosition = motionTracker.getPosition();
+
+    int distanceToEndMM = gridMap.getCrowDistanceToEnd(robotPosition);
+
+    const int range = 100;
+
+#if FOLLOW_TRAJECTORY
+    // The navigator follows the trajectory, so this is only reached once it
+    // has been cleared, either by finishing it or by hitting something. If
+    // the robot isn't at the goal yet, plan a new one from where it is.
+    if (distanceToEndMM >= range && planTrajectory() != -1) {
+        return;
+    }
+
+    // No path can be extracted from a cell that is closer to a wall than the
+    // radius of the robot, so drive without a trajectory until the robot is
+    // back out in the open, and plan again from there.
+#endif  // FOLLOW_TRAJECTORY
+
+    // Drive as fast as the map says is safe, speeding up in open stretches
+    // and slowing down for tight turns.
+    int safeSpeed = gridMap.getSafeSpeed(robotPosition);
+    if (safeSpeed == -1) {
+        safeSpeed = DEFAULT_DRIVE_SPEED;
+    }
+
+#if USE_DYNAMIC_WINDOW
+    dynamicWindow.setMaxSpeed(safeSpeed);
+    dynamicWindow.plan();
+#else
     static Angle angleToDrive = 90;
 
-    Position robotPosition = motionTracker.getPosition();
     Angle robotAngle = motionTracker.getAngle();
 
     gridMap.updateAngleToDrive(robotPosition, &angleToDrive);
 
     Angle angleToTurn = angleToDrive - robotAngle;
 
-    drive.forwards(angleToTurn);
-
-    int distanceToEndMM = gridMap.getCrowDistanceToEnd(robotPosition);
+    drive.setSpeed(safeSpeed, angleToTurn * HEADING_CORRECTION_GAIN);
+#endif  // USE_DYNAMIC_WINDOW
 
-    const int range = 100;
     // if the robot is less than 100 mm from the goal, move onto the next
     // state.
     if (distanceToEndMM < range) {
@@ -745,6 +1267,75 @@ void updateObjective(byte bumperData, Objective currentObjective,
     }
 }
 
+/**
+ * @brief Checks that the robot is moving the way it has been told to, and
+ * reacts if it isn't.
+ *
+ * After a wheel slips the odometry is trusted less, and the robot drives
+ * slower for a while. If a wheel stalls or the robot is blocked, it escapes
+ * the same way as if the bumper on that side had been pressed.
+ */
+void monitorMotion() {
+    // How much uncertainty to add to the pose after an event, in millimeters
+    // and degrees.
+    const float slipPositionDeviation = 20;
+    const float slipAngleDeviation = 2;
+
+    // How long in milliseconds to drive slower for after a wheel slips, and
+    // the fraction of the normal speed to drive at. The speed is scaled in
+    // Drive, so that it slows down whatever is driving, including the path
+    // followers that set their own speeds.
+    const uint32_t slowDownTime = 2000;
+    const float slowSpeedScale = 0.5;
+
+    static uint32_t slowDownEndTime = 0;
+    static bool slowedDown = false;
+
+    if (slowedDown && (millis() > slowDownEndTime)) {
+        drive.setSpeedScale(1);
+        slowedDown = false;
+    }
+
+    MotionEvent motionEvent = motionMonitor.poll();
+
+    if (motionEvent == NoMotionEvent) {
+        return;
+    }
+
+    // Whatever went wrong, the wheels didn't move the robot the way the
+    // odometry thinks they did.
+    poseEstimator.addUncertainty(slipPositionDeviation, slipAngleDeviation);
+
+    if (motionEvent == WheelSlip) {
+        Serial.println("Wheel slip detected, slowing down.");
+
+        drive.setSpeedScale(slowSpeedScale);
+        slowDownEndTime = millis() + slowDownTime;
+        slowedDown = true;
+        return;
+    }
+
+    bool drivingBackwards =
+        (drive.getLeftCommandedSpeed() + drive.getRightCommandedSpeed()) < 0;
+
+    // Pretend that the bumper in the direction of travel has been pressed,
+    // on the side of the stalled wheel, using the same bits as the bumper.
+    byte bumperData = drivingBackwards ? 16 : 1;
+
+    if (motionEvent == LeftWheelStall) {
+        Serial.println("Left wheel stalled.");
+        bumperData |= drivingBackwards ? 32 : 128;
+    } else if (motionEvent == RightWheelStall) {
+        Serial.println("Right wheel stalled.");
+        bumperData |= drivingBackwards ? 8 : 2;
+    } else {
+        Serial.println("Blocked.");
+    }
+
+    drive.stop();
+    navigator.hitBumper(bumperData);
+}
+
 void loop() {
     polls();
     checkIncomingSerialCommands();
@@ -755,6 +1346,9 @@ void loop() {
 
     if ((millis() < 5000) && nesReading.anyButtonPressed()) {
         NES_MODE = true;
+        // Stop the speed controllers, so that they don't fight the NES
+        // controller for the motors.
+        drive.stop();
         pixels.setAll(Colour("Black"), true);
     }
     if (NES_MODE) {
@@ -809,6 +1403,8 @@ void loop() {
             analogWrite(RIGHT_MOTOR_SPEED_PIN, 0);
         }
     } else {
+        monitorMotion();
+
         byte bumperData = bumper.read();
         if (bumperData) {
             navigator.hitBumper(bumperData);
@@ -829,7 +1425,11 @@ void loop() {
 
             navigator.moveToTarget();
 
+            lastState_GP = nullptr;
         } else {
+            stateJustEntered_G = (nextState_GP != lastState_GP);
+            lastState_GP = nextState_GP;
+
             nextState_GP();
         }
 
@@ -837,6 +1437,20 @@ void loop() {
     }
 }
 
+/**
+ * @brief Polls for a given amount of time, used in place of delay() while
+ * the speed controllers need updating.
+ *
+ * @param duration The time to poll for in milliseconds.
+ */
+void pollFor(uint32_t duration) {
+    uint32_t startTime = millis();
+
+    while (millis() - startTime < duration) {
+        polls();
+    }
+}
+
 /**
  * @brief A test loop to run instead of loop() if the RUN_TEST_LOOP define
  * is set to true.
@@ -845,7 +1459,7 @@ void testLoop() {
     Serial.println("Forwards");
     pixels.setAll(Colour("Green"), true);
     drive.forwards();
-    delay(1000);
+    pollFor(1000);
 
     pixels.setAll(Colour("Black"), true);
     drive.stop();
@@ -854,7 +1468,7 @@ void testLoop() {
     Serial.println("Backwards");
     pixels.setAll(Colour("Red"), true);
     drive.backwards();
-    delay(1000);
+    pollFor(1000);
 
     pixels.setAll(Colour("Black"), true);
     drive.stop();
@@ -0,0 +1,168 @@
+/**
+ * @file Arduino.h
+ * @brief A stand in for the parts of the Arduino core used by the libraries
+ * under test, so that they can be built and tested on the host with the
+ * native environment.
+ *
+ * The clock and the digital pins are plain variables, so that tests can set
+ * the time and the pin levels that the code under test sees.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using std::abs;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef void (*voidFuncPtr)(void);
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 2
+#define LED_BUILTIN 13
+
+enum { D0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13 };
+enum { A0 = 14, A1, A2, A3, A4, A5, A6, A7 };
+
+#define NATIVE_PIN_COUNT 32
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define constrain(amt, low, high) \
+    ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define sq(x) ((x) * (x))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+
+/**
+ * @brief The time in microseconds returned by micros(), millis() returns the
+ * same time in milliseconds.
+ */
+inline uint32_t nativeMicros_G = 0;
+
+/**
+ * @brief The level of each digital pin, returned by digitalRead().
+ */
+inline int nativePinLevels_G[NATIVE_PIN_COUNT] = {0};
+
+inline unsigned long micros() { return nativeMicros_G; }
+inline unsigned long millis() { return nativeMicros_G / 1000; }
+inline void delay(unsigned long duration) { nativeMicros_G += duration * 1000; }
+inline void delayMicroseconds(unsigned int duration) {
+    nativeMicros_G += duration;
+}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return nativePinLevels_G[pin]; }
+inline void digitalWrite(uint8_t pin, uint8_t level) {
+    nativePinLevels_G[pin] = level;
+}
+inline void analogWrite(uint8_t, int) {}
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, voidFuncPtr, int) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+inline long random(long howBig) { return howBig > 0 ? rand() % howBig : 0; }
+inline long random(long howSmall, long howBig) {
+    return howSmall + random(howBig - howSmall);
+}
+
+/**
+ * @brief A cut down version of the Arduino String class, backed by a
+ * std::string.
+ */
+class String {
+   public:
+    String(const char* text = "") : _text(text) {}
+    String(const std::string& text) : _text(text) {}
+    String(char value) : _text(1, value) {}
+    String(int value) : _text(std::to_string(value)) {}
+    String(unsigned int value) : _text(std::to_string(value)) {}
+    String(long value) : _text(std::to_string(value)) {}
+    String(unsigned long value) : _text(std::to_string(value)) {}
+    String(float value, int = 2) : _text(std::to_string(value)) {}
+    String(double value, int = 2) : _text(std::to_string(value)) {}
+
+    template <typename T>
+    String& operator+=(const T& value) {
+        this->_text += String(value)._text;
+        return *this;
+    }
+
+    friend String operator+(const String& left, const String& right) {
+        return String(left._text + right._text);
+    }
+
+    bool operator==(const String& other) const {
+        return this->_text == other._text;
+    }
+    bool operator!=(const String& other) const {
+        return this->_text != other._text;
+    }
+    bool equals(const String& other) const {
+        return this->_text == other._text;
+    }
+
+    unsigned int length() const { return this->_text.size(); }
+    const char* c_str() const { return this->_text.c_str(); }
+
+    int indexOf(const char* text) const {
+        size_t index = this->_text.find(text);
+        return (index == std::string::npos) ? -1 : (int)index;
+    }
+    String substring(unsigned int start) const {
+        return String(this->_text.substr(start));
+    }
+    String substring(unsigned int start, unsigned int end) const {
+        return String(this->_text.substr(start, end - start));
+    }
+    void remove(unsigned int index) { this->_text.erase(index); }
+    void toLowerCase() {
+        for (char& character : this->_text) {
+            character = tolower(character);
+        }
+    }
+
+   private:
+    std::string _text;
+};
+
+/**
+ * @brief A serial port that throws away everything written to it.
+ */
+class NativeSerial {
+   public:
+    void begin(unsigned long) {}
+    template <typename T>
+    void print(const T&, int = 0) {}
+    template <typename T>
+    void println(const T&, int = 0) {}
+    void println() {}
+    int available() { return 0; }
+    String readString() { return String(); }
+    void write(const uint8_t*, size_t) {}
+    operator bool() { return true; }
+};
+
+inline NativeSerial Serial;
+
+#endif  // NATIVE_ARDUINO_H
@@ -0,0 +1,171 @@
+/**
+ * @file test_angleAndPosition.cpp
+ * @brief Host tests for the lookup table trig used by the Angle class and the
+ * Position struct, checking it against the double precision functions from
+ * <cmath>, and timing it against them.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#include <unity.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "angleAndPosition.h"
+
+// The number of binary angle units in a full rotation.
+#define BINARY_ANGLE_COUNT 65536
+
+// The largest error allowed from the sine table, interpolating linearly
+// between 65 entries over a quarter wave is accurate to about 7.5e-5.
+#define MAX_TRIG_ERROR 1e-4
+
+// The largest error in degrees allowed from calculateAngleTo(), the angle is
+// rounded to the nearest binary angle, which is about 0.0055 degrees.
+#define MAX_ANGLE_ERROR 0.01
+
+// The number of calls timed by the benchmark.
+#define BENCHMARK_CALLS 1000000
+
+void setUp() {}
+void tearDown() {}
+
+// Converts a binary angle into radians, in double precision.
+double binaryToRadians(int32_t binaryAngle) {
+    return binaryAngle * 2 * M_PI / BINARY_ANGLE_COUNT;
+}
+
+// Wraps an angle in degrees to between -180 and 180.
+double wrapDegrees(double degrees) {
+    return std::remainder(degrees, 360.0);
+}
+
+void test_sine_matches_cmath_for_every_binary_angle() {
+    double maxError = 0;
+
+    for (int32_t binaryAngle = 0; binaryAngle < BINARY_ANGLE_COUNT;
+         binaryAngle++) {
+        Angle angle = Angle::fromBinary((int16_t)(uint16_t)binaryAngle);
+        double expected = std::sin(binaryToRadians(binaryAngle));
+
+        maxError = std::max(maxError, std::fabs(angle.getSine() - expected));
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "Max sine error %.2e", maxError);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_TRIG_ERROR, maxError);
+}
+
+void test_cosine_matches_cmath_for_every_binary_angle() {
+    double maxError = 0;
+
+    for (int32_t binaryAngle = 0; binaryAngle < BINARY_ANGLE_COUNT;
+         binaryAngle++) {
+        Angle angle = Angle::fromBinary((int16_t)(uint16_t)binaryAngle);
+        double expected = std::cos(binaryToRadians(binaryAngle));
+
+        maxError = std::max(maxError, std::fabs(angle.getCosine() - expected));
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "Max cosine error %.2e", maxError);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_LESS_THAN_FLOAT(MAX_TRIG_ERROR, maxError);
+}
+
+void test_whole_degrees_match_cmath() {
+    for (int16_t degrees = -179; degrees <= 180; degrees++) {
+        Angle angle = degrees;
+        double radians = degrees * M_PI / 180;
+
+        TEST_ASSERT_FLOAT_WITHIN(MAX_TRIG_ERROR, std::sin(radians),
+                                 angle.getSine());
+        TEST_ASSERT_FLOAT_WITHIN(MAX_TRIG_ERROR, std::cos(radians),
+                                 angle.getCosine());
+    }
+}
+
+void test_rotate_matches_cmath() {
+    for (int16_t degrees = -179; degrees <= 180; degrees += 7) {
+        Position position(120, -45);
+        position.rotate(degrees);
+
+        double radians = degrees * M_PI / 180;
+        double expectedX = 120 * std::cos(radians) + 45 * std::sin(radians);
+        double expectedY = -45 * std::cos(radians) + 120 * std::sin(radians);
+
+        TEST_ASSERT_FLOAT_WITHIN(0.05, expectedX, position.x);
+        TEST_ASSERT_FLOAT_WITHIN(0.05, expectedY, position.y);
+    }
+}
+
+void test_calculate_angle_to_matches_cmath() {
+    Position origin(0, 0);
+
+    for (int x = -500; x <= 500; x += 25) {
+        for (int y = -500; y <= 500; y += 25) {
+            if ((x == 0) && (y == 0)) {
+                continue;
+            }
+
+            double expected = std::atan2(y, x) * 180 / M_PI;
+            float actual = origin.calculateAngleTo(Position(x, y)).getDegrees();
+
+            TEST_ASSERT_FLOAT_WITHIN(MAX_ANGLE_ERROR, 0,
+                                     wrapDegrees(actual - expected));
+        }
+    }
+}
+
+void test_benchmark_against_cmath() {
+    using Clock = std::chrono::steady_clock;
+
+    // Summed into a volatile so that the calls can't be optimised away.
+    volatile float tableSum = 0;
+    volatile double cmathSum = 0;
+
+    Clock::time_point tableStart = Clock::now();
+    for (int32_t i = 0; i < BENCHMARK_CALLS; i++) {
+        tableSum = tableSum + Angle::fromBinary((int16_t)i).getSine();
+    }
+    Clock::time_point tableEnd = Clock::now();
+
+    for (int32_t i = 0; i < BENCHMARK_CALLS; i++) {
+        cmathSum = cmathSum + std::sin(binaryToRadians((int16_t)i));
+    }
+    Clock::time_point cmathEnd = Clock::now();
+
+    double tableTime =
+        std::chrono::duration<double, std::nano>(tableEnd - tableStart)
+            .count() /
+        BENCHMARK_CALLS;
+    double cmathTime =
+        std::chrono::duration<double, std::nano>(cmathEnd - tableEnd)
+            .count() /
+        BENCHMARK_CALLS;
+
+    // The timings depend on the host, so are reported rather than checked,
+    // the saving on the robot is larger as it has no double precision FPU.
+    char message[96];
+    snprintf(message, sizeof(message),
+             "Table sine %.1fns per call, double sin() %.1fns per call",
+             tableTime, cmathTime);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sine_matches_cmath_for_every_binary_angle);
+    RUN_TEST(test_cosine_matches_cmath_for_every_binary_angle);
+    RUN_TEST(test_whole_degrees_match_cmath);
+    RUN_TEST(test_rotate_matches_cmath);
+    RUN_TEST(test_calculate_angle_to_matches_cmath);
+    RUN_TEST(test_benchmark_against_cmath);
+    return UNITY_END();
+}
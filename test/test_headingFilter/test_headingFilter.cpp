@@ -0,0 +1,158 @@
+/**
+ * @file test_headingFilter.cpp
+ * @brief Host tests for the HeadingFilter class, driven by a SimulatedImu,
+ * checking that the gyroscope's bias is learned while stationary, that the
+ * wheels hold the heading over long periods, and that wheel slip in a fast
+ * spin or against a wall doesn't leave the heading wrong.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#include <unity.h>
+
+#include <cmath>
+#include <cstdio>
+
+#include "headingFilter.h"
+#include "imu.h"
+
+// The time between samples from the gyroscope in seconds, matching the
+// 100 Hz output of the onboard IMU.
+#define SAMPLE_PERIOD 0.01f
+
+// The bias of the simulated gyroscope, in degrees per second.
+#define GYRO_BIAS 0.5f
+
+// The fraction that the wheels over read by while slipping in a spin.
+#define SPIN_SLIP 0.08f
+
+SimulatedImu* imu_P = nullptr;
+HeadingFilter* headingFilter_P = nullptr;
+
+// The true change in heading of the simulated robot, in degrees.
+double trueAngle = 0;
+
+// The change in heading measured by the wheels alone, in degrees.
+double odometryAngle = 0;
+
+// Runs the filter for a length of time, with the robot turning at a steady
+// rate and the wheels over reading by a given fraction.
+void simulate(float seconds, float yawRate, float wheelSlip, bool stationary) {
+    int samples = lroundf(seconds / SAMPLE_PERIOD);
+
+    for (int i = 0; i < samples; i++) {
+        float trueChange = yawRate * SAMPLE_PERIOD;
+        float odometryChange = trueChange * (1 + wheelSlip);
+
+        trueAngle += trueChange;
+        odometryAngle += odometryChange;
+
+        imu_P->setYawRate(yawRate);
+
+        float measuredRate;
+        TEST_ASSERT_TRUE(imu_P->readYawRate(&measuredRate));
+
+        headingFilter_P->update(odometryChange, measuredRate, SAMPLE_PERIOD,
+                                stationary);
+    }
+}
+
+// Gets the difference between two headings, wrapped to between -180 and 180
+// degrees, as the filter wraps its angle by whole turns.
+double headingError(double angle, double expected) {
+    return std::remainder(angle - expected, 360.0);
+}
+
+void setUp() {
+    delete imu_P;
+    delete headingFilter_P;
+
+    imu_P = new SimulatedImu(GYRO_BIAS);
+    imu_P->setup();
+
+    headingFilter_P = new HeadingFilter();
+
+    trueAngle = 0;
+    odometryAngle = 0;
+}
+
+void tearDown() {}
+
+void test_bias_is_learned_while_stationary() {
+    simulate(5, 0, 0, true);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.01, GYRO_BIAS, headingFilter_P->getBias());
+
+    // The bias is all that a still gyroscope reads, so none of it is turned
+    // into a change in heading.
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0, headingFilter_P->getAngle());
+}
+
+void test_bias_isnt_learned_while_moving() {
+    simulate(5, 0, 0, false);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0, headingFilter_P->getBias());
+}
+
+void test_wheels_hold_the_heading_against_an_unlearned_bias() {
+    // Driving straight for 20 s, the gyroscope alone would drift by 10°, but
+    // the wheels pull the heading back to within about the bias times the
+    // time constant.
+    simulate(20, 0, 0, false);
+
+    TEST_ASSERT_FLOAT_WITHIN(
+        GYRO_BIAS * HEADING_FILTER_TIME_CONSTANT * 1.1,
+        0, headingFilter_P->getAngle());
+}
+
+void test_spin_with_wheel_slip() {
+    // Learn the bias first, as the robot does while waiting to start.
+    simulate(5, 0, 0, true);
+
+    // Two full turns at 180° per second, with the wheels slipping by 8%,
+    // then coming to rest.
+    simulate(4, 180, SPIN_SLIP, false);
+    simulate(2, 0, 0, true);
+
+    double odometryError = headingError(odometryAngle, trueAngle);
+    double fusedError = headingError(headingFilter_P->getAngle(), trueAngle);
+
+    char message[80];
+    snprintf(message, sizeof(message),
+             "Odometry error %.1f degrees, fused error %.2f degrees",
+             odometryError, fusedError);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_FLOAT_WITHIN(1, 720 * SPIN_SLIP, odometryError);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 0, fusedError);
+}
+
+void test_wheel_spinning_while_stuck_is_slip() {
+    simulate(5, 0, 0, true);
+
+    // Against a wall, one wheel spins and reads as a 60° per second turn,
+    // while the gyroscope sees the robot stay still.
+    for (int i = 0; i < 100; i++) {
+        imu_P->setYawRate(0);
+
+        float measuredRate;
+        TEST_ASSERT_TRUE(imu_P->readYawRate(&measuredRate));
+
+        headingFilter_P->update(60 * SAMPLE_PERIOD, measuredRate,
+                                SAMPLE_PERIOD, false);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(100, headingFilter_P->getSlipCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 0, headingFilter_P->getAngle());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bias_is_learned_while_stationary);
+    RUN_TEST(test_bias_isnt_learned_while_moving);
+    RUN_TEST(test_wheels_hold_the_heading_against_an_unlearned_bias);
+    RUN_TEST(test_spin_with_wheel_slip);
+    RUN_TEST(test_wheel_spinning_while_stuck_is_slip);
+    return UNITY_END();
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_motor.cpp
+ * @brief Host tests for the Motor class's table driven quadrature decoder and
+ * edge timing, feeding synthetic edge sequences through the encoder pins into
+ * the ISR.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#include <unity.h>
+
+#include "motor.h"
+
+// The pins used by the motor under test.
+#define TEST_DIRECTION_PIN D4
+#define TEST_SPEED_PIN D5
+#define TEST_CHANNEL_A_PIN D2
+#define TEST_CHANNEL_B_PIN D3
+
+// The encoder states when driving forwards, with channel A in bit 1 and
+// channel B in bit 0.
+const uint8_t FORWARD_STATES[EDGES_PER_CYCLE] = {0, 2, 3, 1};
+
+// The time in microseconds between the edges fed into the ISR.
+#define EDGE_INTERVAL 250
+
+Motor* motor_P = nullptr;
+
+// Sets the encoder pins to a given state and calls the ISR, as the interrupt
+// on the pin that changed would.
+void setEncoderState(uint8_t state) {
+    nativeMicros_G += EDGE_INTERVAL;
+    nativePinLevels_G[TEST_CHANNEL_A_PIN] = (state >> 1) & 1;
+    nativePinLevels_G[TEST_CHANNEL_B_PIN] = state & 1;
+    motor_P->isr();
+}
+
+// Feeds a number of edges forwards through the quadrature cycle, or backwards
+// if the count is negative, starting from the current state of the pins.
+void stepEncoder(int edges) {
+    uint8_t state = (nativePinLevels_G[TEST_CHANNEL_A_PIN] << 1) |
+                    nativePinLevels_G[TEST_CHANNEL_B_PIN];
+
+    uint8_t index = 0;
+    while (FORWARD_STATES[index] != state) {
+        index++;
+    }
+
+    int direction = (edges > 0) ? 1 : -1;
+
+    for (int i = 0; i < abs(edges); i++) {
+        index = (index + EDGES_PER_CYCLE + direction) % EDGES_PER_CYCLE;
+        setEncoderState(FORWARD_STATES[index]);
+    }
+}
+
+// Creates a new motor with the encoder in state 0.
+void createMotor(bool rotationInverted) {
+    delete motor_P;
+
+    nativePinLevels_G[TEST_CHANNEL_A_PIN] = 0;
+    nativePinLevels_G[TEST_CHANNEL_B_PIN] = 0;
+
+    motor_P = new Motor(TEST_DIRECTION_PIN, TEST_SPEED_PIN, TEST_CHANNEL_A_PIN,
+                        TEST_CHANNEL_B_PIN, rotationInverted);
+    motor_P->setup(nullptr);
+}
+
+void setUp() {
+    nativeMicros_G = 1000000;
+    createMotor(false);
+}
+
+void tearDown() {}
+
+void test_each_forward_transition_counts_one_step() {
+    for (int edge = 1; edge <= 2 * EDGES_PER_CYCLE; edge++) {
+        stepEncoder(1);
+        TEST_ASSERT_EQUAL_INT32(edge, motor_P->getSteps());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderErrors());
+}
+
+void test_each_backward_transition_counts_minus_one_step() {
+    for (int edge = 1; edge <= 2 * EDGES_PER_CYCLE; edge++) {
+        stepEncoder(-1);
+        TEST_ASSERT_EQUAL_INT32(-edge, motor_P->getSteps());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderErrors());
+}
+
+void test_repeated_state_counts_nothing() {
+    stepEncoder(1);
+
+    // A bounce that lands back on the same state isn't an edge.
+    setEncoderState(2);
+    setEncoderState(2);
+
+    TEST_ASSERT_EQUAL_INT32(1, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderErrors());
+}
+
+void test_double_transitions_are_errors() {
+    // Both channels changing at once skips a state, so the direction can't
+    // be known. 0 to 3 and 2 to 1 are the two diagonals of the cycle.
+    setEncoderState(3);
+    TEST_ASSERT_EQUAL_INT32(0, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_UINT32(1, motor_P->getEncoderErrors());
+
+    setEncoderState(0);
+    setEncoderState(2);
+    setEncoderState(1);
+    TEST_ASSERT_EQUAL_UINT32(3, motor_P->getEncoderErrors());
+
+    // Steps carry on being counted from the new state.
+    setEncoderState(0);
+    TEST_ASSERT_EQUAL_UINT32(3, motor_P->getEncoderErrors());
+}
+
+void test_direction_reversal() {
+    stepEncoder(6);
+    TEST_ASSERT_EQUAL_INT32(6, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_INT(1, motor_P->getEncoderSnapshot().direction);
+
+    stepEncoder(-9);
+    TEST_ASSERT_EQUAL_INT32(-3, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_INT(-1, motor_P->getEncoderSnapshot().direction);
+
+    stepEncoder(3);
+    TEST_ASSERT_EQUAL_INT32(0, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderErrors());
+}
+
+void test_inverted_rotation_flips_the_count() {
+    createMotor(true);
+
+    stepEncoder(5);
+    TEST_ASSERT_EQUAL_INT32(-5, motor_P->getSteps());
+    TEST_ASSERT_EQUAL_INT(-1, motor_P->getEncoderSnapshot().direction);
+}
+
+void test_cycle_period_needs_a_full_cycle_after_boot() {
+    // The period is timed from the edge a cycle ago, so the first edge after
+    // boot has to be followed by a full cycle before there is a period.
+    stepEncoder(EDGES_PER_CYCLE);
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderSnapshot().cyclePeriod);
+
+    stepEncoder(1);
+    TEST_ASSERT_EQUAL_UINT32(EDGES_PER_CYCLE * EDGE_INTERVAL,
+                             motor_P->getEncoderSnapshot().cyclePeriod);
+}
+
+void test_cycle_period_needs_a_full_cycle_after_reversal() {
+    stepEncoder(8);
+
+    // Stop for a while before reversing, which mustn't end up in the period.
+    nativeMicros_G += 50000;
+
+    stepEncoder(-EDGES_PER_CYCLE);
+    TEST_ASSERT_EQUAL_UINT32(0, motor_P->getEncoderSnapshot().cyclePeriod);
+
+    stepEncoder(-1);
+    TEST_ASSERT_EQUAL_UINT32(EDGES_PER_CYCLE * EDGE_INTERVAL,
+                             motor_P->getEncoderSnapshot().cyclePeriod);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_each_forward_transition_counts_one_step);
+    RUN_TEST(test_each_backward_transition_counts_minus_one_step);
+    RUN_TEST(test_repeated_state_counts_nothing);
+    RUN_TEST(test_double_transitions_are_errors);
+    RUN_TEST(test_direction_reversal);
+    RUN_TEST(test_inverted_rotation_flips_the_count);
+    RUN_TEST(test_cycle_period_needs_a_full_cycle_after_boot);
+    RUN_TEST(test_cycle_period_needs_a_full_cycle_after_reversal);
+    return UNITY_END();
+}
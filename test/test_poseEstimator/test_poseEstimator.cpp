@@ -0,0 +1,215 @@
+/**
+ * @file test_poseEstimator.cpp
+ * @brief Host tests for the PoseEstimator class, checking how the predict step
+ * grows the uncertainty, how the update step corrects the pose and shrinks it,
+ * and that snapping a single axis keeps the uncertainty of the others.
+ *
+ * @author Harry Boyd - https://github.com/HBoyd255
+ * @date 2024-04-18
+ * @copyright Copyright (c) 2024
+ */
+#include <unity.h>
+
+#include "brick.h"
+#include "poseEstimator.h"
+
+// The x position of the outer corner of the Brick on the bottom wall, which
+// puts the Brick between x = 375 and x = 625, and its top face at y = 85. The
+// BrickList also holds the outer walls.
+#define BRICK_CORNER_X 625
+#define BRICK_TOP_FACE 85
+
+// The starting deviations of the position and angle, in millimeters and
+// degrees.
+#define START_POSITION_DEVIATION 20
+#define START_ANGLE_DEVIATION 2
+
+// The variance of the range readings, in millimeters squared.
+#define READING_VARIANCE 25
+
+BrickList* brickList_P = nullptr;
+PoseEstimator* poseEstimator_P = nullptr;
+
+// Makes a pose from a position and an angle in degrees.
+Pose makePose(float x, float y, int16_t degrees) {
+    Pose pose;
+    pose.position = Position(x, y);
+    pose.angle = degrees;
+    return pose;
+}
+
+// The pose used by most of the tests, above the Brick and facing down at it.
+Pose facingBrick() { return makePose(500, 400, -90); }
+
+void setUp() {
+    delete poseEstimator_P;
+    delete brickList_P;
+
+    brickList_P = new BrickList();
+    brickList_P->handleBrickFromWallPosition(Position(BRICK_CORNER_X, 0));
+
+    poseEstimator_P = new PoseEstimator(brickList_P);
+    poseEstimator_P->reset(facingBrick(), START_POSITION_DEVIATION,
+                           START_ANGLE_DEVIATION);
+}
+
+void tearDown() {}
+
+void test_predict_without_movement_changes_nothing() {
+    poseEstimator_P->predict(facingBrick());
+
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_X));
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, START_ANGLE_DEVIATION,
+                             poseEstimator_P->getAngleDeviation());
+}
+
+void test_predict_driving_grows_the_position_uncertainty() {
+    poseEstimator_P->reset(makePose(500, 400, 0), 0, 0);
+
+    // Driving along x with no angle error only adds error along x.
+    poseEstimator_P->predict(makePose(700, 400, 0));
+
+    TEST_ASSERT_GREATER_THAN_FLOAT(
+        0, poseEstimator_P->getAxisDeviation(POSE_AXIS_X));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 0,
+                             poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+
+    // With an angle error, driving also spreads the position sideways.
+    poseEstimator_P->reset(makePose(500, 400, 0), 0, START_ANGLE_DEVIATION);
+    poseEstimator_P->predict(makePose(700, 400, 0));
+
+    TEST_ASSERT_GREATER_THAN_FLOAT(
+        1, poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+}
+
+void test_predict_turning_grows_the_angle_uncertainty() {
+    poseEstimator_P->predict(makePose(500, 400, 0));
+
+    TEST_ASSERT_GREATER_THAN_FLOAT(START_ANGLE_DEVIATION,
+                                   poseEstimator_P->getAngleDeviation());
+}
+
+void test_update_with_expected_reading_shrinks_the_uncertainty() {
+    int expectedDistance = facingBrick().position.y - BRICK_TOP_FACE;
+
+    Pose correction;
+    TEST_ASSERT_TRUE(poseEstimator_P->update(facingBrick(), Position(0, 0), 0,
+                                             expectedDistance,
+                                             READING_VARIANCE, &correction));
+
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 0, correction.position.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 0, correction.position.y);
+
+    // The reading only measures y, so x keeps its uncertainty.
+    TEST_ASSERT_LESS_THAN_FLOAT(
+        START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_X));
+}
+
+void test_update_moves_the_pose_towards_the_reading() {
+    int expectedDistance = facingBrick().position.y - BRICK_TOP_FACE;
+
+    // Reading further than expected means that the robot is higher up.
+    Pose correction;
+    TEST_ASSERT_TRUE(poseEstimator_P->update(
+        facingBrick(), Position(0, 0), 0, expectedDistance + 20,
+        READING_VARIANCE, &correction));
+
+    TEST_ASSERT_GREATER_THAN_FLOAT(10, correction.position.y);
+    TEST_ASSERT_LESS_THAN_FLOAT(20, correction.position.y);
+
+    // Applying the correction isn't movement, so the next prediction from the
+    // corrected pose adds nothing.
+    float correctedDeviation = poseEstimator_P->getAxisDeviation(POSE_AXIS_Y);
+
+    Pose correctedPose = facingBrick();
+    correctedPose.position.y += correction.position.y;
+    poseEstimator_P->predict(correctedPose);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001, correctedDeviation,
+                             poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+}
+
+void test_update_rejects_outliers() {
+    int expectedDistance = facingBrick().position.y - BRICK_TOP_FACE;
+
+    TEST_ASSERT_FALSE(poseEstimator_P->update(facingBrick(), Position(0, 0), 0,
+                                              expectedDistance + 200,
+                                              READING_VARIANCE, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(1, poseEstimator_P->getRejectedCount());
+
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+}
+
+void test_update_ignores_readings_that_cant_be_predicted() {
+    // Glancing off the top wall at 10°, too shallow to trust.
+    TEST_ASSERT_FALSE(poseEstimator_P->update(makePose(500, 1900, 10),
+                                              Position(0, 0), 0, 300,
+                                              READING_VARIANCE, nullptr));
+    TEST_ASSERT_FALSE(poseEstimator_P->update(facingBrick(), Position(0, 0), 0,
+                                              -1, READING_VARIANCE, nullptr));
+    TEST_ASSERT_EQUAL_UINT32(0, poseEstimator_P->getRejectedCount());
+}
+
+void test_reset_axis_keeps_the_other_axes() {
+    poseEstimator_P->resetAxis(facingBrick(), POSE_AXIS_Y, 5);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 5,
+                             poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_X));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, START_ANGLE_DEVIATION,
+                             poseEstimator_P->getAngleDeviation());
+}
+
+void test_repeated_snapping_doesnt_grow_the_uncertainty() {
+    // Snapping the angle and one axis against a wall over and over, as
+    // aligning does, must leave the free axis where it was.
+    for (int i = 0; i < 20; i++) {
+        poseEstimator_P->resetAxis(facingBrick(), POSE_AXIS_ANGLE, 1);
+        poseEstimator_P->resetAxis(facingBrick(), POSE_AXIS_Y, 10);
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(
+        0.001, START_POSITION_DEVIATION,
+        poseEstimator_P->getAxisDeviation(POSE_AXIS_X));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 10,
+                             poseEstimator_P->getAxisDeviation(POSE_AXIS_Y));
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1, poseEstimator_P->getAngleDeviation());
+}
+
+void test_accepted_corrections_arent_movement() {
+    // A heading correction from outside the filter moves the odometry, which
+    // mustn't be predicted as the robot turning.
+    poseEstimator_P->acceptCorrection(makePose(500, 400, -87));
+    poseEstimator_P->predict(makePose(500, 400, -87));
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001, START_ANGLE_DEVIATION,
+                             poseEstimator_P->getAngleDeviation());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_predict_without_movement_changes_nothing);
+    RUN_TEST(test_predict_driving_grows_the_position_uncertainty);
+    RUN_TEST(test_predict_turning_grows_the_angle_uncertainty);
+    RUN_TEST(test_update_with_expected_reading_shrinks_the_uncertainty);
+    RUN_TEST(test_update_moves_the_pose_towards_the_reading);
+    RUN_TEST(test_update_rejects_outliers);
+    RUN_TEST(test_update_ignores_readings_that_cant_be_predicted);
+    RUN_TEST(test_reset_axis_keeps_the_other_axes);
+    RUN_TEST(test_repeated_snapping_doesnt_grow_the_uncertainty);
+    RUN_TEST(test_accepted_corrections_arent_movement);
+    return UNITY_END();
+}